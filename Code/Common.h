@@ -32,50 +32,7 @@
 
 #include "main.h"
 
-enum
-{
-	E_LOG_LVL_NONE,
-	E_LOG_LVL_INFO,
-	E_LOG_LVL_ERROR,
-	E_LOG_LVL_WARNING,
-	E_LOG_LVL_DEBUG,
-	E_LOG_LVL_NEVER
-};
-
-/* Console color */
-#define RESET "\x1B[0m"
-#define KRED "\x1B[31m"
-#define KGRN "\x1B[32m"
-#define KYEL "\x1B[33m"
-#define KBLU "\x1B[34m"
-#define KMAG "\x1B[35m"
-#define KCYN "\x1B[36m"
-#define KWHT "\x1B[37m"
-/*Background colors*/
-#define BG_KOLORS_BLK "\x1b[40m" //Black
-#define BG_KOLORS_RED "\x1b[41m" //Red
-#define BG_KOLORS_GRN "\x1b[42m" //Green
-#define BG_KOLORS_YEL "\x1b[43m" //Yellow
-#define BG_KOLORS_BLU "\x1b[44m" //Blue
-
-#define LOG_SHOULD_I(level) (level <= LOG_BUILD_LEVEL && level <= E_LOG_LVL_DEBUG)
-#define LOG(level, tag, ...)                                       \
-	do                                                             \
-	{                                                              \
-		if (LOG_SHOULD_I(level))                                   \
-		{                                                          \
-			printf("[%s] %s:%d: " RESET, tag, __func__, __LINE__); \
-			printf(__VA_ARGS__);                                   \
-			printf("\r\n");                                        \
-		}                                                          \
-	} while (0)
-
-#define APP_LOGE(...) LOG(E_LOG_LVL_ERROR, KRED "ERROR" RESET, __VA_ARGS__)
-#define APP_LOGI(...) LOG(E_LOG_LVL_INFO, KGRN "INFOR" RESET, __VA_ARGS__)
-#define APP_LOGD(...) LOG(E_LOG_LVL_DEBUG, KYEL "DEBUG" RESET, __VA_ARGS__)
-#define APP_LOGW(...) LOG(E_LOG_LVL_WARNING, BG_KOLORS_YEL "ALARM" RESET, __VA_ARGS__)
-
-#define LOG_BUILD_LEVEL E_LOG_LVL_DEBUG
+#include "components/system/app_log.h"
 
 #define GPIO_USER_BOOT_BUTTON 0
 #define GPIO_USER_BUTTON 27
@@ -85,8 +42,12 @@ enum
 #define GPIO_USER_LED_RED 17
 #define GPIO_USER_LED_BLUE 4
 
+#define GPIO_IMU_INT1 26 // LSM6DSL INT1, impact (single tap) interrupt
+
 #define GPIO_OUTPUT_PIN_SEL ((1ULL << GPIO_USER_LED_GREEN) | (1ULL << GPIO_USER_LED_RED) | (1ULL << GPIO_USER_LED_BLUE))
 
+#define SENSOR_HIT_BANDS (4) // 0-25, 25-60, 60-120, 120-208 Hz
+
 typedef enum
 {
 	kHammer_None,
@@ -96,16 +57,40 @@ typedef enum
 typedef struct
 {
 	uint8_t vibration_level;
-	bool buttons_hold;
+	volatile bool buttons_hold; // buttonDown to buttonUp, read by imu_task and the impact interrupt
 	e_Hammer_detect hammer_detect;
-	bool vibration_active;
+	int16_t temperature; // IMU die temperature [0.01 degC]
+	uint16_t hit_peak_hz;                        // dominant frequency of the last hit, 0 when no spectrum
+	uint8_t hit_band_pct[SENSOR_HIT_BANDS];      // share of the hit energy per band [%]
+	int16_t hit_energy_db;                       // total hit energy [dB mg^2]
+	uint8_t strike_label;                        // strike_label_t of the last hit
+	int16_t swing_angle_deg;                     // swing arc up to the hit [deg]
+	int16_t impact_rate_dps;                     // peak angular rate of that swing [dps]
+	uint16_t trace_id;                           // latency trace event of the pending hit report
 } sensor_data_t;
 
+typedef struct
+{
+	uint16_t assoc_ms;     // esp_wifi_connect to associated, scan and WPA handshake included
+	uint16_t dhcp_ms;      // associated to IP address
+	uint16_t connack_ms;   // IP address to MQTT CONNACK, DNS, TCP and TLS included
+	uint16_t total_ms;
+	uint16_t handshake_ms; // last broker connect, TCP + TLS + CONNACK, also after a broker-only reconnect
+	uint16_t handshakes;   // broker connects since boot
+	bool fast;             // cached BSSID/channel, no scan
+	bool static_ip;
+} connect_timing_t;
+
 typedef struct
 {
 	bool wifi_status;
 	bool mqtt_status;
 	char mac_add[20];
+	bool diag_request; // publish the diagnostics report on the next mqtt poll
+	bool profile_request; // publish the task profile on the next mqtt poll
+	bool trace_request; // publish the latency trace ring on the next mqtt poll
+	bool strikes_request; // publish the raw strike ring on the next mqtt poll
+	connect_timing_t connect; // phases of the last connection that reached MQTT
 	sensor_data_t sensor;
 } deive_data_t;
 
@@ -0,0 +1,198 @@
+/*
+ * dsp_fft.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <string.h>
+#include "dsp_fft.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define DSP_FFT_M (DSP_FFT_N / 2) /* the real FFT runs as a complex FFT of half the size */
+
+#if DSP_FFT_N != 64
+#error "dsp_fft tables are generated for DSP_FFT_N = 64, regenerate them for another size"
+#endif
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+/* W_N^k = {cos(2 pi k / N), -sin(2 pi k / N)}, k = 0 .. N/2 - 1 */
+static const float fft_twiddle[DSP_FFT_M][2] = {
+    {1.000000000f, -0.000000000f}, {0.995184727f, -0.098017140f},
+    {0.980785280f, -0.195090322f}, {0.956940336f, -0.290284677f},
+    {0.923879533f, -0.382683432f}, {0.881921264f, -0.471396737f},
+    {0.831469612f, -0.555570233f}, {0.773010453f, -0.634393284f},
+    {0.707106781f, -0.707106781f}, {0.634393284f, -0.773010453f},
+    {0.555570233f, -0.831469612f}, {0.471396737f, -0.881921264f},
+    {0.382683432f, -0.923879533f}, {0.290284677f, -0.956940336f},
+    {0.195090322f, -0.980785280f}, {0.098017140f, -0.995184727f},
+    {0.000000000f, -1.000000000f}, {-0.098017140f, -0.995184727f},
+    {-0.195090322f, -0.980785280f}, {-0.290284677f, -0.956940336f},
+    {-0.382683432f, -0.923879533f}, {-0.471396737f, -0.881921264f},
+    {-0.555570233f, -0.831469612f}, {-0.634393284f, -0.773010453f},
+    {-0.707106781f, -0.707106781f}, {-0.773010453f, -0.634393284f},
+    {-0.831469612f, -0.555570233f}, {-0.881921264f, -0.471396737f},
+    {-0.923879533f, -0.382683432f}, {-0.956940336f, -0.290284677f},
+    {-0.980785280f, -0.195090322f}, {-0.995184727f, -0.098017140f},
+};
+
+/* Hann window, N points */
+static const float fft_window[DSP_FFT_N] = {
+    0.000000000f, 0.002484612f, 0.009913756f, 0.022213597f,
+    0.039261894f, 0.060889213f, 0.086880613f, 0.116977778f,
+    0.150881591f, 0.188255099f, 0.228726868f, 0.271894671f,
+    0.317329488f, 0.364579766f, 0.413175911f, 0.462634953f,
+    0.512465346f, 0.562171852f, 0.611260467f, 0.659243325f,
+    0.705643552f, 0.750000000f, 0.791871836f, 0.830842919f,
+    0.866525936f, 0.898566254f, 0.926645441f, 0.950484434f,
+    0.969846310f, 0.984538643f, 0.994415413f, 0.999378461f,
+    0.999378461f, 0.994415413f, 0.984538643f, 0.969846310f,
+    0.950484434f, 0.926645441f, 0.898566254f, 0.866525936f,
+    0.830842919f, 0.791871836f, 0.750000000f, 0.705643552f,
+    0.659243325f, 0.611260467f, 0.562171852f, 0.512465346f,
+    0.462634953f, 0.413175911f, 0.364579766f, 0.317329488f,
+    0.271894671f, 0.228726868f, 0.188255099f, 0.150881591f,
+    0.116977778f, 0.086880613f, 0.060889213f, 0.039261894f,
+    0.022213597f, 0.009913756f, 0.002484612f, 0.000000000f,
+};
+
+/* bit reversal permutation for the N/2 point complex FFT */
+static const uint8_t fft_bitrev[DSP_FFT_M] = {
+    0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26, 6, 22, 14, 30,
+    1, 17, 9, 25, 5, 21, 13, 29, 3, 19, 11, 27, 7, 23, 15, 31,
+};
+
+static const float fft_band_edges[DSP_FFT_BANDS - 1] = DSP_FFT_BAND_EDGES_HZ;
+
+/* work buffer, the spectrum stage never allocates */
+static float fft_re[DSP_FFT_M];
+static float fft_im[DSP_FFT_M];
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: dsp_fft_real_power
+* Description  : Hann windowed radix-2 real FFT, returns the one sided power spectrum. Not reentrant, the work buffer
+*                is shared.
+* Arguments    : in - DSP_FFT_N samples, power - DSP_FFT_BINS outputs
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_fft_real_power(const int32_t *in, float *power)
+{
+    uint16_t i, k, size, half, step, start;
+    uint16_t a, b;
+    float wr, wi, tr, ti;
+    float zr, zi, cr, ci, er, ei, or_, oi;
+
+    /* pack even samples in re, odd samples in im, already bit reversed */
+    for (i = 0; i < DSP_FFT_M; i++)
+    {
+        k = fft_bitrev[i];
+        fft_re[k] = (float)in[2 * i] * fft_window[2 * i];
+        fft_im[k] = (float)in[2 * i + 1] * fft_window[2 * i + 1];
+    }
+
+    /* iterative DIT butterflies, W_M^j = W_N^2j */
+    for (size = 2; size <= DSP_FFT_M; size <<= 1)
+    {
+        half = size >> 1;
+        step = (DSP_FFT_M / size) << 1;
+        for (start = 0; start < DSP_FFT_M; start += size)
+        {
+            for (k = 0; k < half; k++)
+            {
+                wr = fft_twiddle[k * step][0];
+                wi = fft_twiddle[k * step][1];
+                a = start + k;
+                b = a + half;
+                tr = wr * fft_re[b] - wi * fft_im[b];
+                ti = wr * fft_im[b] + wi * fft_re[b];
+                fft_re[b] = fft_re[a] - tr;
+                fft_im[b] = fft_im[a] - ti;
+                fft_re[a] += tr;
+                fft_im[a] += ti;
+            }
+        }
+    }
+
+    /* split the packed spectrum: X[k] = E[k] + W_N^k O[k] */
+    for (k = 0; k <= DSP_FFT_M; k++)
+    {
+        a = k % DSP_FFT_M;
+        b = (DSP_FFT_M - k) % DSP_FFT_M;
+        zr = fft_re[a];
+        zi = fft_im[a];
+        cr = fft_re[b];
+        ci = -fft_im[b];
+        er = 0.5f * (zr + cr);
+        ei = 0.5f * (zi + ci);
+        or_ = 0.5f * (zi - ci);
+        oi = -0.5f * (zr - cr);
+        if (k < DSP_FFT_M)
+        {
+            wr = fft_twiddle[k][0];
+            wi = fft_twiddle[k][1];
+        }
+        else
+        {
+            wr = -1.0f;
+            wi = 0.0f;
+        }
+        tr = er + wr * or_ - wi * oi;
+        ti = ei + wr * oi + wi * or_;
+        power[k] = tr * tr + ti * ti;
+    }
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_spectrum_features
+* Description  : band energies and dominant frequency of a power spectrum
+* Arguments    : power - DSP_FFT_BINS values, fs_hz - sample rate, out
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_spectrum_features(const float *power, float fs_hz, dsp_spectrum_t *out)
+{
+    float bin_hz = fs_hz / DSP_FFT_N;
+    float peak = 0.0f;
+    uint16_t peak_bin = 0;
+    uint16_t k, band = 0;
+
+    memset(out, 0x00, sizeof(dsp_spectrum_t));
+    for (k = 1; k < DSP_FFT_BINS; k++)
+    {
+        while ((band < DSP_FFT_BANDS - 1) && (k * bin_hz >= fft_band_edges[band]))
+            band++;
+        out->band_energy[band] += power[k];
+        out->total_energy += power[k];
+        if (power[k] > peak)
+        {
+            peak = power[k];
+            peak_bin = k;
+        }
+    }
+    out->peak_hz = peak_bin * bin_hz;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,49 @@
+/*
+ * dsp_fft.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef COMPONENTS_DSP_DSP_FFT_H_
+#define COMPONENTS_DSP_DSP_FFT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define DSP_FFT_N (64) /* real input length, the tables in dsp_fft.c are generated for this size */
+#define DSP_FFT_BINS (DSP_FFT_N / 2 + 1)
+#define DSP_FFT_BANDS (4)
+#define DSP_FFT_BAND_EDGES_HZ {25.0f, 60.0f, 120.0f} /* upper edge of every band but the last one */
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+	float band_energy[DSP_FFT_BANDS]; /* [mg^2] */
+	float total_energy;
+	float peak_hz; /* dominant frequency, DC excluded */
+} dsp_spectrum_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void dsp_fft_real_power(const int32_t *in, float *power);
+
+void dsp_spectrum_features(const float *power, float fs_hz, dsp_spectrum_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPONENTS_DSP_DSP_FFT_H_ */
@@ -0,0 +1,190 @@
+/*
+ * dsp_filter.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <math.h>
+#include "dsp_filter.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define DSP_PI (3.14159265358979f)
+#define DSP_Q14_ONE (1 << DSP_BIQUAD_Q)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: dsp_biquad_q14_highpass_init
+* Description  : RBJ cookbook high-pass, float is only used here, the filter itself is integer
+* Arguments    : bq, fc_hz - corner, fs_hz - sample rate, q - quality (0.707 for butterworth)
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_biquad_q14_highpass_init(dsp_biquad_q14_t *bq, float fc_hz, float fs_hz, float q)
+{
+    float w0 = 2.0f * DSP_PI * fc_hz / fs_hz;
+    float cs = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+
+    bq->b0 = (int32_t)lroundf(((1.0f + cs) / 2.0f) / a0 * DSP_Q14_ONE);
+    bq->b1 = (int32_t)lroundf((-(1.0f + cs)) / a0 * DSP_Q14_ONE);
+    bq->b2 = bq->b0;
+    bq->a1 = (int32_t)lroundf((-2.0f * cs) / a0 * DSP_Q14_ONE);
+    bq->a2 = (int32_t)lroundf((1.0f - alpha) / a0 * DSP_Q14_ONE);
+    dsp_biquad_q14_reset(bq, 0);
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_biquad_q14_reset
+* Description  : preload the history as if x had been applied forever, avoids the gravity step at start up
+* Arguments    : bq, x - steady input
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_biquad_q14_reset(dsp_biquad_q14_t *bq, int32_t x)
+{
+    bq->x1 = x;
+    bq->x2 = x;
+    bq->y1 = 0;
+    bq->y2 = 0;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_biquad_q14_process
+* Description  : filter one block, in and out may alias
+* Arguments    : bq, in, out, len
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_biquad_q14_process(dsp_biquad_q14_t *bq, const int32_t *in, int32_t *out, uint16_t len)
+{
+    int32_t x1 = bq->x1, x2 = bq->x2;
+    int32_t y1 = bq->y1, y2 = bq->y2;
+    int32_t x0, y0;
+    int64_t acc;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        x0 = in[i];
+        acc = (int64_t)bq->b0 * x0 + (int64_t)bq->b1 * x1 + (int64_t)bq->b2 * x2 - (int64_t)bq->a1 * y1 - (int64_t)bq->a2 * y2;
+        y0 = (int32_t)((acc + (1 << (DSP_BIQUAD_Q - 1))) >> DSP_BIQUAD_Q);
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        out[i] = y0;
+    }
+    bq->x1 = x1;
+    bq->x2 = x2;
+    bq->y1 = y1;
+    bq->y2 = y2;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_envelope_init
+* Description  :
+* Arguments    : env, attack_shift - small is fast, release_shift - time constant ~ 2^shift samples
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_envelope_init(dsp_envelope_t *env, uint8_t attack_shift, uint8_t release_shift)
+{
+    env->env = 0;
+    env->attack_shift = attack_shift;
+    env->release_shift = release_shift;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_envelope_process
+* Description  : rectify and smooth one block, out is in the input unit (not Q8)
+* Arguments    : env, in, out, len
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_envelope_process(dsp_envelope_t *env, const int32_t *in, int32_t *out, uint16_t len)
+{
+    int32_t e = env->env;
+    int32_t x;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        x = in[i];
+        x = ((x < 0) ? -x : x) << DSP_ENV_Q;
+        if (x > e)
+            e += (x - e) >> env->attack_shift;
+        else
+            e -= (e - x) >> env->release_shift;
+        out[i] = e >> DSP_ENV_Q;
+    }
+    env->env = e;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_noise_floor_init
+* Description  :
+* Arguments    : nf, initial - starting floor, shift - adaptation speed, ratio_q4 - threshold / floor in Q4,
+*                min_threshold - lower bound of the threshold
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_noise_floor_init(dsp_noise_floor_t *nf, int32_t initial, uint8_t shift, uint16_t ratio_q4, int32_t min_threshold)
+{
+    nf->floor = initial << DSP_ENV_Q;
+    nf->shift = shift;
+    nf->ratio_q4 = ratio_q4;
+    nf->min_threshold = min_threshold;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_noise_floor_process
+* Description  : track the background level of the envelope and derive the per-sample detection threshold.
+*                Samples above the current threshold are treated as events and do not move the floor.
+* Arguments    : nf, env - envelope block, threshold - output block, len
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_noise_floor_process(dsp_noise_floor_t *nf, const int32_t *env, int32_t *threshold, uint16_t len)
+{
+    int32_t f = nf->floor;
+    int32_t thr, x;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        thr = (int32_t)(((int64_t)f * nf->ratio_q4) >> (DSP_ENV_Q + 4));
+        if (thr < nf->min_threshold)
+            thr = nf->min_threshold;
+        x = env[i];
+        if (x < thr)
+        {
+            x <<= DSP_ENV_Q;
+            f += (x - f) >> nf->shift;
+        }
+        threshold[i] = thr;
+    }
+    nf->floor = f;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
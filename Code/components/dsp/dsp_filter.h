@@ -0,0 +1,83 @@
+/*
+ * dsp_filter.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef COMPONENTS_DSP_DSP_FILTER_H_
+#define COMPONENTS_DSP_DSP_FILTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+/* no esp/freertos dependency here, the dsp component also builds on the host */
+#include <stdint.h>
+#include <stdbool.h>
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define DSP_BIQUAD_Q (14) /* coefficient format */
+#define DSP_ENV_Q (8)     /* envelope / noise floor state format */
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/**
+ * Direct form I biquad, Q14 coefficients, a0 normalised to 1.
+ */
+typedef struct
+{
+	int32_t b0, b1, b2;
+	int32_t a1, a2;
+	int32_t x1, x2;
+	int32_t y1, y2;
+} dsp_biquad_q14_t;
+
+/**
+ * Rectifying one-pole envelope follower, attack / release given as shifts.
+ */
+typedef struct
+{
+	int32_t env; /* Q8 */
+	uint8_t attack_shift;
+	uint8_t release_shift;
+} dsp_envelope_t;
+
+/**
+ * Noise floor tracker, only learns while the envelope stays below the threshold.
+ */
+typedef struct
+{
+	int32_t floor;		  /* Q8 */
+	uint8_t shift;		  /* adaptation speed */
+	uint16_t ratio_q4;	  /* threshold = floor * ratio */
+	int32_t min_threshold; /* threshold never goes below this, same unit as the input */
+} dsp_noise_floor_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void dsp_biquad_q14_highpass_init(dsp_biquad_q14_t *bq, float fc_hz, float fs_hz, float q);
+
+void dsp_biquad_q14_reset(dsp_biquad_q14_t *bq, int32_t x);
+
+void dsp_biquad_q14_process(dsp_biquad_q14_t *bq, const int32_t *in, int32_t *out, uint16_t len);
+
+void dsp_envelope_init(dsp_envelope_t *env, uint8_t attack_shift, uint8_t release_shift);
+
+void dsp_envelope_process(dsp_envelope_t *env, const int32_t *in, int32_t *out, uint16_t len);
+
+void dsp_noise_floor_init(dsp_noise_floor_t *nf, int32_t initial, uint8_t shift, uint16_t ratio_q4, int32_t min_threshold);
+
+void dsp_noise_floor_process(dsp_noise_floor_t *nf, const int32_t *env, int32_t *threshold, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPONENTS_DSP_DSP_FILTER_H_ */
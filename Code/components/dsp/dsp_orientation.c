@@ -0,0 +1,129 @@
+/*
+ * dsp_orientation.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <math.h>
+#include "dsp_orientation.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define DSP_RAD_TO_DEG (57.29578f)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: dsp_mahony_init
+* Description  : identity orientation, the accel correction pulls it onto gravity within a few seconds
+* Arguments    : f, fs_hz - update rate, kp - proportional gain, ki - integral gain (0 disables bias estimation)
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_mahony_init(dsp_mahony_t *f, float fs_hz, float kp, float ki)
+{
+    f->q.w = 1.0f;
+    f->q.x = 0.0f;
+    f->q.y = 0.0f;
+    f->q.z = 0.0f;
+    f->kp = kp;
+    f->ki = ki;
+    f->ix = 0.0f;
+    f->iy = 0.0f;
+    f->iz = 0.0f;
+    f->half_dt = 0.5f / fs_hz;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_mahony_update
+* Description  : one filter step, single precision only so it stays on the FPU
+* Arguments    : f, gx..gz - angular rate [rad/s], ax..az - acceleration [g]
+* Return Value : none
+***********************************************************************************************************************/
+void dsp_mahony_update(dsp_mahony_t *f, float gx, float gy, float gz, float ax, float ay, float az)
+{
+    dsp_quat_t q = f->q;
+    float norm2 = ax * ax + ay * ay + az * az;
+    float recip, vx, vy, vz, ex, ey, ez;
+
+    // during the swing the accelerometer is not a gravity reference, integrate the gyro only
+    if ((norm2 > (1.0f - DSP_MAHONY_ACC_GATE) * (1.0f - DSP_MAHONY_ACC_GATE)) &&
+        (norm2 < (1.0f + DSP_MAHONY_ACC_GATE) * (1.0f + DSP_MAHONY_ACC_GATE)))
+    {
+        recip = 1.0f / sqrtf(norm2);
+        ax *= recip;
+        ay *= recip;
+        az *= recip;
+        // gravity as seen by the current estimate
+        vx = 2.0f * (q.x * q.z - q.w * q.y);
+        vy = 2.0f * (q.w * q.x + q.y * q.z);
+        vz = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+        ex = ay * vz - az * vy;
+        ey = az * vx - ax * vz;
+        ez = ax * vy - ay * vx;
+        if (f->ki > 0.0f)
+        {
+            f->ix += f->ki * ex * 2.0f * f->half_dt;
+            f->iy += f->ki * ey * 2.0f * f->half_dt;
+            f->iz += f->ki * ez * 2.0f * f->half_dt;
+        }
+        gx += f->kp * ex;
+        gy += f->kp * ey;
+        gz += f->kp * ez;
+    }
+    gx = (gx + f->ix) * f->half_dt;
+    gy = (gy + f->iy) * f->half_dt;
+    gz = (gz + f->iz) * f->half_dt;
+
+    f->q.w += -q.x * gx - q.y * gy - q.z * gz;
+    f->q.x += q.w * gx + q.y * gz - q.z * gy;
+    f->q.y += q.w * gy - q.x * gz + q.z * gx;
+    f->q.z += q.w * gz + q.x * gy - q.y * gx;
+
+    recip = 1.0f / sqrtf(f->q.w * f->q.w + f->q.x * f->q.x + f->q.y * f->q.y + f->q.z * f->q.z);
+    f->q.w *= recip;
+    f->q.x *= recip;
+    f->q.y *= recip;
+    f->q.z *= recip;
+}
+
+/***********************************************************************************************************************
+* Function Name: dsp_quat_angle_deg
+* Description  : rotation angle between two orientations
+* Arguments    : a, b - unit quaternions
+* Return Value : 0 .. 180 deg
+***********************************************************************************************************************/
+float dsp_quat_angle_deg(const dsp_quat_t *a, const dsp_quat_t *b)
+{
+    float dot = fabsf(a->w * b->w + a->x * b->x + a->y * b->y + a->z * b->z);
+
+    if (dot > 1.0f)
+        dot = 1.0f;
+    return 2.0f * acosf(dot) * DSP_RAD_TO_DEG;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
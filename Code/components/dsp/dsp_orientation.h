@@ -0,0 +1,58 @@
+/*
+ * dsp_orientation.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef COMPONENTS_DSP_DSP_ORIENTATION_H_
+#define COMPONENTS_DSP_DSP_ORIENTATION_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define DSP_MAHONY_ACC_GATE (0.2f) /* accel correction only while |a| is within 1 g +- 20 % */
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+	float w, x, y, z;
+} dsp_quat_t;
+
+/**
+ * Mahony complementary filter, fixed update rate.
+ */
+typedef struct
+{
+	dsp_quat_t q;
+	float kp;
+	float ki;
+	float ix, iy, iz; /* integral feedback, estimates the gyro bias */
+	float half_dt;
+} dsp_mahony_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void dsp_mahony_init(dsp_mahony_t *f, float fs_hz, float kp, float ki);
+
+void dsp_mahony_update(dsp_mahony_t *f, float gx, float gy, float gz, float ax, float ay, float az);
+
+float dsp_quat_angle_deg(const dsp_quat_t *a, const dsp_quat_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPONENTS_DSP_DSP_ORIENTATION_H_ */
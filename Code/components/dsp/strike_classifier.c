@@ -0,0 +1,175 @@
+/*
+ * strike_classifier.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "strike_classifier.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define STRIKE_CRC32_POLY (0xEDB88320)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static const char *const strike_label_names[STRIKE_LABEL_COUNT] = {
+    "unknown",
+    "solid",
+    "glancing",
+    "miss",
+    "drop",
+};
+
+static uint32_t strike_crc32(const uint8_t *data, size_t len);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: strike_model_parse
+* Description  : validate a model blob and point the model at it, the blob must stay in memory and be 2 byte aligned
+* Arguments    : blob, len, model
+* Return Value : true when the blob is usable
+***********************************************************************************************************************/
+bool strike_model_parse(const uint8_t *blob, size_t len, strike_model_t *model)
+{
+    const strike_model_header_t *header = (const strike_model_header_t *)blob;
+    size_t body;
+
+    if ((blob == NULL) || (len < sizeof(strike_model_header_t)))
+        return false;
+    if ((header->magic != STRIKE_MODEL_MAGIC) || (header->version != STRIKE_MODEL_VERSION) ||
+        (header->feature_count != STRIKE_FEATURE_COUNT))
+        return false;
+    body = header->node_count * sizeof(strike_node_t) + header->vector_count * sizeof(strike_vector_t);
+    if (len != sizeof(strike_model_header_t) + body)
+        return false;
+    if (strike_crc32(blob + sizeof(strike_model_header_t), body) != header->crc)
+        return false;
+
+    model->nodes = (const strike_node_t *)(blob + sizeof(strike_model_header_t));
+    model->node_count = header->node_count;
+    model->vectors = (const strike_vector_t *)(model->nodes + header->node_count);
+    model->vector_count = header->vector_count;
+    return strike_model_check(model);
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_model_check
+* Description  : structural check, children only point forward so a traversal ends within node_count steps
+* Arguments    : model
+* Return Value : true when the tree is well formed
+***********************************************************************************************************************/
+bool strike_model_check(const strike_model_t *model)
+{
+    uint16_t i;
+    const strike_node_t *node;
+
+    if ((model->nodes == NULL) || (model->node_count == 0))
+        return false;
+    for (i = 0; i < model->node_count; i++)
+    {
+        node = &model->nodes[i];
+        if (node->feature == STRIKE_NODE_LEAF)
+        {
+            if (node->left >= STRIKE_LABEL_COUNT)
+                return false;
+        }
+        else if ((node->feature < 0) || (node->feature >= STRIKE_FEATURE_COUNT) ||
+                 (node->left <= i) || (node->left >= model->node_count) ||
+                 (node->right <= i) || (node->right >= model->node_count))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_classify
+* Description  : walk the tree, bounded by the node count of a checked model
+* Arguments    : model, features - STRIKE_FEATURE_COUNT values
+* Return Value : label
+***********************************************************************************************************************/
+strike_label_t strike_classify(const strike_model_t *model, const int16_t *features)
+{
+    const strike_node_t *node = &model->nodes[0];
+    uint16_t steps;
+
+    for (steps = 0; steps < model->node_count; steps++)
+    {
+        if (node->feature == STRIKE_NODE_LEAF)
+            return (strike_label_t)node->left;
+        if (features[node->feature] <= node->threshold)
+            node = &model->nodes[node->left];
+        else
+            node = &model->nodes[node->right];
+    }
+    return STRIKE_LABEL_UNKNOWN;
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_model_verify
+* Description  : run the reference vectors shipped with the model and compare the labels
+* Arguments    : model
+* Return Value : number of mismatches
+***********************************************************************************************************************/
+uint16_t strike_model_verify(const strike_model_t *model)
+{
+    uint16_t i;
+    uint16_t mismatch = 0;
+
+    for (i = 0; i < model->vector_count; i++)
+    {
+        if (strike_classify(model, model->vectors[i].feature) != model->vectors[i].label)
+            mismatch++;
+    }
+    return mismatch;
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_label_name
+* Description  : label as published
+* Arguments    : label
+* Return Value : name
+***********************************************************************************************************************/
+const char *strike_label_name(strike_label_t label)
+{
+    if (label >= STRIKE_LABEL_COUNT)
+        label = STRIKE_LABEL_UNKNOWN;
+    return strike_label_names[label];
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+static uint32_t strike_crc32(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t bit;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (STRIKE_CRC32_POLY & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
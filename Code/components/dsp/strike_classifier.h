@@ -0,0 +1,120 @@
+/*
+ * strike_classifier.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef COMPONENTS_DSP_STRIKE_CLASSIFIER_H_
+#define COMPONENTS_DSP_STRIKE_CLASSIFIER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define STRIKE_MODEL_MAGIC (0x4B525453) /* "STRK" little endian */
+#define STRIKE_MODEL_VERSION (1)
+#define STRIKE_NODE_LEAF (-1) /* feature index of a leaf, the label is in left */
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+	STRIKE_FEAT_PEAK_MG,     /* envelope peak after the trigger [mg] */
+	STRIKE_FEAT_RINGDOWN_MS, /* time the envelope stays above half the peak [ms] */
+	STRIKE_FEAT_FREEFALL_MS, /* low-g run ending right before the trigger [ms] */
+	STRIKE_FEAT_PEAK_HZ,     /* dominant frequency, 0 without the spectrum stage */
+	STRIKE_FEAT_ENERGY_DB,
+	STRIKE_FEAT_BAND0_PCT,
+	STRIKE_FEAT_BAND1_PCT,
+	STRIKE_FEAT_BAND2_PCT,
+	STRIKE_FEAT_BAND3_PCT,
+	STRIKE_FEAT_SWING_DEG,   /* swing arc from the last still orientation to the trigger [deg] */
+	STRIKE_FEAT_RATE_DPS,    /* peak angular rate of the swing [dps] */
+	STRIKE_FEATURE_COUNT
+} strike_feature_t;
+
+typedef enum
+{
+	STRIKE_LABEL_UNKNOWN,
+	STRIKE_LABEL_SOLID,
+	STRIKE_LABEL_GLANCING,
+	STRIKE_LABEL_MISS,
+	STRIKE_LABEL_DROP,
+	STRIKE_LABEL_COUNT
+} strike_label_t;
+
+/**
+ * Decision tree node: go left when features[feature] <= threshold.
+ */
+typedef struct
+{
+	int16_t threshold;
+	int8_t feature; /* STRIKE_NODE_LEAF for a leaf */
+	uint8_t left;   /* node index, or the label of a leaf */
+	uint8_t right;
+	uint8_t reserved;
+} strike_node_t;
+
+/**
+ * Reference strike and the label the trainer predicted for it, tools/strike_model_export.py writes them.
+ */
+typedef struct
+{
+	int16_t feature[STRIKE_FEATURE_COUNT];
+	uint8_t label;
+	uint8_t reserved;
+} strike_vector_t;
+
+/**
+ * Model blob layout, little endian:
+ * header | nodes[node_count] | vectors[vector_count]
+ * crc is the CRC-32 (IEEE) of everything after the header.
+ */
+typedef struct
+{
+	uint32_t magic;
+	uint8_t version;
+	uint8_t feature_count;
+	uint16_t node_count;
+	uint16_t vector_count;
+	uint16_t reserved;
+	uint32_t crc;
+} strike_model_header_t;
+
+typedef struct
+{
+	const strike_node_t *nodes;
+	uint16_t node_count;
+	const strike_vector_t *vectors;
+	uint16_t vector_count;
+} strike_model_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+bool strike_model_parse(const uint8_t *blob, size_t len, strike_model_t *model);
+
+bool strike_model_check(const strike_model_t *model);
+
+strike_label_t strike_classify(const strike_model_t *model, const int16_t *features);
+
+uint16_t strike_model_verify(const strike_model_t *model);
+
+const char *strike_label_name(strike_label_t label);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPONENTS_DSP_STRIKE_CLASSIFIER_H_ */
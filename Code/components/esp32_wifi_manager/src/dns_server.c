@@ -59,7 +59,7 @@ int socket_fd;
 
 void dns_server_start() {
 	if(task_dns_server == NULL){
-		xTaskCreate(&dns_server, "dns_server", 3072, NULL, WIFI_MANAGER_TASK_PRIORITY-1, &task_dns_server);
+		xTaskCreatePinnedToCore(&dns_server, "dns_server", 3072, NULL, WIFI_MANAGER_TASK_PRIORITY-1, &task_dns_server, WIFI_MANAGER_TASK_CORE);
 	}
 }
 
@@ -46,6 +46,7 @@ Contains the freeRTOS task and all necessary support
 #include "esp_netif.h"
 #include "esp_wifi_types.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs.h"
 #include "nvs_flash.h"
 #include "mdns.h"
@@ -97,6 +98,23 @@ static esp_netif_t* esp_netif_sta = NULL;
 /* @brief netif object for the ACCESS POINT */
 static esp_netif_t* esp_netif_ap = NULL;
 
+/* @brief one-shot access point hint for the next connection attempt, see wifi_manager_set_sta_hint */
+static bool sta_hint_valid = false;
+static uint8_t sta_hint_bssid[6];
+static uint8_t sta_hint_channel = 0;
+static bool sta_hint_used = false;
+
+/* @brief access point of the last successful connection, persisted under "ap_cache" */
+typedef struct{
+	uint8_t ssid[MAX_SSID_SIZE];
+	uint8_t bssid[6];
+	uint8_t channel;
+}wifi_manager_ap_cache_t;
+static wifi_manager_ap_cache_t ap_cache;
+
+/* @brief timestamps of the current connection attempt */
+static wifi_manager_connect_timing_t connect_timing;
+
 /**
  * The actual WiFi settings in use
  */
@@ -209,7 +227,7 @@ void wifi_manager_start(){
 	wifi_manager_shutdown_ap_timer = xTimerCreate( NULL, pdMS_TO_TICKS(WIFI_MANAGER_SHUTDOWN_AP_TIMER), pdFALSE, ( void * ) 0, wifi_manager_timer_shutdown_ap_cb);
 
 	/* start wifi manager task */
-	xTaskCreate(&wifi_manager, "wifi_manager", 4096, NULL, WIFI_MANAGER_TASK_PRIORITY, &task_wifi_manager);
+	xTaskCreatePinnedToCore(&wifi_manager, "wifi_manager", 4096, NULL, WIFI_MANAGER_TASK_PRIORITY, &task_wifi_manager, WIFI_MANAGER_TASK_CORE);
 }
 
 esp_err_t wifi_manager_save_sta_config(){
@@ -272,6 +290,8 @@ esp_err_t wifi_manager_save_sta_config(){
 				tmp_settings.ap_bandwidth != wifi_settings.ap_bandwidth ||
 				tmp_settings.sta_only != wifi_settings.sta_only ||
 				tmp_settings.sta_power_save != wifi_settings.sta_power_save ||
+				tmp_settings.sta_static_ip != wifi_settings.sta_static_ip ||
+				memcmp(&tmp_settings.sta_static_ip_config, &wifi_settings.sta_static_ip_config, sizeof(esp_netif_ip_info_t)) != 0 ||
 				tmp_settings.ap_channel != wifi_settings.ap_channel
 				)
 		){
@@ -389,6 +409,89 @@ bool wifi_manager_fetch_wifi_sta_config(){
 
 }
 
+/**
+ * @brief use the access point of the last successful connection for the restore attempt, unless the application
+ * already set a hint. The cache is dropped when it belongs to another SSID.
+ */
+static void wifi_manager_load_ap_cache(){
+
+	nvs_handle handle;
+	size_t sz = sizeof(ap_cache);
+
+	if(sta_hint_valid || !nvs_sync_lock( portMAX_DELAY )) return;
+
+	if(nvs_open(wifi_manager_nvs_namespace, NVS_READONLY, &handle) == ESP_OK){
+		if(nvs_get_blob(handle, "ap_cache", &ap_cache, &sz) != ESP_OK || sz != sizeof(ap_cache)){
+			memset(&ap_cache, 0x00, sizeof(ap_cache));
+		}
+		nvs_close(handle);
+	}
+	nvs_sync_unlock();
+
+	if(ap_cache.channel != 0 && strncmp((char*)ap_cache.ssid, (char*)wifi_manager_config_sta->sta.ssid, MAX_SSID_SIZE) == 0){
+		ESP_LOGI(TAG, "cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %d", ap_cache.bssid[0], ap_cache.bssid[1],
+				ap_cache.bssid[2], ap_cache.bssid[3], ap_cache.bssid[4], ap_cache.bssid[5], ap_cache.channel);
+		wifi_manager_set_sta_hint(ap_cache.bssid, ap_cache.channel);
+	}
+}
+
+/**
+ * @brief persist the access point we are connected to. Written only when it changed, roaming between access points
+ * of a site costs one small NVS write per change.
+ */
+static void wifi_manager_save_ap_cache(){
+
+	nvs_handle handle;
+	wifi_ap_record_t ap;
+
+	if(esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+
+	if(memcmp(ap_cache.bssid, ap.bssid, sizeof(ap_cache.bssid)) == 0 && ap_cache.channel == ap.primary &&
+			strncmp((char*)ap_cache.ssid, (char*)wifi_manager_config_sta->sta.ssid, MAX_SSID_SIZE) == 0){
+		return;
+	}
+	memcpy(ap_cache.ssid, wifi_manager_config_sta->sta.ssid, MAX_SSID_SIZE);
+	memcpy(ap_cache.bssid, ap.bssid, sizeof(ap_cache.bssid));
+	ap_cache.channel = ap.primary;
+
+	if(nvs_sync_lock( portMAX_DELAY )){
+		if(nvs_open(wifi_manager_nvs_namespace, NVS_READWRITE, &handle) == ESP_OK){
+			if(nvs_set_blob(handle, "ap_cache", &ap_cache, sizeof(ap_cache)) == ESP_OK){
+				nvs_commit(handle);
+			}
+			nvs_close(handle);
+		}
+		nvs_sync_unlock();
+	}
+}
+
+/**
+ * @brief static address from wifi_settings or the DHCP client. Applied while the link is down, esp_netif posts the
+ * GOT_IP event for a static address as soon as the station is connected.
+ */
+static void wifi_manager_apply_sta_ip(){
+
+	esp_netif_dhcp_status_t status;
+	esp_netif_dns_info_t dns;
+
+	esp_netif_dhcpc_get_status(esp_netif_sta, &status);
+	if(wifi_settings.sta_static_ip && wifi_settings.sta_static_ip_config.ip.addr != 0){
+		if(status != ESP_NETIF_DHCP_STOPPED){
+			esp_netif_dhcpc_stop(esp_netif_sta);
+		}
+		esp_netif_set_ip_info(esp_netif_sta, &wifi_settings.sta_static_ip_config);
+
+		/* no DHCP means no DNS option: the gateway is asked */
+		memset(&dns, 0x00, sizeof(dns));
+		dns.ip.type = ESP_IPADDR_TYPE_V4;
+		dns.ip.u_addr.ip4.addr = wifi_settings.sta_static_ip_config.gw.addr;
+		esp_netif_set_dns_info(esp_netif_sta, ESP_NETIF_DNS_MAIN, &dns);
+	}
+	else if(status == ESP_NETIF_DHCP_STOPPED){
+		esp_netif_dhcpc_start(esp_netif_sta);
+	}
+}
+
 
 void wifi_manager_clear_ip_info_json(){
 	strcpy(ip_info_json, "{}\n");
@@ -604,6 +707,7 @@ static void wifi_manager_event_handler(void* arg, esp_event_base_t event_base, i
 		 * the application is LwIP-based, then you need to wait until the got ip event comes in. */
 		case WIFI_EVENT_STA_CONNECTED:
 			ESP_LOGI(TAG, "WIFI_EVENT_STA_CONNECTED");
+			if(connect_timing.connected_us == 0) connect_timing.connected_us = esp_timer_get_time();
 			break;
 
 		/* This event can be generated in the following scenarios:
@@ -722,6 +826,7 @@ static void wifi_manager_event_handler(void* arg, esp_event_base_t event_base, i
 		 * the application when the IPV4 changes to a valid one. */
 		case IP_EVENT_STA_GOT_IP:
 			ESP_LOGI(TAG, "IP_EVENT_STA_GOT_IP");
+			if(connect_timing.got_ip_us == 0) connect_timing.got_ip_us = esp_timer_get_time();
 	        xEventGroupSetBits(wifi_manager_event_group, WIFI_MANAGER_WIFI_CONNECTED_BIT);
 	        ip_event_got_ip_t* ip_event_got_ip = (ip_event_got_ip_t*)malloc(sizeof(ip_event_got_ip_t));
 			*ip_event_got_ip =  *( (ip_event_got_ip_t*)event_data );
@@ -873,6 +978,28 @@ BaseType_t wifi_manager_send_message(message_code_t code, void *param){
 }
 
 
+void wifi_manager_set_sta_static_ip(const esp_netif_ip_info_t *ip_info){
+	if(ip_info){
+		wifi_settings.sta_static_ip_config = *ip_info;
+		wifi_settings.sta_static_ip = true;
+	}
+	else{
+		memset(&wifi_settings.sta_static_ip_config, 0x00, sizeof(esp_netif_ip_info_t));
+		wifi_settings.sta_static_ip = false;
+	}
+	wifi_manager_save_sta_config();
+}
+
+void wifi_manager_get_connect_timing(wifi_manager_connect_timing_t *timing){
+	*timing = connect_timing;
+}
+
+void wifi_manager_set_sta_hint(const uint8_t *bssid, uint8_t channel){
+	memcpy(sta_hint_bssid, bssid, sizeof(sta_hint_bssid));
+	sta_hint_channel = channel;
+	sta_hint_valid = true;
+}
+
 void wifi_manager_set_callback(message_code_t message_code, void (*func_ptr)(void*) ){
 
 	if(cb_ptr_arr && message_code < WM_MESSAGE_CODE_COUNT){
@@ -1029,6 +1156,7 @@ void wifi_manager( void * pvParameters ){
 				ESP_LOGI(TAG, "MESSAGE: ORDER_LOAD_AND_RESTORE_STA");
 				if(wifi_manager_fetch_wifi_sta_config()){
 					ESP_LOGI(TAG, "Saved wifi found on startup. Will attempt to connect.");
+					wifi_manager_load_ap_cache();
 					wifi_manager_send_message(WM_ORDER_CONNECT_STA, (void*)CONNECTION_REQUEST_RESTORE_CONNECTION);
 				}
 				else{
@@ -1059,6 +1187,22 @@ void wifi_manager( void * pvParameters ){
 				uxBits = xEventGroupGetBits(wifi_manager_event_group);
 				if( ! (uxBits & WIFI_MANAGER_WIFI_CONNECTED_BIT) ){
 					/* update config to latest and attempt connection */
+					wifi_manager_get_wifi_sta_config()->sta.listen_interval = DEFAULT_STA_LISTEN_INTERVAL;
+
+					/* the hint skips the all-channel scan once, a failed attempt falls back to a full scan */
+					if(sta_hint_valid){
+						memcpy(wifi_manager_get_wifi_sta_config()->sta.bssid, sta_hint_bssid, sizeof(sta_hint_bssid));
+						wifi_manager_get_wifi_sta_config()->sta.bssid_set = true;
+						wifi_manager_get_wifi_sta_config()->sta.channel = sta_hint_channel;
+						sta_hint_valid = false;
+						sta_hint_used = true;
+					}
+					else{
+						wifi_manager_get_wifi_sta_config()->sta.bssid_set = false;
+						wifi_manager_get_wifi_sta_config()->sta.channel = 0;
+						sta_hint_used = false;
+					}
+					wifi_manager_apply_sta_ip();
 					ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA, wifi_manager_get_wifi_sta_config()));
 
 					/* if there is a wifi scan in progress abort it first
@@ -1066,6 +1210,10 @@ void wifi_manager( void * pvParameters ){
 					if(uxBits & WIFI_MANAGER_SCAN_BIT){
 						esp_wifi_scan_stop();
 					}
+					memset(&connect_timing, 0x00, sizeof(connect_timing));
+					connect_timing.fast = sta_hint_used;
+					connect_timing.static_ip = wifi_settings.sta_static_ip;
+					connect_timing.connect_us = esp_timer_get_time();
 					ESP_ERROR_CHECK(esp_wifi_connect());
 				}
 
@@ -1263,6 +1411,9 @@ void wifi_manager( void * pvParameters ){
 				/* save IP as a string for the HTTP server host */
 				wifi_manager_safe_update_sta_ip_string(ip_event_got_ip->ip_info.ip.addr);
 
+				/* remember the access point for a scan-less connection on the next boot */
+				wifi_manager_save_ap_cache();
+
 				/* save wifi config in NVS if it wasn't a restored of a connection */
 				if(uxBits & WIFI_MANAGER_REQUEST_RESTORE_STA_BIT){
 					xEventGroupClearBits(wifi_manager_event_group, WIFI_MANAGER_REQUEST_RESTORE_STA_BIT);
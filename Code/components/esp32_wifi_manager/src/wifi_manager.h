@@ -91,6 +91,11 @@ extern "C" {
  */
 #define WIFI_MANAGER_TASK_PRIORITY			CONFIG_WIFI_MANAGER_TASK_PRIORITY
 
+/** @brief Core the manager and its sub-tasks (dns server, http server) are pinned to.
+ *  Kept on the Wi-Fi core so the application core is not preempted by provisioning traffic.
+ */
+#define WIFI_MANAGER_TASK_CORE				0
+
 /** @brief Defines the auth mode as an access point
  *  Value must be of type wifi_auth_mode_t
  *  @see esp_wifi_types.h
@@ -157,7 +162,13 @@ extern "C" {
  *  Value: WIFI_PS_MODEM for power save (wifi modem sleep periodically)
  *  Note: Power save is only effective when in STA only mode
  */
-#define DEFAULT_STA_POWER_SAVE 				WIFI_PS_NONE
+#define DEFAULT_STA_POWER_SAVE 				WIFI_PS_MAX_MODEM
+
+/** @brief Beacon intervals the station sleeps through with WIFI_PS_MAX_MODEM.
+ *  3 x 102.4 ms bounds downlink latency to ~300 ms, the MQTT keepalive (120 s) is far longer so pings
+ *  never force extra wake-ups.
+ */
+#define DEFAULT_STA_LISTEN_INTERVAL			3
 
 /**
  * @brief Defines the maximum length in bytes of a JSON representation of an access point.
@@ -257,6 +268,18 @@ struct wifi_settings_t{
 };
 extern struct wifi_settings_t wifi_settings;
 
+/**
+ * @brief esp_timer timestamps of the last connection attempt, 0 until the phase is reached.
+ * connect to connected covers scan, 802.11 authentication, association and the WPA handshake.
+ */
+typedef struct{
+	int64_t connect_us;
+	int64_t connected_us;
+	int64_t got_ip_us;
+	bool fast;			/* connected straight to a cached or hinted BSSID/channel */
+	bool static_ip;
+}wifi_manager_connect_timing_t;
+
 
 /**
  * @brief Structure used to store one message in the queue.
@@ -401,6 +424,24 @@ char* wifi_manager_get_sta_ip_string();
 void wifi_manager_safe_update_sta_ip_string(uint32_t ip);
 
 
+/**
+ * @brief Use a static address on the next connection, NULL goes back to DHCP. Saved with the STA settings.
+ * DNS queries go to the gateway.
+ */
+void wifi_manager_set_sta_static_ip(const esp_netif_ip_info_t *ip_info);
+
+/**
+ * @brief Phase timestamps of the last connection attempt.
+ */
+void wifi_manager_get_connect_timing(wifi_manager_connect_timing_t *timing);
+
+/**
+ * @brief Connect the next attempt straight to this BSSID on this channel instead of scanning.
+ * Used on a wake from standby; the hint is dropped after one attempt. Call before wifi_manager_start.
+ */
+void wifi_manager_set_sta_hint(const uint8_t *bssid, uint8_t channel);
+
+
 /**
  * @brief Register a callback to a custom function when specific event message_code happens.
  */
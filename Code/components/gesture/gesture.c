@@ -0,0 +1,114 @@
+/*
+ * gesture.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <string.h>
+#include "gesture.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: gesture_init
+* Description  : bind a grammar, load its default windows, start in state 0
+* Arguments    : engine, grammar
+* Return Value : false when the grammar has more windows than the engine holds
+***********************************************************************************************************************/
+bool gesture_init(gesture_engine_t *engine, const gesture_grammar_t *grammar)
+{
+    if (grammar->window_count > GESTURE_MAX_WINDOWS)
+        return false;
+    memset(engine, 0x00, sizeof(gesture_engine_t));
+    engine->grammar = grammar;
+    memcpy(engine->window_ms, grammar->default_window_ms, grammar->window_count * sizeof(uint16_t));
+    return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: gesture_set_window
+* Description  : retune an ambiguity window at runtime, applies from the next edge
+* Arguments    : engine, window - index, ms
+* Return Value : false for an unknown window
+***********************************************************************************************************************/
+bool gesture_set_window(gesture_engine_t *engine, uint8_t window, uint16_t ms)
+{
+    if (window >= engine->grammar->window_count)
+        return false;
+    engine->window_ms[window] = ms;
+    return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: gesture_feed
+* Description  : one table lookup per edge
+* Arguments    : engine, input, now_ms - edge timestamp
+* Return Value : gesture id, GESTURE_NONE when the edge completes nothing
+***********************************************************************************************************************/
+uint8_t gesture_feed(gesture_engine_t *engine, gesture_input_t input, uint32_t now_ms)
+{
+    const gesture_cell_t *cell = &engine->grammar->cells[engine->state][input];
+    uint8_t next = cell->next_late;
+    uint8_t emit = cell->emit_late;
+
+    if ((cell->window != GESTURE_WINDOW_NONE) && (now_ms - engine->entered_ms < engine->window_ms[cell->window]))
+    {
+        next = cell->next_early;
+        emit = cell->emit_early;
+    }
+    if (next == GESTURE_STAY)
+        return GESTURE_NONE;
+    engine->state = next;
+    engine->entered_ms = now_ms;
+    return emit;
+}
+
+/***********************************************************************************************************************
+* Function Name: gesture_poll
+* Description  : turn an expired state timeout into a TIMEOUT input, stamped at the deadline rather than at the poll
+* Arguments    : engine, now_ms
+* Return Value : gesture id, GESTURE_NONE when nothing expired
+***********************************************************************************************************************/
+uint8_t gesture_poll(gesture_engine_t *engine, uint32_t now_ms)
+{
+    uint8_t window = engine->grammar->timeout[engine->state];
+    uint32_t deadline;
+
+    if (window == GESTURE_WINDOW_NONE)
+        return GESTURE_NONE;
+    deadline = engine->entered_ms + engine->window_ms[window];
+    if ((int32_t)(now_ms - deadline) < 0)
+        return GESTURE_NONE;
+    return gesture_feed(engine, GESTURE_INPUT_TIMEOUT, deadline);
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,85 @@
+/*
+ * gesture.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef COMPONENTS_GESTURE_GESTURE_H_
+#define COMPONENTS_GESTURE_GESTURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+/* no esp/freertos dependency here, recorded edge logs can be replayed on the host */
+#include <stdint.h>
+#include <stdbool.h>
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define GESTURE_MAX_WINDOWS (8)
+#define GESTURE_WINDOW_NONE (0xFF) /* no timing constraint / no timeout */
+#define GESTURE_STAY (0xFF)        /* input ignored in this state */
+#define GESTURE_NONE (0)           /* nothing emitted */
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+	GESTURE_INPUT_PRESS,
+	GESTURE_INPUT_RELEASE,
+	GESTURE_INPUT_TIMEOUT, /* the state's timeout window ran out without an edge */
+	GESTURE_INPUT_COUNT
+} gesture_input_t;
+
+/**
+ * What an input does in a state. With a window the time spent in the state picks the early (< window) or the late
+ * (>= window) branch, without one the late branch is always taken.
+ */
+typedef struct
+{
+	uint8_t window;
+	uint8_t next_early;
+	uint8_t emit_early;
+	uint8_t next_late;
+	uint8_t emit_late;
+} gesture_cell_t;
+
+typedef struct
+{
+	const gesture_cell_t (*cells)[GESTURE_INPUT_COUNT]; /* [state][input] */
+	const uint8_t *timeout;                              /* [state] window index or GESTURE_WINDOW_NONE */
+	uint8_t state_count;
+	const uint16_t *default_window_ms;
+	uint8_t window_count;
+} gesture_grammar_t;
+
+typedef struct
+{
+	const gesture_grammar_t *grammar;
+	uint16_t window_ms[GESTURE_MAX_WINDOWS];
+	uint8_t state;
+	uint32_t entered_ms;
+} gesture_engine_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+bool gesture_init(gesture_engine_t *engine, const gesture_grammar_t *grammar);
+
+bool gesture_set_window(gesture_engine_t *engine, uint8_t window, uint16_t ms);
+
+uint8_t gesture_feed(gesture_engine_t *engine, gesture_input_t input, uint32_t now_ms);
+
+uint8_t gesture_poll(gesture_engine_t *engine, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPONENTS_GESTURE_GESTURE_H_ */
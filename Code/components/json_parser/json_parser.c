@@ -8,7 +8,7 @@
 /***********************************************************************************************************************
  * Pragma directive
  ***********************************************************************************************************************/
-
+#define APP_LOG_MODULE LOG_MODULE_JSON
 /***********************************************************************************************************************
  * Includes <System Includes>
  ***********************************************************************************************************************/
@@ -18,6 +18,22 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "../../Common.h"
+#include "../dsp/strike_classifier.h"
+#include "../user_driver/haptic.h"
+#include "../user_driver/button_gestures.h"
+#include "../system/task_profiler.h"
+#include "../system/mem_pool.h"
+#include "../system/mem_report.h"
+#include "../system/trace.h"
+#include "../system/task_registry.h"
+#include "../system/power.h"
+#include "../system/standby.h"
+#include "../system/prov_store.h"
+#include "../system/outbox.h"
+#include "../system/metrics.h"
+#include "shadow.h"
+#include "../task/job_task.h"
+#include "../esp32_wifi_manager/src/wifi_manager.h"
 // #include "../Interface/Logger_File/logger_file.h"
 /***********************************************************************************************************************
  * Macro definitions
@@ -32,14 +48,41 @@
  ***********************************************************************************************************************/
 #define TYPE_COMMAND_SETTING "setting"
 #define TYPE_COMMAND_RESTART "restart"
+#define TYPE_COMMAND_HAPTIC "haptic"
+#define TYPE_COMMAND_DIAGNOSTICS "diagnostics"
+#define TYPE_COMMAND_GESTURE_WINDOW "gesture_window"
+#define TYPE_COMMAND_PROFILE "profile"
+#define TYPE_COMMAND_TRACE "trace"
+#define TYPE_COMMAND_LOG_LEVEL "log_level"
+#define TYPE_COMMAND_STANDBY "standby"
+#define TYPE_COMMAND_STATIC_IP "static_ip"
+#define TYPE_COMMAND_OUTBOX "outbox"
+#define TYPE_COMMAND_METRICS "metrics"
+#define TYPE_COMMAND_STRIKES "strikes"
 /***********************************************************************************************************************
  * Exported global variables and functions (to be accessed by other files)
  ***********************************************************************************************************************/
+MEM_POOL_DEFINE(json_msg_pool, JSON_MESSAGE_LEN, JSON_MESSAGE_POOL_BLOCKS);
+MEM_POOL_DEFINE(json_report_pool, JSON_PROFILE_MESSAGE_LEN, 1);
+
 extern void flash_save_data(void);
 /***********************************************************************************************************************
  * Imported global variables and functions (from other files)
  ***********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function Name: json_parser_init
+ * Description  : message buffers come from fixed pools instead of malloc per publish
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+void json_parser_init(void)
+{
+    mem_pool_init(&json_msg_pool);
+    mem_pool_init(&json_report_pool);
+    shadow_init();
+}
+
 /***********************************************************************************************************************
  * Function Name:
  * Description  :
@@ -55,19 +98,19 @@ bool json_parser_job(const char *message, uint16_t length)
     cJSON *jOperation = cJSON_GetObjectItem(root2, "operation");
     cJSON *jId = cJSON_GetObjectItem(root2, "id");
     cJSON *value;
-    char *operation = (char *)malloc(20 * sizeof(char));
-    memset(operation, 0x00, 20 * sizeof(char));
-    char *_id = (char *)malloc(20 * sizeof(char));
-    memset(_id, 0x00, sizeof(char));
-    if (jId)
+    const char *operation;
+    const char *_id = deive_data.mac_add;
+    // both point into root2 and are valid until it is deleted. The topic already addresses this device, an "id" is
+    // optional and only has to match.
+    if (cJSON_IsString(jId))
     {
-        _id = cJSON_GetObjectItem(root2, "id")->valuestring;
+        _id = jId->valuestring;
     }
     if (strcmp(_id, deive_data.mac_add) == 0)
     {
-        if (jOperation)
+        if (cJSON_IsString(jOperation))
         {
-            operation = cJSON_GetObjectItem(root2, "operation")->valuestring;
+            operation = jOperation->valuestring;
             if ((strcmp(operation, TYPE_COMMAND_SETTING) == 0))
             {
                 value = cJSON_GetObjectItem(root2, "value");
@@ -76,6 +119,7 @@ bool json_parser_job(const char *message, uint16_t length)
                     // if (cJSON_GetObjectItem(root2, "value")->valueint != 0)
                     deive_data.sensor.vibration_level = cJSON_GetObjectItem(root2, "value")->valueint;
                     APP_LOGI("vibration control = %d", deive_data.sensor.vibration_level);
+                    shadow_changed();
                 }
                 else
                 {
@@ -83,9 +127,163 @@ bool json_parser_job(const char *message, uint16_t length)
                     status = false;
                 }
             }
+            else if ((strcmp(operation, TYPE_COMMAND_HAPTIC) == 0))
+            {
+                // {"operation": "haptic", "value": "double"} plays now, with "event": "hit" it remaps the event
+                value = cJSON_GetObjectItem(root2, "value");
+                haptic_pattern_t pattern = haptic_pattern_from_name(cJSON_IsString(value) ? value->valuestring : NULL);
+                cJSON *jEvent = cJSON_GetObjectItem(root2, "event");
+                if (pattern == HAPTIC_PATTERN_COUNT)
+                {
+                    APP_LOGD("unknow haptic pattern");
+                    status = false;
+                }
+                else if (cJSON_IsString(jEvent))
+                {
+                    haptic_event_t event = haptic_event_from_name(jEvent->valuestring);
+                    if (event == HAPTIC_EVENT_COUNT)
+                    {
+                        APP_LOGD("unknow haptic event");
+                        status = false;
+                    }
+                    else
+                    {
+                        haptic_set_event_pattern(event, pattern);
+                        shadow_changed();
+                        APP_LOGI("haptic %s -> %s", jEvent->valuestring, value->valuestring);
+                    }
+                }
+                else
+                {
+                    haptic_play(pattern);
+                }
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_GESTURE_WINDOW) == 0))
+            {
+                // {"operation": "gesture_window", "name": "reverse", "value": 700}
+                value = cJSON_GetObjectItem(root2, "value");
+                cJSON *jName = cJSON_GetObjectItem(root2, "name");
+                if (!cJSON_IsNumber(value) || (value->valueint <= 0) || (value->valueint > UINT16_MAX) ||
+                    !button_gestures_set_window(cJSON_IsString(jName) ? jName->valuestring : NULL, value->valueint))
+                {
+                    APP_LOGD("unknow gesture window");
+                    status = false;
+                }
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_LOG_LEVEL) == 0))
+            {
+                // {"operation": "log_level", "module": "mqtt", "value": "debug"}
+                value = cJSON_GetObjectItem(root2, "value");
+                cJSON *jModule = cJSON_GetObjectItem(root2, "module");
+                if (!cJSON_IsString(value) || !cJSON_IsString(jModule) ||
+                    !app_log_set_level(jModule->valuestring, value->valuestring))
+                {
+                    APP_LOGD("unknow log module or level");
+                    status = false;
+                }
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_STANDBY) == 0))
+            {
+                // {"operation": "standby", "value": 600}, idle seconds before deep sleep, 0 = never
+                value = cJSON_GetObjectItem(root2, "value");
+                if (!cJSON_IsNumber(value) || (value->valueint < 0))
+                {
+                    APP_LOGD("unknow standby idle");
+                    status = false;
+                }
+                else
+                    standby_set_idle(value->valueint);
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_STATIC_IP) == 0))
+            {
+                // {"operation": "static_ip", "ip": "192.168.1.50", "gw": "192.168.1.1", "mask": "255.255.255.0"}
+                // without "ip" back to DHCP, used from the next connection
+                cJSON *jIp = cJSON_GetObjectItem(root2, "ip");
+                cJSON *jGw = cJSON_GetObjectItem(root2, "gw");
+                cJSON *jMask = cJSON_GetObjectItem(root2, "mask");
+                if (!cJSON_IsString(jIp))
+                    wifi_manager_set_sta_static_ip(NULL);
+                else if (!cJSON_IsString(jGw) || !cJSON_IsString(jMask))
+                {
+                    APP_LOGD("static ip needs gw and mask");
+                    status = false;
+                }
+                else
+                {
+                    esp_netif_ip_info_t ip_info = {0};
+                    ip_info.ip.addr = esp_ip4addr_aton(jIp->valuestring);
+                    ip_info.gw.addr = esp_ip4addr_aton(jGw->valuestring);
+                    ip_info.netmask.addr = esp_ip4addr_aton(jMask->valuestring);
+                    // esp_ip4addr_aton gives 255.255.255.255 for a malformed address
+                    if ((ip_info.ip.addr == UINT32_MAX) || (ip_info.ip.addr == 0) || (ip_info.gw.addr == UINT32_MAX))
+                        status = false;
+                    else
+                        wifi_manager_set_sta_static_ip(&ip_info);
+                }
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_OUTBOX) == 0))
+            {
+                // {"operation": "outbox", "window": 4}, QoS1 publishes awaiting PUBACK at once
+                value = cJSON_GetObjectItem(root2, "window");
+                if (!cJSON_IsNumber(value) || (value->valueint < 1) || (value->valueint > OUTBOX_WINDOW_MAX))
+                {
+                    APP_LOGD("unknow outbox window");
+                    status = false;
+                }
+                else
+                    outbox_set_window(value->valueint);
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_METRICS) == 0))
+            {
+                // {"operation": "metrics", "interval": 60}, reports now and then every interval seconds
+                value = cJSON_GetObjectItem(root2, "interval");
+                if ((value != NULL) && (!cJSON_IsNumber(value) || !metrics_set_interval(value->valueint)))
+                {
+                    APP_LOGD("unknow metrics interval");
+                    status = false;
+                }
+                metrics_request();
+                task_registry_notify(TASK_ID_MQTT_SEND);
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_STRIKES) == 0))
+            {
+                // {"operation": "strikes", "window": 60, "live": 300, "raw": true}, every field optional
+                value = cJSON_GetObjectItem(root2, "window");
+                if ((value != NULL) && (!cJSON_IsNumber(value) || !strike_stats_set_window(value->valueint)))
+                {
+                    APP_LOGD("unknow strike window");
+                    status = false;
+                }
+                value = cJSON_GetObjectItem(root2, "live");
+                if (cJSON_IsNumber(value) && (value->valueint >= 0) && (value->valueint <= STRIKE_WINDOW_MAX_S))
+                    strike_stats_set_live(value->valueint);
+                else if (value != NULL)
+                    status = false;
+                if (cJSON_IsTrue(cJSON_GetObjectItem(root2, "raw")))
+                {
+                    deive_data.strikes_request = true;
+                    task_registry_notify(TASK_ID_MQTT_SEND);
+                }
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_DIAGNOSTICS) == 0))
+            {
+                deive_data.diag_request = true;
+                task_registry_notify(TASK_ID_MQTT_SEND);
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_PROFILE) == 0))
+            {
+                deive_data.profile_request = true;
+                task_registry_notify(TASK_ID_MQTT_SEND);
+            }
+            else if ((strcmp(operation, TYPE_COMMAND_TRACE) == 0))
+            {
+                deive_data.trace_request = true;
+                task_registry_notify(TASK_ID_MQTT_SEND);
+            }
             else if ((strcmp(operation, TYPE_COMMAND_RESTART) == 0))
             {
-                // restart device
+                // on job_task, after the reply to this command is out
+                status = job_submit(NULL, 0, message, length);
             }
             else
             {
@@ -107,6 +305,58 @@ bool json_parser_job(const char *message, uint16_t length)
     return status;
 }
 
+/***********************************************************************************************************************
+ * Function Name: json_parse_provision
+ * Description  : {"uri": "mqtts://...", "client_id": "...", "ca": "<PEM>", "cert": "<PEM>", "key": "<PEM>"}, the
+ *                certificates and key are stored as DER
+ * Arguments    : body, length
+ * Return Value : true when the store was written
+ ***********************************************************************************************************************/
+bool json_parse_provision(const char *body, size_t length)
+{
+    bool status = true;
+    cJSON *root = cJSON_ParseWithLength(body, length);
+    prov_blob_t items[PROV_ITEM_COUNT] = {0};
+    uint8_t *der[PROV_ITEM_COUNT] = {NULL};
+
+    for (uint8_t i = 0; (i < PROV_ITEM_COUNT) && (status == true); i++)
+    {
+        cJSON *jItem = cJSON_GetObjectItem(root, prov_item_name(i));
+        if (!cJSON_IsString(jItem))
+        {
+            APP_LOGE("provision without %s", prov_item_name(i));
+            status = false;
+        }
+        else if ((i == PROV_ITEM_URI) || (i == PROV_ITEM_CLIENT_ID))
+        {
+            items[i].data = (const uint8_t *)jItem->valuestring;
+            items[i].len = strlen(jItem->valuestring) + 1;
+        }
+        else
+        {
+            der[i] = malloc(PROV_ITEM_MAX_LEN);
+            if (der[i] == NULL)
+                status = false;
+            else
+            {
+                items[i].data = der[i];
+                items[i].len = prov_pem_to_der(jItem->valuestring, der[i], PROV_ITEM_MAX_LEN);
+                if (items[i].len == 0)
+                {
+                    APP_LOGE("provision %s is not PEM", prov_item_name(i));
+                    status = false;
+                }
+            }
+        }
+    }
+    if (status == true)
+        status = prov_store_write(items);
+    for (uint8_t i = 0; i < PROV_ITEM_COUNT; i++)
+        free(der[i]);
+    cJSON_Delete(root);
+    return status;
+}
+
 /***********************************************************************************************************************
 * Function Name:
 * Description  :
@@ -114,7 +364,11 @@ bool json_parser_job(const char *message, uint16_t length)
    "mac_add",
    {
      "vibration": 1,
-     "acc_detect": 0
+     "acc_detect": 0,
+     "temperature": 31.5,
+     "strike": "solid",
+     "swing_deg": 85,
+     "rate_dps": 640
    }
  }
 * Arguments    : none
@@ -131,13 +385,321 @@ void json_packet_message_sensor(char *message_packet)
 
     cJSON_AddNumberToObject(subroot, "vibration", deive_data.sensor.vibration_level);
     cJSON_AddNumberToObject(subroot, "acc_detect", deive_data.sensor.hammer_detect);
+    cJSON_AddNumberToObject(subroot, "temperature", deive_data.sensor.temperature / 100.0);
+    cJSON_AddStringToObject(subroot, "strike", strike_label_name(deive_data.sensor.strike_label));
+    cJSON_AddNumberToObject(subroot, "swing_deg", deive_data.sensor.swing_angle_deg);
+    cJSON_AddNumberToObject(subroot, "rate_dps", deive_data.sensor.impact_rate_dps);
 
     // APP_LOGD("message = %s", cJSON_PrintUnformatted(root));
 
-    sprintf(message_packet, "%s", cJSON_PrintUnformatted(root));
-    cJSON_free(subroot);
-    cJSON_free(root);
-    // return cJSON_PrintUnformatted(root);
+    cJSON_PrintPreallocated(root, message_packet, JSON_MESSAGE_LEN, false);
+    cJSON_Delete(root);
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_diagnostics
+* Description  :
+ {
+   "mac_add",
+   {
+     "haptic_latency": {"bins_us": [100, 200, ...], "count": [..8..], "max_us": 310, "last_us": 140, "task_path": 0},
+     "heap": {"free": 91232, "min_free": 70344, "largest": 65536},
+     "power": {"window_ms": 60000, "light_sleep": true, "mhz": [40, 160], "duty": {"imu": 18, "net": 4},
+               "warm": true, "wake_ms": 412},
+     "connect": {"assoc": 310, "dhcp": 95, "connack": 1480, "total": 1885, "fast": true, "static": false,
+                 "tls": 1420, "n": 1},
+     "outbox": {"n": [0, 1, 0, 0], "ack_ms": 85, "ack_max": 410}
+   }
+ }
+* Arguments    : message_packet, length - buffer size
+* Return Value : false when the report does not fit
+* Note         : power duty is in 0.1 % of the window since the previous diagnostics, wake_ms is app start to the first
+*                publish of this boot (-1 before it), warm when the boot was a wake from standby, connect is the last
+*                Wi-Fi connection that reached MQTT in ms, outbox is [queued, in flight, dropped, resent] with the
+*                PUBACK latency in ms
+***********************************************************************************************************************/
+bool json_packet_diagnostics(char *message_packet, uint16_t length)
+{
+    static const int edges[HAPTIC_LATENCY_BINS - 1] = HAPTIC_LATENCY_BIN_EDGES_US;
+    haptic_latency_t latency;
+    mem_heap_stats_t heap_stats;
+    power_stats_t power;
+    int counts[HAPTIC_LATENCY_BINS];
+    cJSON *root = NULL;
+    cJSON *subroot = NULL;
+    cJSON *haptic = NULL;
+    cJSON *heap = NULL;
+    cJSON *jPower = NULL;
+    cJSON *jDuty = NULL;
+    cJSON *jConnect = NULL;
+    cJSON *jOutbox = NULL;
+    outbox_stats_t outbox;
+    bool status = false;
+
+    haptic_get_latency(&latency);
+    for (uint8_t i = 0; i < HAPTIC_LATENCY_BINS; i++)
+        counts[i] = latency.bins[i];
+    root = cJSON_CreateObject();
+    subroot = cJSON_AddObjectToObject(root, deive_data.mac_add);
+    haptic = cJSON_AddObjectToObject(subroot, "haptic_latency");
+    cJSON_AddItemToObject(haptic, "bins_us", cJSON_CreateIntArray(edges, HAPTIC_LATENCY_BINS - 1));
+    cJSON_AddItemToObject(haptic, "count", cJSON_CreateIntArray(counts, HAPTIC_LATENCY_BINS));
+    cJSON_AddNumberToObject(haptic, "max_us", latency.max_us);
+    cJSON_AddNumberToObject(haptic, "last_us", latency.last_us);
+    cJSON_AddNumberToObject(haptic, "task_path", latency.task_path);
+    mem_report_heap_stats(&heap_stats);
+    heap = cJSON_AddObjectToObject(subroot, "heap");
+    cJSON_AddNumberToObject(heap, "free", heap_stats.free);
+    cJSON_AddNumberToObject(heap, "min_free", heap_stats.min_free);
+    cJSON_AddNumberToObject(heap, "largest", heap_stats.largest_block);
+    power_stats(&power);
+    power_log(&power);
+    jPower = cJSON_AddObjectToObject(subroot, "power");
+    cJSON_AddNumberToObject(jPower, "window_ms", power.window_ms);
+    cJSON_AddBoolToObject(jPower, "light_sleep", power.light_sleep);
+    cJSON_AddItemToObject(jPower, "mhz", cJSON_CreateIntArray((const int[]){power.min_freq_mhz, power.max_freq_mhz}, 2));
+    jDuty = cJSON_AddObjectToObject(jPower, "duty");
+    cJSON_AddNumberToObject(jDuty, "imu", power.locks[POWER_LOCK_IMU].duty_permille);
+    cJSON_AddNumberToObject(jDuty, "net", power.locks[POWER_LOCK_NET].duty_permille);
+    cJSON_AddNumberToObject(jDuty, "haptic", power.locks[POWER_LOCK_HAPTIC].duty_permille);
+    cJSON_AddNumberToObject(jDuty, "leds", power.locks[POWER_LOCK_LEDS].duty_permille);
+    cJSON_AddBoolToObject(jPower, "warm", standby_warm_boot());
+    cJSON_AddNumberToObject(jPower, "wake_ms", standby_wake_ms());
+    jConnect = cJSON_AddObjectToObject(subroot, "connect");
+    cJSON_AddNumberToObject(jConnect, "assoc", deive_data.connect.assoc_ms);
+    cJSON_AddNumberToObject(jConnect, "dhcp", deive_data.connect.dhcp_ms);
+    cJSON_AddNumberToObject(jConnect, "connack", deive_data.connect.connack_ms);
+    cJSON_AddNumberToObject(jConnect, "total", deive_data.connect.total_ms);
+    cJSON_AddBoolToObject(jConnect, "fast", deive_data.connect.fast);
+    cJSON_AddBoolToObject(jConnect, "static", deive_data.connect.static_ip);
+    cJSON_AddNumberToObject(jConnect, "tls", deive_data.connect.handshake_ms);
+    cJSON_AddNumberToObject(jConnect, "n", deive_data.connect.handshakes);
+    outbox_stats(&outbox);
+    jOutbox = cJSON_AddObjectToObject(subroot, "outbox");
+    cJSON_AddItemToObject(jOutbox, "n", cJSON_CreateIntArray((const int[]){outbox.queued, outbox.in_flight,
+                                                                         outbox.dropped, outbox.resent}, 4));
+    cJSON_AddNumberToObject(jOutbox, "ack_ms", outbox.ack_avg_ms);
+    cJSON_AddNumberToObject(jOutbox, "ack_max", outbox.ack_max_ms);
+
+    status = cJSON_PrintPreallocated(root, message_packet, length, false);
+    if (status == false)
+        APP_LOGE("diagnostics over %u B", length);
+    cJSON_Delete(root);
+    return status;
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_metrics
+* Description  : metrics registry snapshot, counters and histograms are totals since boot so the MQTT report and
+*                GET /metrics.json never take counts from each other. Histogram "n" has one bin per "le" edge and
+*                the overflow bin last.
+ {
+   "mac_add",
+   {
+     "metrics": {"up": 3600,
+                 "c": {"wifi_disc": 1, "mqtt_disc": 2, "mqtt_err": 0, "i2c_err": 0},
+                 "g": {"heap": 91232, "heap_min": 70344, "heap_block": 65536, "rssi": -61, "stack_min": 412},
+                 "h": {"puback_ms": {"le": [50, 100, 250, 1000, 5000], "n": [40, 12, 3, 1, 0, 0], "sum": 3710}, ...}}
+   }
+ }
+* Arguments    : message_packet, length - buffer size
+* Return Value : false when the report does not fit
+***********************************************************************************************************************/
+bool json_packet_metrics(char *message_packet, uint16_t length)
+{
+    metrics_snapshot_t snapshot;
+    cJSON *root = NULL;
+    cJSON *jMetrics = NULL;
+    cJSON *jGroup[3] = {NULL};
+    bool status = false;
+
+    metrics_sample();
+    metrics_snapshot(&snapshot);
+    root = cJSON_CreateObject();
+    jMetrics = cJSON_AddObjectToObject(cJSON_AddObjectToObject(root, deive_data.mac_add), "metrics");
+    cJSON_AddNumberToObject(jMetrics, "up", snapshot.uptime_s);
+    jGroup[0] = cJSON_AddObjectToObject(jMetrics, "c");
+    jGroup[1] = cJSON_AddObjectToObject(jMetrics, "g");
+    jGroup[2] = cJSON_AddObjectToObject(jMetrics, "h");
+    for (uint8_t id = 0; id < METRIC_FIRST_GAUGE; id++)
+        cJSON_AddNumberToObject(jGroup[0], metrics_name(id), snapshot.value[id]);
+    for (uint8_t id = METRIC_FIRST_GAUGE; id < METRIC_FIRST_HISTOGRAM; id++)
+        cJSON_AddNumberToObject(jGroup[1], metrics_name(id), (int32_t)snapshot.value[id]);
+    for (uint8_t h = 0; h < METRICS_HISTOGRAMS; h++)
+    {
+        const uint32_t *edges = metrics_edges(METRIC_FIRST_HISTOGRAM + h);
+        int le[METRICS_HIST_BINS - 1];
+        int n[METRICS_HIST_BINS];
+        cJSON *jHist = cJSON_AddObjectToObject(jGroup[2], metrics_name(METRIC_FIRST_HISTOGRAM + h));
+
+        for (uint8_t b = 0; b < METRICS_HIST_BINS; b++)
+        {
+            if (b < METRICS_HIST_BINS - 1)
+                le[b] = edges[b];
+            n[b] = snapshot.bins[h][b];
+        }
+        cJSON_AddItemToObject(jHist, "le", cJSON_CreateIntArray(le, METRICS_HIST_BINS - 1));
+        cJSON_AddItemToObject(jHist, "n", cJSON_CreateIntArray(n, METRICS_HIST_BINS));
+        cJSON_AddNumberToObject(jHist, "sum", snapshot.sum[h]);
+    }
+    status = cJSON_PrintPreallocated(root, message_packet, length, false);
+    cJSON_Delete(root);
+    return status;
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_strikes
+* Description  : summary of one strike window, sent in place of a message per strike. "up" is the uptime at the
+*                window start in s, "n" has one bin per "le_mg" edge and the overflow bin last, "active_s" is the time
+*                between strikes less than STRIKE_ACTIVE_GAP_MS apart.
+ {
+   "mac_add",
+   {
+     "strikes": {"up": 1200, "s": 60, "n": 42, "peak_mg": {"min": 2210, "mean": 5630, "max": 11840},
+                 "le_mg": [2000, 4000, 6000, 8000, 12000], "bins": [0, 9, 17, 11, 5, 0],
+                 "labels": {"unknown": 0, "solid": 30, "glancing": 9, "miss": 3, "drop": 0}, "active_s": 48}
+   }
+ }
+* Arguments    : message_packet, length - buffer size, window
+* Return Value : false when the summary does not fit
+***********************************************************************************************************************/
+bool json_packet_strikes(char *message_packet, uint16_t length, const strike_window_t *window)
+{
+    static const int edges[STRIKE_STATS_BINS - 1] = STRIKE_STATS_BIN_EDGES_MG;
+    int bins[STRIKE_STATS_BINS];
+    cJSON *root = NULL;
+    cJSON *jStrikes = NULL;
+    cJSON *jPeak = NULL;
+    cJSON *jLabels = NULL;
+    bool status = false;
+
+    for (uint8_t i = 0; i < STRIKE_STATS_BINS; i++)
+        bins[i] = window->bins[i];
+    root = cJSON_CreateObject();
+    jStrikes = cJSON_AddObjectToObject(cJSON_AddObjectToObject(root, deive_data.mac_add), "strikes");
+    cJSON_AddNumberToObject(jStrikes, "up", window->start_s);
+    cJSON_AddNumberToObject(jStrikes, "s", window->length_s);
+    cJSON_AddNumberToObject(jStrikes, "n", window->count);
+    jPeak = cJSON_AddObjectToObject(jStrikes, "peak_mg");
+    cJSON_AddNumberToObject(jPeak, "min", window->peak_min_mg);
+    cJSON_AddNumberToObject(jPeak, "mean", (window->count > 0) ? (window->peak_sum_mg / window->count) : 0);
+    cJSON_AddNumberToObject(jPeak, "max", window->peak_max_mg);
+    cJSON_AddItemToObject(jStrikes, "le_mg", cJSON_CreateIntArray(edges, STRIKE_STATS_BINS - 1));
+    cJSON_AddItemToObject(jStrikes, "bins", cJSON_CreateIntArray(bins, STRIKE_STATS_BINS));
+    jLabels = cJSON_AddObjectToObject(jStrikes, "labels");
+    for (uint8_t i = 0; i < STRIKE_LABEL_COUNT; i++)
+        cJSON_AddNumberToObject(jLabels, strike_label_name(i), window->labels[i]);
+    cJSON_AddNumberToObject(jStrikes, "active_s", window->active_ms / 1000);
+    status = cJSON_PrintPreallocated(root, message_packet, length, false);
+    cJSON_Delete(root);
+    return status;
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_profile
+* Description  : task profile since the previous report, cpu and load in 0.1 %, stack in bytes, wps = wake-ups/s
+ {
+   "mac_add",
+   {
+     "profile": {"window_ms": 10000, "load": [312, 87],
+                 "tasks": [{"name": "imu_task", "core": 1, "prio": 3, "cpu": 41, "stack": 1220, "wps": 52}, ...]}
+   }
+ }
+* Arguments    : message_packet, length - buffer size
+* Return Value : false when no sample was taken or the report does not fit
+***********************************************************************************************************************/
+bool json_packet_profile(char *message_packet, uint16_t length)
+{
+    const task_profile_t *profile = task_profiler_acquire();
+    cJSON *root = NULL;
+    cJSON *subroot = NULL;
+    cJSON *jProfile = NULL;
+    cJSON *jTasks = NULL;
+    int load[portNUM_PROCESSORS];
+    bool status;
+
+    if (profile == NULL)
+        return false;
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+        load[core] = profile->load_permille[core];
+    root = cJSON_CreateObject();
+    subroot = cJSON_AddObjectToObject(root, deive_data.mac_add);
+    jProfile = cJSON_AddObjectToObject(subroot, "profile");
+    cJSON_AddNumberToObject(jProfile, "window_ms", profile->window_ms);
+    cJSON_AddItemToObject(jProfile, "load", cJSON_CreateIntArray(load, portNUM_PROCESSORS));
+    jTasks = cJSON_AddArrayToObject(jProfile, "tasks");
+    for (uint8_t i = 0; i < profile->count; i++)
+    {
+        const task_profile_entry_t *entry = &profile->tasks[i];
+        cJSON *jTask = cJSON_CreateObject();
+        cJSON_AddStringToObject(jTask, "name", entry->name);
+        cJSON_AddNumberToObject(jTask, "core", (entry->core == TASK_PROFILER_CORE_ANY) ? -1 : entry->core);
+        cJSON_AddNumberToObject(jTask, "prio", entry->priority);
+        cJSON_AddNumberToObject(jTask, "cpu", entry->cpu_permille);
+        cJSON_AddNumberToObject(jTask, "stack", entry->stack_free);
+        if (entry->wakes_per_s != TASK_PROFILER_WAKES_UNKNOWN)
+            cJSON_AddNumberToObject(jTask, "wps", entry->wakes_per_s);
+        cJSON_AddItemToArray(jTasks, jTask);
+    }
+    task_profiler_release();
+
+    status = cJSON_PrintPreallocated(root, message_packet, length, false);
+    cJSON_Delete(root);
+    return status;
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_trace
+* Description  : one chunk of the latency trace ring, records are [id, stage, core, t_us]. Printed directly, a chunk
+*                has too many small arrays to build as a cJSON tree.
+ {"mac_add": {"trace": [[17, 1, 1, 40211873], [17, 0, 1, 40209410], ...]}}
+* Arguments    : message_packet, length - buffer size, cursor - start at trace_oldest(), advanced per chunk
+* Return Value : records in this chunk, 0 when the ring is drained
+***********************************************************************************************************************/
+uint16_t json_packet_trace(char *message_packet, uint16_t length, uint32_t *cursor)
+{
+    trace_record_t records[JSON_TRACE_CHUNK_RECORDS];
+    uint16_t count = trace_read(cursor, records, JSON_TRACE_CHUNK_RECORDS);
+    int used;
+
+    if (count == 0)
+        return 0;
+    used = snprintf(message_packet, length, "{\"%s\":{\"trace\":[", deive_data.mac_add);
+    for (uint16_t i = 0; (i < count) && (used < length); i++)
+    {
+        used += snprintf(&message_packet[used], length - used, "%s[%u,%u,%u,%u]", (i == 0) ? "" : ",",
+                         records[i].id, records[i].stage, records[i].core, records[i].t_us);
+    }
+    if (used < length)
+        snprintf(&message_packet[used], length - used, "]}}");
+    return count;
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_strikes_raw
+* Description  : one chunk of the raw strike ring, strikes are [uptime_ms, peak_mg, label, swing_deg, rate_dps]
+ {"mac_add": {"raw": [[1203410, 5630, 1, 85, 640], ...]}}
+* Arguments    : message_packet, length - buffer size, cursor - start at strike_stats_oldest(), advanced per chunk
+* Return Value : strikes in this chunk, 0 when the ring is drained
+***********************************************************************************************************************/
+uint16_t json_packet_strikes_raw(char *message_packet, uint16_t length, uint32_t *cursor)
+{
+    strike_event_t events[JSON_STRIKE_CHUNK_EVENTS];
+    uint16_t count = strike_stats_read(cursor, events, JSON_STRIKE_CHUNK_EVENTS);
+    int used;
+
+    if (count == 0)
+        return 0;
+    used = snprintf(message_packet, length, "{\"%s\":{\"raw\":[", deive_data.mac_add);
+    for (uint16_t i = 0; (i < count) && (used < length); i++)
+    {
+        used += snprintf(&message_packet[used], length - used, "%s[%u,%u,%u,%d,%d]", (i == 0) ? "" : ",",
+                         events[i].at_ms, events[i].peak_mg, events[i].label, events[i].swing_deg,
+                         events[i].rate_dps);
+    }
+    if (used < length)
+        snprintf(&message_packet[used], length - used, "]}}");
+    return count;
 }
 
 void json_packet_event_buttons(char *message_packet, char *event)
@@ -149,9 +711,41 @@ void json_packet_event_buttons(char *message_packet, char *event)
 
     cJSON_AddStringToObject(subroot, "button event", event);
     
-    sprintf(message_packet, "%s", cJSON_PrintUnformatted(root));
-    cJSON_free(subroot);
-    cJSON_free(root);
+    cJSON_PrintPreallocated(root, message_packet, JSON_MESSAGE_LEN, false);
+    cJSON_Delete(root);
+}
+
+/***********************************************************************************************************************
+* Function Name: json_packet_job_status
+* Description  :
+ {
+   "mac_add",
+   {
+     "job": {"id": "ota-0412", "status": "succeeded", "queued_ms": 3, "run_ms": 1840}
+   }
+ }
+* Arguments    : message_packet, id, status, queued_ms - accepted to started, run_ms - started to now,
+*                reason - why it failed, NULL when it did not
+* Return Value : none
+***********************************************************************************************************************/
+void json_packet_job_status(char *message_packet, const char *id, const char *status, uint32_t queued_ms,
+                            uint32_t run_ms, const char *reason)
+{
+    cJSON *root = NULL;
+    cJSON *subroot = NULL;
+    cJSON *jJob = NULL;
+
+    root = cJSON_CreateObject();
+    subroot = cJSON_AddObjectToObject(root, deive_data.mac_add);
+    jJob = cJSON_AddObjectToObject(subroot, "job");
+    cJSON_AddStringToObject(jJob, "id", id);
+    cJSON_AddStringToObject(jJob, "status", status);
+    cJSON_AddNumberToObject(jJob, "queued_ms", queued_ms);
+    cJSON_AddNumberToObject(jJob, "run_ms", run_ms);
+    if (reason != NULL)
+        cJSON_AddStringToObject(jJob, "reason", reason);
+    cJSON_PrintPreallocated(root, message_packet, JSON_MESSAGE_LEN, false);
+    cJSON_Delete(root);
 }
 /***********************************************************************************************************************
  * End of file
@@ -12,10 +12,17 @@
 /***        Include files                                                 ***/
 /****************************************************************************/
 #include "../../Common.h"
+#include "../system/mem_pool.h"
+#include "../user_driver/strike_stats.h"
 
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
+#define JSON_MESSAGE_LEN (640)          // sensor, diagnostics and button messages
+#define JSON_MESSAGE_POOL_BLOCKS (4)
+#define JSON_PROFILE_MESSAGE_LEN (1536) // ~50 bytes per task
+#define JSON_TRACE_CHUNK_RECORDS (48)   // ~28 bytes per record, one chunk fits a json_report_pool block
+#define JSON_STRIKE_CHUNK_EVENTS (32)   // ~36 bytes per strike, one chunk fits a json_report_pool block
 
 /****************************************************************************/
 /***        Type Definitions                                              ***/
@@ -35,10 +42,32 @@ typedef enum
 /****************************************************************************/
 /***         Exported global functions                                     ***/
 /****************************************************************************/
+extern mem_pool_t json_msg_pool;    // JSON_MESSAGE_LEN blocks
+extern mem_pool_t json_report_pool; // JSON_PROFILE_MESSAGE_LEN blocks
+
+void json_parser_init(void);
+
 bool json_parser_job(const char *message, uint16_t length);
 
-// char *json_packet_message_sensor(void);
+bool json_parse_provision(const char *body, size_t length);
+
+// message_packet is a json_msg_pool block for the packets below
 void json_packet_message_sensor(char *message_packet);
 
 void json_packet_event_buttons(char *message_packet, char *event);
+
+bool json_packet_diagnostics(char *message_packet, uint16_t length);
+
+void json_packet_job_status(char *message_packet, const char *id, const char *status, uint32_t queued_ms,
+                            uint32_t run_ms, const char *reason);
+
+bool json_packet_metrics(char *message_packet, uint16_t length);
+
+bool json_packet_strikes(char *message_packet, uint16_t length, const strike_window_t *window);
+
+bool json_packet_profile(char *message_packet, uint16_t length);
+
+uint16_t json_packet_trace(char *message_packet, uint16_t length, uint32_t *cursor);
+
+uint16_t json_packet_strikes_raw(char *message_packet, uint16_t length, uint32_t *cursor);
 #endif /* MAIN_JSON_PARSER_JSON_PARSER_H_ */
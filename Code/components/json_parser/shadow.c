@@ -0,0 +1,288 @@
+/*
+ * shadow.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+/***********************************************************************************************************************
+ * Pragma directive
+ ***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_JSON
+/***********************************************************************************************************************
+ * Includes <System Includes>
+ ***********************************************************************************************************************/
+#include "shadow.h"
+#include "cJson_lib/cJSON.h"
+#include "cJson_lib/cJSON_Utils.h"
+#include "esp_ota_ops.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "../../Common.h"
+#include "../user_driver/haptic.h"
+#include "../task/imu_read_task.h"
+/***********************************************************************************************************************
+ * Macro definitions
+ ***********************************************************************************************************************/
+#define SHADOW_HIT_MIN_MG_LOW (500)
+#define SHADOW_HIT_MIN_MG_HIGH (16000) // the accelerometer runs at 16 g
+#define SHADOW_HIT_RATIO_MAX (32)
+/***********************************************************************************************************************
+ * Typedef definitions
+ ***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Private global variables and functions
+ ***********************************************************************************************************************/
+/* reported state the cloud has, NULL until the first report of this boot or after a resync, which then carries the
+ * full state. Only mqtt_send_task touches it. */
+static cJSON *shadow_sent = NULL;
+static SemaphoreHandle_t shadow_lock;
+static volatile bool shadow_dirty = true;
+static volatile bool shadow_full = false; // drop shadow_sent at the next report, the cloud may not have it
+static volatile uint32_t shadow_due_ms = 0;
+
+static cJSON *shadow_state(void);
+static void shadow_merge(const cJSON *patch);
+static uint8_t shadow_apply(const cJSON *target);
+/***********************************************************************************************************************
+ * Exported global variables and functions (to be accessed by other files)
+ ***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Imported global variables and functions (from other files)
+ ***********************************************************************************************************************/
+
+void shadow_init(void)
+{
+    static StaticSemaphore_t lock_buffer;
+
+    shadow_lock = xSemaphoreCreateMutexStatic(&lock_buffer);
+}
+
+/***********************************************************************************************************************
+ * Function Name: shadow_changed
+ * Description  : a shadowed setting changed locally, reported after SHADOW_COALESCE_MS together with any further
+ *                change in the meantime
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+void shadow_changed(void)
+{
+    if (shadow_dirty == false)
+    {
+        shadow_due_ms = usertimer_gettick() + SHADOW_COALESCE_MS;
+        shadow_dirty = true;
+    }
+}
+
+/***********************************************************************************************************************
+ * Function Name: shadow_resync
+ * Description  : the last report may not have reached the cloud (dropped by the outbox, or the cloud's copy was just
+ *                read back), the next report carries the full state again
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+void shadow_resync(void)
+{
+    shadow_full = true;
+    shadow_changed();
+}
+
+/***********************************************************************************************************************
+ * Function Name: shadow_due
+ * Description  : a report is pending and its coalescing window is over. Stays due while offline, the first poll
+ *                after the reconnect sends everything changed meanwhile as one delta.
+ * Arguments    : none
+ * Return Value : true when shadow_report() should run
+ ***********************************************************************************************************************/
+bool shadow_due(void)
+{
+    return (shadow_dirty == true) && ((int32_t)(usertimer_gettick() - shadow_due_ms) >= 0);
+}
+
+/***********************************************************************************************************************
+ * Function Name: shadow_report
+ * Description  : merge patch from the last reported state to the current one
+ {
+   "state": {"reported": {"vibration": 70, "haptic": {"hit": "double"}}}
+ }
+ *                the first report of a boot, and the first after shadow_resync(), is the full state
+ {
+   "state": {"reported": {"vibration": 50, "hit": {"min_mg": 3000, "ratio": 8},
+                          "haptic": {"hit": "hit", "button": "click", "alert": "alert"}, "fw": "1.4.0"}}
+ }
+ * Arguments    : message_packet, length - buffer size
+ * Return Value : false when nothing changed or the report does not fit
+ ***********************************************************************************************************************/
+bool shadow_report(char *message_packet, uint16_t length)
+{
+    cJSON *current = shadow_state();
+    cJSON *patch = NULL;
+    cJSON *root = NULL;
+    bool status = false;
+
+    shadow_dirty = false;
+    if (shadow_full == true)
+    {
+        shadow_full = false;
+        cJSON_Delete(shadow_sent);
+        shadow_sent = NULL;
+    }
+    if (current == NULL)
+        return false;
+    patch = (shadow_sent != NULL) ? cJSONUtils_GenerateMergePatch(shadow_sent, current) : cJSON_Duplicate(current, 1);
+    if (patch == NULL)
+    {
+        cJSON_Delete(current);
+        return false;
+    }
+    root = cJSON_CreateObject();
+    cJSON_AddItemToObject(cJSON_AddObjectToObject(root, "state"), "reported", patch);
+    status = cJSON_PrintPreallocated(root, message_packet, length, false);
+    cJSON_Delete(root);
+    if (status == true)
+    {
+        cJSON_Delete(shadow_sent);
+        shadow_sent = current;
+    }
+    else
+    {
+        APP_LOGE("shadow report over %u B", length);
+        cJSON_Delete(current);
+    }
+    return status;
+}
+
+/***********************************************************************************************************************
+ * Function Name: shadow_apply_desired
+ * Description  : delta from the cloud, {"state": {...}} or the bare state, as a merge patch on the current state.
+ *                Invalid values are skipped, the next report shows what was applied.
+ * Arguments    : data, len
+ * Return Value : false when the delta is not a JSON object
+ ***********************************************************************************************************************/
+bool shadow_apply_desired(const char *data, uint16_t len)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    cJSON *state = cJSON_GetObjectItem(root, "state");
+
+    if (state == NULL)
+        state = root;
+    if (!cJSON_IsObject(state))
+    {
+        cJSON_Delete(root);
+        return false;
+    }
+    shadow_merge(state);
+    cJSON_Delete(root);
+    shadow_changed();
+    return true;
+}
+
+/***********************************************************************************************************************
+ * Function Name: shadow_apply_document
+ * Description  : the cloud's shadow document, the answer to a shadow/get, read back after a (re)connect. The desired
+ *                state is applied, the next report is full so the reported state matches the device again.
+ {
+   "state": {"desired": {"vibration": 70}, "reported": {...}, "delta": {...}}, "version": 12
+ }
+ * Arguments    : data, len
+ * Return Value : false when the document is not a JSON object
+ ***********************************************************************************************************************/
+bool shadow_apply_document(const char *data, uint16_t len)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    cJSON *desired = cJSON_GetObjectItem(cJSON_GetObjectItem(root, "state"), "desired");
+
+    if (!cJSON_IsObject(root))
+    {
+        cJSON_Delete(root);
+        return false;
+    }
+    if (cJSON_IsObject(desired))
+        shadow_merge(desired);
+    cJSON_Delete(root);
+    shadow_resync();
+    return true;
+}
+/***********************************************************************************************************************
+ * Static Functions
+ ***********************************************************************************************************************/
+/* patch is a merge patch on the current state */
+static void shadow_merge(const cJSON *patch)
+{
+    cJSON *target = NULL;
+    uint8_t applied;
+
+    xSemaphoreTake(shadow_lock, portMAX_DELAY);
+    target = cJSONUtils_MergePatch(shadow_state(), patch);
+    applied = shadow_apply(target);
+    xSemaphoreGive(shadow_lock);
+    APP_LOGI("shadow desired, %u settings applied", applied);
+    cJSON_Delete(target);
+}
+
+static cJSON *shadow_state(void)
+{
+    cJSON *state = cJSON_CreateObject();
+    cJSON *hit = NULL;
+    cJSON *jHaptic = NULL;
+    uint16_t min_mg;
+    uint8_t ratio;
+
+    if (state == NULL)
+        return NULL;
+    cJSON_AddNumberToObject(state, "vibration", deive_data.sensor.vibration_level);
+    imu_get_hit_threshold(&min_mg, &ratio);
+    hit = cJSON_AddObjectToObject(state, "hit");
+    cJSON_AddNumberToObject(hit, "min_mg", min_mg);
+    cJSON_AddNumberToObject(hit, "ratio", ratio);
+    jHaptic = cJSON_AddObjectToObject(state, "haptic");
+    for (uint8_t i = 0; i < HAPTIC_EVENT_COUNT; i++)
+        cJSON_AddStringToObject(jHaptic, haptic_event_name(i), haptic_pattern_name(haptic_get_event_pattern(i)));
+    cJSON_AddStringToObject(state, "fw", esp_ota_get_app_description()->version);
+    return state;
+}
+
+/* target is the full desired state, "fw" is reported only */
+static uint8_t shadow_apply(const cJSON *target)
+{
+    cJSON *value = cJSON_GetObjectItem(target, "vibration");
+    cJSON *hit = cJSON_GetObjectItem(target, "hit");
+    cJSON *jHaptic = cJSON_GetObjectItem(target, "haptic");
+    cJSON *jMin = cJSON_GetObjectItem(hit, "min_mg");
+    cJSON *jRatio = cJSON_GetObjectItem(hit, "ratio");
+    uint16_t min_mg;
+    uint8_t ratio;
+    uint8_t applied = 0;
+
+    if (cJSON_IsNumber(value) && (value->valueint >= 0) && (value->valueint <= 100) &&
+        (value->valueint != deive_data.sensor.vibration_level))
+    {
+        deive_data.sensor.vibration_level = value->valueint;
+        applied++;
+    }
+    imu_get_hit_threshold(&min_mg, &ratio);
+    if (cJSON_IsNumber(jMin) && cJSON_IsNumber(jRatio) && (jMin->valueint >= SHADOW_HIT_MIN_MG_LOW) &&
+        (jMin->valueint <= SHADOW_HIT_MIN_MG_HIGH) && (jRatio->valueint >= 1) &&
+        (jRatio->valueint <= SHADOW_HIT_RATIO_MAX) && ((jMin->valueint != min_mg) || (jRatio->valueint != ratio)))
+    {
+        imu_set_hit_threshold(jMin->valueint, jRatio->valueint);
+        applied++;
+    }
+    for (uint8_t i = 0; i < HAPTIC_EVENT_COUNT; i++)
+    {
+        cJSON *jPattern = cJSON_GetObjectItem(jHaptic, haptic_event_name(i));
+        haptic_pattern_t pattern = haptic_pattern_from_name(cJSON_IsString(jPattern) ? jPattern->valuestring : NULL);
+
+        if ((pattern != HAPTIC_PATTERN_COUNT) && (pattern != haptic_get_event_pattern(i)))
+        {
+            haptic_set_event_pattern(i, pattern);
+            applied++;
+        }
+    }
+    return applied;
+}
+/***********************************************************************************************************************
+ * End of file
+ ***********************************************************************************************************************/
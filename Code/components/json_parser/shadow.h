@@ -0,0 +1,41 @@
+/*
+ * shadow.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef MAIN_JSON_PARSER_SHADOW_H_
+#define MAIN_JSON_PARSER_SHADOW_H_
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define SHADOW_COALESCE_MS (2000) // local changes within this window go out as one delta
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void shadow_init(void);
+
+void shadow_changed(void);
+
+void shadow_resync(void);
+
+bool shadow_due(void);
+
+bool shadow_report(char *message_packet, uint16_t length);
+
+bool shadow_apply_desired(const char *data, uint16_t len);
+
+bool shadow_apply_document(const char *data, uint16_t len);
+#endif /* MAIN_JSON_PARSER_SHADOW_H_ */
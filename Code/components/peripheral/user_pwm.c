@@ -7,13 +7,14 @@
 /***********************************************************************************************************************
 * Pragma directive
 ***********************************************************************************************************************/
-
+#define APP_LOG_MODULE LOG_MODULE_HAPTIC
 /***********************************************************************************************************************
 * Includes <System Includes>
 ***********************************************************************************************************************/
 #include "user_pwm.h"
 #include "driver/ledc.h"
 #include "esp_err.h"
+#include "esp_attr.h"
 #include <math.h>       /* pow */
 /***********************************************************************************************************************
 * Macro definitions
@@ -32,6 +33,13 @@
 /***********************************************************************************************************************
 * Private global variables and functions
 ***********************************************************************************************************************/
+static user_pwm_fade_cb_t fade_callback = NULL;
+static bool fade_service_installed = false;
+/* the fade the callback belongs to, a fade cut off by user_pwm_set_duty_raw() reports nothing */
+static volatile bool fade_running = false;
+static volatile uint32_t fade_target = 0;
+
+static bool IRAM_ATTR user_pwm_fade_isr(const ledc_cb_param_t *param, void *user_arg);
 
 
 /***********************************************************************************************************************
@@ -71,11 +79,18 @@ void user_pwm_init(void)
         .hpoint         = 0
     };
     ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+
+    // hardware fades, completion is reported from the LEDC interrupt
+    user_pwm_fade_service_install();
+    ledc_cbs_t callbacks = {
+        .fade_cb = user_pwm_fade_isr,
+    };
+    ESP_ERROR_CHECK(ledc_cb_register(LEDC_MODE, LEDC_CHANNEL, &callbacks, NULL));
 }
 
 void user_pwm_start(void)
 {
-    ledc_fade_start(LEDC_MODE, LEDC_CHANNEL, LEDC_FADE_WAIT_DONE);
+    ledc_fade_start(LEDC_MODE, LEDC_CHANNEL, LEDC_FADE_NO_WAIT);
     // Set duty to 50%
     ESP_ERROR_CHECK(ledc_set_duty(LEDC_MODE, LEDC_CHANNEL, 0));
     // Update duty to apply the new value
@@ -97,15 +112,85 @@ void user_pwm_set_duty(uint8_t _duty)
     // Update duty to apply the new value
     ESP_ERROR_CHECK(ledc_update_duty(LEDC_MODE, LEDC_CHANNEL));
 }
+
 /***********************************************************************************************************************
-* Static Functions
+* Function Name: user_pwm_fade_service_install
+* Description  : the LEDC fade interrupt is shared by every channel, a second install would allocate a second
+*                interrupt, so the motor and the LEDs both go through here. Call from init code only.
+* Arguments    : none
+* Return Value : none
 ***********************************************************************************************************************/
+void user_pwm_fade_service_install(void)
+{
+    if (fade_service_installed == true)
+        return;
+    ESP_ERROR_CHECK(ledc_fade_func_install(0));
+    fade_service_installed = true;
+}
+
 /***********************************************************************************************************************
-* Function Name:
-* Description  :
-* Arguments    : none
+* Function Name: user_pwm_set_duty_raw
+* Description  : apply a duty right away. A running fade is stopped first, ledc_set_duty_and_update() would
+*                otherwise block until it ends, and its fade end is not reported. Task context only.
+* Arguments    : duty - 0 .. USER_PWM_DUTY_MAX
 * Return Value : none
 ***********************************************************************************************************************/
+void user_pwm_set_duty_raw(uint32_t duty)
+{
+    if (fade_running == true)
+    {
+        fade_running = false;
+        ledc_fade_stop(LEDC_MODE, LEDC_CHANNEL);
+    }
+    ledc_set_duty_and_update(LEDC_MODE, LEDC_CHANNEL, duty, 0);
+}
+
+/***********************************************************************************************************************
+* Function Name: user_pwm_fade
+* Description  : start a hardware fade and return at once, the fade callback runs when it ends. A running fade is
+*                stopped first. Task context only.
+* Arguments    : duty - target 0 .. USER_PWM_DUTY_MAX, time_ms - fade time
+* Return Value : none
+***********************************************************************************************************************/
+void user_pwm_fade(uint32_t duty, uint32_t time_ms)
+{
+    if (fade_running == true)
+    {
+        fade_running = false;
+        ledc_fade_stop(LEDC_MODE, LEDC_CHANNEL);
+    }
+    fade_target = duty;
+    fade_running = true;
+    ledc_set_fade_time_and_start(LEDC_MODE, LEDC_CHANNEL, duty, time_ms, LEDC_FADE_NO_WAIT);
+}
+
+/* false again once the fade reported its end, or was cut off */
+bool user_pwm_fade_running(void)
+{
+    return fade_running;
+}
+
+/***********************************************************************************************************************
+* Function Name: user_pwm_set_fade_callback
+* Description  : register the fade end callback, it runs in the LEDC interrupt
+* Arguments    : cb - returns true when it woke a higher priority task
+* Return Value : none
+***********************************************************************************************************************/
+void user_pwm_set_fade_callback(user_pwm_fade_cb_t cb)
+{
+    fade_callback = cb;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/* only the end of the current fade, one stopped or superseded in the meantime is dropped */
+static bool IRAM_ATTR user_pwm_fade_isr(const ledc_cb_param_t *param, void *user_arg)
+{
+    if ((param->event != LEDC_FADE_END_EVT) || (fade_running == false) || (param->duty != fade_target))
+        return false;
+    fade_running = false;
+    return (fade_callback != NULL) ? fade_callback() : false;
+}
 
 /***********************************************************************************************************************
 * End of file
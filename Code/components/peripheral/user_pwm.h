@@ -12,10 +12,12 @@ extern "C" {
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
+#define USER_PWM_DUTY_MAX ((1 << 13) - 1)
 
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
+typedef bool (*user_pwm_fade_cb_t)(void);
 
 /****************************************************************************/
 /***         Exported global functions                                     ***/
@@ -28,6 +30,16 @@ void user_pwm_stop(void);
 
 void user_pwm_set_duty(uint8_t _duty);
 
+void user_pwm_fade_service_install(void);
+
+void user_pwm_set_duty_raw(uint32_t duty);
+
+void user_pwm_fade(uint32_t duty, uint32_t time_ms);
+
+bool user_pwm_fade_running(void);
+
+void user_pwm_set_fade_callback(user_pwm_fade_cb_t cb);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
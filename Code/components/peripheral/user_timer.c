@@ -10,35 +10,8 @@
 #include <stdbool.h>
 #include "user_timer.h"
 
-//int Counter_msec = 0;	// conter millisec
-
-static void periodic_timer_callback(void *arg);
-
-static uint32_t tick_time = 0;
-void UserTimer_Init()
-{
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = &periodic_timer_callback,
-        /* name is optional, but may help identify the timer when debugging */
-        .name = "periodic"};
-
-    esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-    /* The timer has been created but is not running yet */
-
-    /* Start the timers */
-    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_timer, TIMER_INTERVAL));
-    //    /* Clean up and finish the example */
-    //    ESP_ERROR_CHECK(esp_timer_stop(periodic_timer));
-    //    ESP_ERROR_CHECK(esp_timer_delete(periodic_timer));
-}
-
+/* the millisecond tick is derived from esp_timer, a 1 kHz periodic callback would keep the chip out of light sleep */
 uint32_t usertimer_gettick(void)
 {
-    return tick_time;
-}
-
-static void periodic_timer_callback(void *arg)
-{
-    tick_time++;
+    return (uint32_t)(esp_timer_get_time() / 1000);
 }
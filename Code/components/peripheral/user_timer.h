@@ -16,9 +16,6 @@
 #include "esp_log.h"
 #include "esp_sleep.h"
 
-#define TIMER_INTERVAL			1000 /*1ms*/
-
-void UserTimer_Init(void);
 uint32_t usertimer_gettick( void );
 
 #endif /* MAIN_INTERFACE_USERTIMER_H_ */
@@ -0,0 +1,545 @@
+/*
+ * app_log.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <stdarg.h>
+#include <string.h>
+#include "app_log.h"
+#include "task_registry.h"
+#include "mem_report.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#ifdef CONFIG_APP_LOG_RING_SLOTS
+#define APP_LOG_SLOTS CONFIG_APP_LOG_RING_SLOTS
+#else
+#define APP_LOG_SLOTS (128)
+#endif
+#define APP_LOG_ARG_BYTES (44) /* a slot is 64 bytes with the header */
+#define APP_LOG_IDLE_MS (1000) /* writers wake the drain task, this only bounds a missed wake-up */
+#define APP_LOG_LINE_LEN (256)
+#define APP_LOG_SPEC_LEN (16)
+#define APP_LOG_FILE "/spiffs/app.log"
+#define APP_LOG_FILE_OLD "/spiffs/app.log.1"
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef enum
+{
+	LOG_ARG_LITERAL, /* %% */
+	LOG_ARG_INT,
+	LOG_ARG_LONG,
+	LOG_ARG_LLONG,
+	LOG_ARG_SIZE,
+	LOG_ARG_PTR,
+	LOG_ARG_DOUBLE,
+	LOG_ARG_STR,
+	LOG_ARG_INVALID
+} app_log_arg_t;
+
+typedef struct
+{
+	uint8_t kind;
+	uint8_t stars;     /* '*' width/precision, each takes an int argument first */
+	uint8_t len;       /* characters from '%' to the conversion */
+	bool star_prec;    /* the last '*' is the precision */
+	int16_t precision; /* literal precision, -1 when none */
+} app_log_spec_t;
+
+typedef struct
+{
+	volatile uint32_t seq; /* write index + 1 once the slot is complete */
+	const char *fmt;
+	const char *func;
+	uint32_t t_ms;
+	uint16_t line;
+	uint8_t level;
+	uint8_t count; /* conversions packed, fewer than the format has when args did not fit */
+	uint8_t args[APP_LOG_ARG_BYTES];
+} app_log_slot_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static const char *const module_names[LOG_MODULE_COUNT] = {
+	"app", "imu", "mqtt", "button", "haptic", "led", "json", "system",
+};
+static const char *const level_names[E_LOG_LVL_NEVER] = {"none", "error", "warning", "info", "debug"};
+
+#ifdef CONFIG_APP_LOG_DEFERRED
+static const char *const level_tags[E_LOG_LVL_NEVER] = {
+	"", KRED "ERROR" RESET, BG_KOLORS_YEL "ALARM" RESET, KGRN "INFOR" RESET, KYEL "DEBUG" RESET,
+};
+
+static app_log_slot_t log_ring[APP_LOG_SLOTS];
+static uint32_t log_head; /* next slot to reserve, producers race on it with CAS */
+static uint32_t log_tail; /* next slot to drain, only the drain task writes it */
+static uint32_t log_dropped;
+
+static const char *app_log_parse_spec(const char *p, app_log_spec_t *spec);
+static void app_log_pack(app_log_slot_t *slot, const char *fmt, va_list ap);
+static int app_log_format(const app_log_slot_t *slot, char *out, int size);
+static bool app_log_drain_one(char *line);
+static void app_log_output(const char *line, int len);
+static void app_log_task(void *pvParameters);
+#endif
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+uint8_t app_log_levels[LOG_MODULE_COUNT] = {[0 ... LOG_MODULE_COUNT - 1] = LOG_BUILD_LEVEL};
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: app_log_init
+* Description  : start the drain task, records written before this wait in the ring
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void app_log_init(void)
+{
+#ifdef CONFIG_APP_LOG_DEFERRED
+	mem_report_static("app_log", sizeof(log_ring));
+	task_registry_start(TASK_ID_LOG, app_log_task, NULL, NULL);
+#endif
+}
+
+/***********************************************************************************************************************
+* Function Name: app_log_set_level
+* Description  : runtime level of one module or "all", cannot go above the build level
+* Arguments    : module, level - names
+* Return Value : false for an unknown name
+***********************************************************************************************************************/
+bool app_log_set_level(const char *module, const char *level)
+{
+	bool all = (module != NULL) && (strcmp(module, "all") == 0);
+	bool found = false;
+	uint8_t lvl;
+
+	if ((module == NULL) || (level == NULL))
+		return false;
+	for (lvl = 0; lvl < E_LOG_LVL_NEVER; lvl++)
+	{
+		if (strcmp(level, level_names[lvl]) == 0)
+			break;
+	}
+	if (lvl == E_LOG_LVL_NEVER)
+		return false;
+	if (lvl > LOG_BUILD_LEVEL)
+		lvl = LOG_BUILD_LEVEL;
+	for (uint8_t m = 0; m < LOG_MODULE_COUNT; m++)
+	{
+		if (all || (strcmp(module, module_names[m]) == 0))
+		{
+			app_log_levels[m] = lvl;
+			found = true;
+		}
+	}
+	return found;
+}
+
+/***********************************************************************************************************************
+* Function Name: app_log_dropped
+* Description  : records lost to a full ring since boot
+* Arguments    : none
+* Return Value : count
+***********************************************************************************************************************/
+uint32_t app_log_dropped(void)
+{
+#ifdef CONFIG_APP_LOG_DEFERRED
+	return log_dropped;
+#else
+	return 0;
+#endif
+}
+
+#ifdef CONFIG_APP_LOG_DEFERRED
+/***********************************************************************************************************************
+* Function Name: app_log_write
+* Description  : the hot path: reserve a slot with one CAS, keep the format pointer and copy the arguments.
+*                Formatting and the UART wait happen in the drain task. A full ring drops the record.
+* Arguments    : level, func, line, fmt - must be a string literal, only the pointer is kept
+* Return Value : none
+***********************************************************************************************************************/
+void app_log_write(uint8_t level, const char *func, uint16_t line, const char *fmt, ...)
+{
+	uint32_t head = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+	uint32_t tail;
+	app_log_slot_t *slot;
+	va_list ap;
+
+	do
+	{
+		tail = __atomic_load_n(&log_tail, __ATOMIC_ACQUIRE);
+		if (head - tail >= APP_LOG_SLOTS)
+		{
+			__atomic_add_fetch(&log_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	} while (!__atomic_compare_exchange_n(&log_head, &head, head + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	slot = &log_ring[head % APP_LOG_SLOTS];
+	slot->fmt = fmt;
+	slot->func = func;
+	slot->line = line;
+	slot->level = level;
+	slot->t_ms = (uint32_t)(esp_timer_get_time() / 1000);
+	va_start(ap, fmt);
+	app_log_pack(slot, fmt, ap);
+	va_end(ap);
+	__atomic_store_n(&slot->seq, head + 1, __ATOMIC_RELEASE);
+	/* the first record into an empty ring wakes the drain task, the rest ride along */
+	if (head == tail)
+		task_registry_notify(TASK_ID_LOG);
+}
+#endif
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+#ifdef CONFIG_APP_LOG_DEFERRED
+/* p is on '%', returns the character after the conversion */
+static const char *app_log_parse_spec(const char *p, app_log_spec_t *spec)
+{
+	const char *q = p + 1;
+	uint8_t longs = 0;
+
+	spec->stars = 0;
+	spec->star_prec = false;
+	spec->precision = -1;
+	spec->kind = LOG_ARG_INVALID;
+	while ((*q != '\0') && (strchr("-+ #0", *q) != NULL))
+		q++;
+	if (*q == '*')
+	{
+		spec->stars++;
+		q++;
+	}
+	while ((*q >= '0') && (*q <= '9'))
+		q++;
+	if (*q == '.')
+	{
+		q++;
+		if (*q == '*')
+		{
+			spec->stars++;
+			spec->star_prec = true;
+			q++;
+		}
+		else
+		{
+			spec->precision = 0;
+		}
+		while ((*q >= '0') && (*q <= '9'))
+			spec->precision = spec->precision * 10 + (*q++ - '0');
+	}
+	while ((*q == 'h') || (*q == 'l') || (*q == 'z') || (*q == 'j') || (*q == 't') || (*q == 'L'))
+	{
+		if ((*q == 'l') || (*q == 'j'))
+			longs += (*q == 'j') ? 2 : 1;
+		else if ((*q == 'z') || (*q == 't'))
+			longs = 3;
+		q++;
+	}
+	switch (*q)
+	{
+	case '%':
+		spec->kind = LOG_ARG_LITERAL;
+		break;
+	case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+		spec->kind = (longs == 0) ? LOG_ARG_INT : (longs == 1) ? LOG_ARG_LONG : (longs == 2) ? LOG_ARG_LLONG : LOG_ARG_SIZE;
+		break;
+	case 'p':
+		spec->kind = LOG_ARG_PTR;
+		break;
+	case 's':
+		spec->kind = LOG_ARG_STR;
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		spec->kind = LOG_ARG_DOUBLE;
+		break;
+	case '\0':
+		spec->len = q - p;
+		return q;
+	default:
+		break;
+	}
+	spec->len = q + 1 - p;
+	return q + 1;
+}
+
+#define LOG_PACK(type)                                          \
+	do                                                          \
+	{                                                           \
+		type v = va_arg(ap, type);                              \
+		if (used + sizeof(type) > APP_LOG_ARG_BYTES)            \
+			return;                                             \
+		memcpy(&slot->args[used], &v, sizeof(type));            \
+		used += sizeof(type);                                   \
+	} while (0)
+
+/* arguments in format order, strings are copied (length byte + bytes) and clipped to what is left */
+static void app_log_pack(app_log_slot_t *slot, const char *fmt, va_list ap)
+{
+	app_log_spec_t spec;
+	uint32_t used = 0;
+	int star = -1;
+	const char *p = fmt;
+
+	slot->count = 0;
+	while (*p != '\0')
+	{
+		if (*p != '%')
+		{
+			p++;
+			continue;
+		}
+		p = app_log_parse_spec(p, &spec);
+		if (spec.kind == LOG_ARG_LITERAL)
+			continue;
+		if (spec.kind == LOG_ARG_INVALID)
+			return;
+		for (uint8_t i = 0; i < spec.stars; i++)
+		{
+			star = va_arg(ap, int);
+			if (used + sizeof(int) > APP_LOG_ARG_BYTES)
+				return;
+			memcpy(&slot->args[used], &star, sizeof(int));
+			used += sizeof(int);
+		}
+		switch (spec.kind)
+		{
+		case LOG_ARG_INT:
+			LOG_PACK(int);
+			break;
+		case LOG_ARG_LONG:
+			LOG_PACK(long);
+			break;
+		case LOG_ARG_LLONG:
+			LOG_PACK(long long);
+			break;
+		case LOG_ARG_SIZE:
+			LOG_PACK(size_t);
+			break;
+		case LOG_ARG_PTR:
+			LOG_PACK(void *);
+			break;
+		case LOG_ARG_DOUBLE:
+			LOG_PACK(double);
+			break;
+		case LOG_ARG_STR:
+		{
+			const char *s = va_arg(ap, const char *);
+			size_t limit = (used + 1 < APP_LOG_ARG_BYTES) ? (APP_LOG_ARG_BYTES - used - 1) : 0;
+			size_t n;
+
+			if (limit == 0)
+				return;
+			if (s == NULL)
+				s = "(null)";
+			if ((spec.precision >= 0) && ((size_t)spec.precision < limit))
+				limit = spec.precision;
+			if (spec.star_prec && (star >= 0) && ((size_t)star < limit))
+				limit = star;
+			n = strnlen(s, limit);
+			slot->args[used++] = (uint8_t)n;
+			memcpy(&slot->args[used], s, n);
+			used += n;
+			break;
+		}
+		default:
+			return;
+		}
+		slot->count++;
+	}
+}
+
+#define LOG_EMIT(value)                                                                                              \
+	((spec.stars == 0)   ? snprintf(&out[n], size - n, spec_buf, value)                                              \
+	 : (spec.stars == 1) ? snprintf(&out[n], size - n, spec_buf, stars[0], value)                                    \
+						 : snprintf(&out[n], size - n, spec_buf, stars[0], stars[1], value))
+
+#define LOG_UNPACK(type, var)                      \
+	type var;                                      \
+	memcpy(&var, &slot->args[used], sizeof(type)); \
+	used += sizeof(type)
+
+/* runs in the drain task, replays the format one conversion at a time */
+static int app_log_format(const app_log_slot_t *slot, char *out, int size)
+{
+	app_log_spec_t spec;
+	char spec_buf[APP_LOG_SPEC_LEN];
+	char str[APP_LOG_ARG_BYTES];
+	const char *p = slot->fmt;
+	const char *literal = p;
+	uint32_t used = 0;
+	uint8_t done = 0;
+	int stars[2];
+	int n = 0;
+	int w;
+
+	while ((*p != '\0') && (n < size - 1))
+	{
+		if (*p != '%')
+		{
+			p++;
+			continue;
+		}
+		w = snprintf(&out[n], size - n, "%.*s", (int)(p - literal), literal);
+		n += (w < size - n) ? w : (size - n - 1);
+		literal = app_log_parse_spec(p, &spec);
+		if (spec.kind == LOG_ARG_LITERAL)
+		{
+			w = snprintf(&out[n], size - n, "%%");
+		}
+		else if ((spec.kind == LOG_ARG_INVALID) || (done >= slot->count) || (spec.len >= APP_LOG_SPEC_LEN))
+		{
+			/* arguments did not fit the slot */
+			w = snprintf(&out[n], size - n, "~");
+			n += (w < size - n) ? w : (size - n - 1);
+			return n;
+		}
+		else
+		{
+			memcpy(spec_buf, p, spec.len);
+			spec_buf[spec.len] = '\0';
+			for (uint8_t i = 0; i < spec.stars; i++)
+			{
+				memcpy(&stars[i], &slot->args[used], sizeof(int));
+				used += sizeof(int);
+			}
+			switch (spec.kind)
+			{
+			case LOG_ARG_INT:
+			{
+				LOG_UNPACK(int, v);
+				w = LOG_EMIT(v);
+				break;
+			}
+			case LOG_ARG_LONG:
+			{
+				LOG_UNPACK(long, v);
+				w = LOG_EMIT(v);
+				break;
+			}
+			case LOG_ARG_LLONG:
+			{
+				LOG_UNPACK(long long, v);
+				w = LOG_EMIT(v);
+				break;
+			}
+			case LOG_ARG_SIZE:
+			{
+				LOG_UNPACK(size_t, v);
+				w = LOG_EMIT(v);
+				break;
+			}
+			case LOG_ARG_PTR:
+			{
+				LOG_UNPACK(void *, v);
+				w = LOG_EMIT(v);
+				break;
+			}
+			case LOG_ARG_DOUBLE:
+			{
+				LOG_UNPACK(double, v);
+				w = LOG_EMIT(v);
+				break;
+			}
+			default: /* LOG_ARG_STR */
+			{
+				uint8_t len = slot->args[used++];
+				memcpy(str, &slot->args[used], len);
+				str[len] = '\0';
+				used += len;
+				w = LOG_EMIT(str);
+				break;
+			}
+			}
+			done++;
+		}
+		n += (w < size - n) ? w : (size - n - 1);
+		p = literal;
+	}
+	w = snprintf(&out[n], size - n, "%s", literal);
+	n += (w < size - n) ? w : (size - n - 1);
+	return n;
+}
+
+static bool app_log_drain_one(char *line)
+{
+	app_log_slot_t *slot = &log_ring[log_tail % APP_LOG_SLOTS];
+	int n;
+
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != log_tail + 1)
+		return false;
+	n = snprintf(line, APP_LOG_LINE_LEN, "[%s] %u %s:%d: " RESET, level_tags[slot->level], (unsigned)slot->t_ms, slot->func,
+				 slot->line);
+	if (n > APP_LOG_LINE_LEN - 3)
+		n = APP_LOG_LINE_LEN - 3;
+	n += app_log_format(slot, &line[n], APP_LOG_LINE_LEN - 2 - n);
+	line[n++] = '\r';
+	line[n++] = '\n';
+	__atomic_store_n(&log_tail, log_tail + 1, __ATOMIC_RELEASE);
+	app_log_output(line, n);
+	return true;
+}
+
+static void app_log_output(const char *line, int len)
+{
+	fwrite(line, 1, len, stdout);
+#ifdef CONFIG_APP_LOG_SPIFFS
+	static FILE *file = NULL;
+
+	if (file == NULL)
+		file = fopen(APP_LOG_FILE, "a");
+	if (file == NULL)
+		return;
+	fwrite(line, 1, len, file);
+	if (ftell(file) > CONFIG_APP_LOG_SPIFFS_MAX_BYTES)
+	{
+		fclose(file);
+		remove(APP_LOG_FILE_OLD);
+		rename(APP_LOG_FILE, APP_LOG_FILE_OLD);
+		file = fopen(APP_LOG_FILE, "a");
+	}
+#endif
+}
+
+static void app_log_task(void *pvParameters)
+{
+	static char line[APP_LOG_LINE_LEN];
+	uint32_t reported_drops = 0;
+
+	while (1)
+	{
+		task_registry_wake(TASK_ID_LOG);
+		while (app_log_drain_one(line))
+		{
+		}
+		if (log_dropped != reported_drops)
+		{
+			int n = snprintf(line, APP_LOG_LINE_LEN, "[%s] %u log records dropped\r\n", level_tags[E_LOG_LVL_WARNING],
+							 (unsigned)(log_dropped - reported_drops));
+			app_log_output(line, n);
+			reported_drops = log_dropped;
+		}
+		fflush(stdout);
+		ulTaskNotifyTake(pdTRUE, APP_LOG_IDLE_MS / portTICK_PERIOD_MS);
+	}
+}
+#endif
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,117 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+/* included by Common.h, must not include it back */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* Console color */
+#define RESET "\x1B[0m"
+#define KRED "\x1B[31m"
+#define KGRN "\x1B[32m"
+#define KYEL "\x1B[33m"
+#define KBLU "\x1B[34m"
+#define KMAG "\x1B[35m"
+#define KCYN "\x1B[36m"
+#define KWHT "\x1B[37m"
+/*Background colors*/
+#define BG_KOLORS_BLK "\x1b[40m" //Black
+#define BG_KOLORS_RED "\x1b[41m" //Red
+#define BG_KOLORS_GRN "\x1b[42m" //Green
+#define BG_KOLORS_YEL "\x1b[43m" //Yellow
+#define BG_KOLORS_BLU "\x1b[44m" //Blue
+
+#ifdef CONFIG_APP_LOG_BUILD_LEVEL
+#define LOG_BUILD_LEVEL CONFIG_APP_LOG_BUILD_LEVEL
+#else
+#define LOG_BUILD_LEVEL E_LOG_LVL_DEBUG
+#endif
+
+/* a source file picks its module by defining APP_LOG_MODULE before its includes */
+#ifndef APP_LOG_MODULE
+#define APP_LOG_MODULE LOG_MODULE_APP
+#endif
+
+/* levels above LOG_BUILD_LEVEL compile to nothing, the rest cost one table lookup when disabled at runtime */
+#define LOG_SHOULD_I(level) (level <= LOG_BUILD_LEVEL && level <= E_LOG_LVL_DEBUG)
+
+#ifdef CONFIG_APP_LOG_DEFERRED
+#define LOG(level, tag, ...)                                                                 \
+	do                                                                                       \
+	{                                                                                        \
+		if (LOG_SHOULD_I(level) && (level <= app_log_levels[APP_LOG_MODULE]))                \
+		{                                                                                    \
+			app_log_write(level, __func__, __LINE__, __VA_ARGS__);                           \
+		}                                                                                    \
+	} while (0)
+#else
+#define LOG(level, tag, ...)                                                                 \
+	do                                                                                       \
+	{                                                                                        \
+		if (LOG_SHOULD_I(level) && (level <= app_log_levels[APP_LOG_MODULE]))                \
+		{                                                                                    \
+			printf("[%s] %s:%d: " RESET, tag, __func__, __LINE__);                           \
+			printf(__VA_ARGS__);                                                             \
+			printf("\r\n");                                                                  \
+		}                                                                                    \
+	} while (0)
+#endif
+
+#define APP_LOGE(...) LOG(E_LOG_LVL_ERROR, KRED "ERROR" RESET, __VA_ARGS__)
+#define APP_LOGI(...) LOG(E_LOG_LVL_INFO, KGRN "INFOR" RESET, __VA_ARGS__)
+#define APP_LOGD(...) LOG(E_LOG_LVL_DEBUG, KYEL "DEBUG" RESET, __VA_ARGS__)
+#define APP_LOGW(...) LOG(E_LOG_LVL_WARNING, BG_KOLORS_YEL "ALARM" RESET, __VA_ARGS__)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+enum
+{
+	E_LOG_LVL_NONE,
+	E_LOG_LVL_ERROR,
+	E_LOG_LVL_WARNING,
+	E_LOG_LVL_INFO,
+	E_LOG_LVL_DEBUG,
+	E_LOG_LVL_NEVER
+};
+
+typedef enum
+{
+	LOG_MODULE_APP,
+	LOG_MODULE_IMU,
+	LOG_MODULE_MQTT,
+	LOG_MODULE_BUTTON,
+	LOG_MODULE_HAPTIC,
+	LOG_MODULE_LED,
+	LOG_MODULE_JSON,
+	LOG_MODULE_SYSTEM,
+	LOG_MODULE_COUNT
+} app_log_module_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+extern uint8_t app_log_levels[LOG_MODULE_COUNT];
+
+void app_log_init(void);
+
+void app_log_write(uint8_t level, const char *func, uint16_t line, const char *fmt, ...)
+	__attribute__((format(printf, 4, 5)));
+
+bool app_log_set_level(const char *module, const char *level);
+
+uint32_t app_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
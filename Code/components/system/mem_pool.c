@@ -0,0 +1,89 @@
+/*
+ * mem_pool.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "mem_pool.h"
+#include "mem_report.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: mem_pool_init
+* Description  : the free list is a static queue of block pointers, so take/give are thread safe and a taker can block
+* Arguments    : pool - from MEM_POOL_DEFINE
+* Return Value : none
+***********************************************************************************************************************/
+void mem_pool_init(mem_pool_t *pool)
+{
+	if (pool->free_blocks != NULL)
+		return;
+	pool->free_blocks = xQueueCreateStatic(pool->block_count, sizeof(void *), pool->queue_storage, &pool->queue_buffer);
+	for (uint8_t i = 0; i < pool->block_count; i++)
+	{
+		void *block = &pool->storage[i * pool->block_size];
+		xQueueSend(pool->free_blocks, &block, 0);
+	}
+	pool->low_water = pool->block_count;
+	mem_report_static(pool->name, pool->block_size * pool->block_count + pool->block_count * sizeof(void *));
+}
+
+/***********************************************************************************************************************
+* Function Name: mem_pool_take
+* Description  : take a block, contents are undefined
+* Arguments    : pool, wait - ticks to wait for a free block
+* Return Value : block, NULL when none was freed in time
+***********************************************************************************************************************/
+void *mem_pool_take(mem_pool_t *pool, TickType_t wait)
+{
+	void *block = NULL;
+	UBaseType_t left;
+
+	if (xQueueReceive(pool->free_blocks, &block, wait) != pdTRUE)
+	{
+		APP_LOGW("%s exhausted", pool->name);
+		return NULL;
+	}
+	left = uxQueueMessagesWaiting(pool->free_blocks);
+	if (left < pool->low_water)
+		pool->low_water = left;
+	return block;
+}
+
+void mem_pool_give(mem_pool_t *pool, void *block)
+{
+	if (block != NULL)
+		xQueueSend(pool->free_blocks, &block, 0);
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* a pool of count fixed-size blocks, all storage is static */
+#define MEM_POOL_DEFINE(pool, size, count)                                                   \
+	static uint8_t pool##_storage[(size) * (count)] __attribute__((aligned(4)));             \
+	static uint8_t pool##_queue[(count) * sizeof(void *)];                                   \
+	mem_pool_t pool = {                                                                      \
+		.name = #pool,                                                                       \
+		.storage = pool##_storage,                                                           \
+		.queue_storage = pool##_queue,                                                       \
+		.block_size = (size),                                                                \
+		.block_count = (count),                                                              \
+	}
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+	const char *name;
+	uint8_t *storage;
+	uint8_t *queue_storage;
+	uint16_t block_size;
+	uint8_t block_count;
+	uint8_t low_water; /* fewest free blocks seen */
+	StaticQueue_t queue_buffer;
+	QueueHandle_t free_blocks;
+} mem_pool_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void mem_pool_init(mem_pool_t *pool);
+
+void *mem_pool_take(mem_pool_t *pool, TickType_t wait);
+
+void mem_pool_give(mem_pool_t *pool, void *block);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+/*
+ * mem_report.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "mem_report.h"
+#include "esp_heap_caps.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef struct
+{
+	const char *owner;
+	uint32_t static_bytes;
+	int32_t heap_bytes;
+} mem_report_entry_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static mem_report_entry_t entries[MEM_REPORT_MAX_ENTRIES];
+static uint8_t entry_count;
+static mem_report_entry_t *heap_owner;
+static uint32_t heap_owner_free;
+
+static mem_report_entry_t *mem_report_entry(const char *owner);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+/* linker script symbols */
+extern uint8_t _data_start, _data_end, _bss_start, _bss_end;
+
+/***********************************************************************************************************************
+* Function Name: mem_report_static
+* Description  : book a static reservation (stack, pool, buffer) against its owner. Boot time only, not thread safe.
+* Arguments    : owner - name, kept by pointer, bytes
+* Return Value : none
+***********************************************************************************************************************/
+void mem_report_static(const char *owner, uint32_t bytes)
+{
+	mem_report_entry_t *entry = mem_report_entry(owner);
+
+	if (entry != NULL)
+		entry->static_bytes += bytes;
+}
+
+/***********************************************************************************************************************
+* Function Name: mem_report_heap_begin
+* Description  : heap taken between begin and end is booked against owner, wrap each init step of app_main
+* Arguments    : owner
+* Return Value : none
+***********************************************************************************************************************/
+void mem_report_heap_begin(const char *owner)
+{
+	heap_owner = mem_report_entry(owner);
+	heap_owner_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+void mem_report_heap_end(void)
+{
+	if (heap_owner != NULL)
+		heap_owner->heap_bytes += (int32_t)(heap_owner_free - heap_caps_get_free_size(MALLOC_CAP_8BIT));
+	heap_owner = NULL;
+}
+
+void mem_report_heap_stats(mem_heap_stats_t *stats)
+{
+	stats->free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+	stats->min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+	stats->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+/***********************************************************************************************************************
+* Function Name: mem_report_log
+* Description  : boot memory budget: static and heap per owner, image .data/.bss and the heap headroom
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void mem_report_log(void)
+{
+	mem_heap_stats_t heap;
+	uint32_t static_total = 0;
+	int32_t heap_total = 0;
+
+	mem_report_heap_stats(&heap);
+	APP_LOGI("memory budget        static     heap");
+	for (uint8_t i = 0; i < entry_count; i++)
+	{
+		APP_LOGI("  %-16s %8d %8d", entries[i].owner, entries[i].static_bytes, entries[i].heap_bytes);
+		static_total += entries[i].static_bytes;
+		heap_total += entries[i].heap_bytes;
+	}
+	APP_LOGI("  %-16s %8d %8d", "total", static_total, heap_total);
+	APP_LOGI("image .data %d .bss %d", (int)(&_data_end - &_data_start), (int)(&_bss_end - &_bss_start));
+	APP_LOGI("heap free %d, min ever %d, largest block %d", heap.free, heap.min_free, heap.largest_block);
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+static mem_report_entry_t *mem_report_entry(const char *owner)
+{
+	for (uint8_t i = 0; i < entry_count; i++)
+	{
+		if (strcmp(entries[i].owner, owner) == 0)
+			return &entries[i];
+	}
+	if (entry_count >= MEM_REPORT_MAX_ENTRIES)
+	{
+		APP_LOGE("memory report full, %s not booked", owner);
+		return NULL;
+	}
+	entries[entry_count].owner = owner;
+	return &entries[entry_count++];
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
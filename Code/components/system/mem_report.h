@@ -0,0 +1,41 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define MEM_REPORT_MAX_ENTRIES (20)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+	uint32_t free;
+	uint32_t min_free;      /* lowest free heap since boot */
+	uint32_t largest_block; /* largest allocatable block, fragmentation shows as largest << free */
+} mem_heap_stats_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void mem_report_static(const char *owner, uint32_t bytes);
+
+void mem_report_heap_begin(const char *owner);
+
+void mem_report_heap_end(void);
+
+void mem_report_heap_stats(mem_heap_stats_t *stats);
+
+void mem_report_log(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+/*
+ * metrics.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "metrics.h"
+#include "mem_report.h"
+#include "task_registry.h"
+#include "esp_wifi.h"
+#include "esp_timer.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+/* short names keep the report inside one JSON_MESSAGE_LEN block */
+static const char *const metric_names[METRIC_COUNT] = {
+	[METRIC_WIFI_DISCONNECTS] = "wifi_disc",
+	[METRIC_MQTT_DISCONNECTS] = "mqtt_disc",
+	[METRIC_MQTT_ERRORS] = "mqtt_err",
+	[METRIC_I2C_ERRORS] = "i2c_err",
+	[METRIC_HEAP_FREE] = "heap",
+	[METRIC_HEAP_MIN_FREE] = "heap_min",
+	[METRIC_HEAP_LARGEST] = "heap_block",
+	[METRIC_RSSI] = "rssi",
+	[METRIC_STACK_MIN] = "stack_min",
+	[METRIC_PUBACK_MS] = "puback_ms",
+	[METRIC_CONNECT_MS] = "connect_ms",
+};
+
+/* upper bin edges, a value above the last edge lands in the overflow bin */
+static const uint32_t metric_edges[METRICS_HISTOGRAMS][METRICS_HIST_BINS - 1] = {
+	[METRIC_PUBACK_MS - METRIC_FIRST_HISTOGRAM] = {50, 100, 250, 1000, 5000},
+	[METRIC_CONNECT_MS - METRIC_FIRST_HISTOGRAM] = {500, 1000, 2000, 5000, 10000},
+};
+
+/* written with 32-bit atomics only, an update never takes a lock or disables interrupts */
+static uint32_t metric_values[METRIC_FIRST_HISTOGRAM];
+static uint32_t metric_bins[METRICS_HISTOGRAMS][METRICS_HIST_BINS];
+static uint32_t metric_sums[METRICS_HISTOGRAMS];
+static uint32_t interval_ms = METRICS_INTERVAL_S * 1000;
+static volatile uint32_t due_ms = METRICS_INTERVAL_S * 1000;
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: metrics_add
+* Description  : count n events, safe from any task, cheaper than the log line it replaces
+* Arguments    : id - a counter, n
+* Return Value : none
+***********************************************************************************************************************/
+void metrics_add(metric_id_t id, uint32_t n)
+{
+	if (id < METRIC_FIRST_GAUGE)
+		__atomic_fetch_add(&metric_values[id], n, __ATOMIC_RELAXED);
+}
+
+void metrics_set(metric_id_t id, int32_t value)
+{
+	if ((id >= METRIC_FIRST_GAUGE) && (id < METRIC_FIRST_HISTOGRAM))
+		__atomic_store_n(&metric_values[id], (uint32_t)value, __ATOMIC_RELAXED);
+}
+
+/***********************************************************************************************************************
+* Function Name: metrics_observe
+* Description  : one value into its histogram bin and the sum. The bin and the sum are two updates, a snapshot
+*                between them is off by one value.
+* Arguments    : id - a histogram, value
+* Return Value : none
+***********************************************************************************************************************/
+void metrics_observe(metric_id_t id, uint32_t value)
+{
+	uint8_t hist;
+	uint8_t bin = 0;
+
+	if ((id < METRIC_FIRST_HISTOGRAM) || (id >= METRIC_COUNT))
+		return;
+	hist = id - METRIC_FIRST_HISTOGRAM;
+	while ((bin < METRICS_HIST_BINS - 1) && (value > metric_edges[hist][bin]))
+		bin++;
+	__atomic_fetch_add(&metric_bins[hist][bin], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&metric_sums[hist], value, __ATOMIC_RELAXED);
+}
+
+/***********************************************************************************************************************
+* Function Name: metrics_sample
+* Description  : read the gauges nobody pushes, heap, RSSI and stack headroom. Runs before a snapshot so their cost
+*                is paid once per report.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void metrics_sample(void)
+{
+	mem_heap_stats_t heap;
+	wifi_ap_record_t ap;
+	uint32_t stack_min = task_registry_stack_min(NULL);
+
+	mem_report_heap_stats(&heap);
+	metrics_set(METRIC_HEAP_FREE, heap.free);
+	metrics_set(METRIC_HEAP_MIN_FREE, heap.min_free);
+	metrics_set(METRIC_HEAP_LARGEST, heap.largest_block);
+	metrics_set(METRIC_RSSI, (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) ? ap.rssi : 0); // 0 when not associated
+	metrics_set(METRIC_STACK_MIN, (stack_min != UINT32_MAX) ? stack_min : 0);
+}
+
+void metrics_snapshot(metrics_snapshot_t *out)
+{
+	out->uptime_s = esp_timer_get_time() / 1000000;
+	for (uint8_t i = 0; i < METRIC_FIRST_HISTOGRAM; i++)
+		out->value[i] = __atomic_load_n(&metric_values[i], __ATOMIC_RELAXED);
+	for (uint8_t h = 0; h < METRICS_HISTOGRAMS; h++)
+	{
+		for (uint8_t b = 0; b < METRICS_HIST_BINS; b++)
+			out->bins[h][b] = __atomic_load_n(&metric_bins[h][b], __ATOMIC_RELAXED);
+		out->sum[h] = __atomic_load_n(&metric_sums[h], __ATOMIC_RELAXED);
+	}
+}
+
+const char *metrics_name(metric_id_t id)
+{
+	return (id < METRIC_COUNT) ? metric_names[id] : "";
+}
+
+/* METRICS_HIST_BINS - 1 edges, NULL for a counter or gauge */
+const uint32_t *metrics_edges(metric_id_t id)
+{
+	return ((id >= METRIC_FIRST_HISTOGRAM) && (id < METRIC_COUNT)) ? metric_edges[id - METRIC_FIRST_HISTOGRAM]
+																	: NULL;
+}
+
+/***********************************************************************************************************************
+* Function Name: metrics_due
+* Description  : the periodic report is due, polled by mqtt_send_task. Stays due while offline.
+* Arguments    : none
+* Return Value : true when metrics_rearm() and a report should follow
+***********************************************************************************************************************/
+bool metrics_due(void)
+{
+	return (int32_t)(usertimer_gettick() - due_ms) >= 0;
+}
+
+void metrics_rearm(void)
+{
+	due_ms = usertimer_gettick() + interval_ms;
+}
+
+/* report on the next poll, the interval restarts from there */
+void metrics_request(void)
+{
+	due_ms = usertimer_gettick();
+}
+
+bool metrics_set_interval(uint32_t interval_s)
+{
+	if ((interval_s < METRICS_INTERVAL_MIN_S) || (interval_s > METRICS_INTERVAL_MAX_S))
+		return false;
+	interval_ms = interval_s * 1000;
+	metrics_rearm();
+	APP_LOGI("metrics every %u s", interval_s);
+	return true;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,86 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef CONFIG_METRICS_INTERVAL_S
+#define METRICS_INTERVAL_S CONFIG_METRICS_INTERVAL_S
+#else
+#define METRICS_INTERVAL_S (300)
+#endif
+
+#define METRICS_INTERVAL_MIN_S (10)
+#define METRICS_INTERVAL_MAX_S (86400)
+#define METRICS_HIST_BINS (6) // five upper edges and the overflow bin
+
+#define METRIC_FIRST_GAUGE METRIC_HEAP_FREE
+#define METRIC_FIRST_HISTOGRAM METRIC_PUBACK_MS
+#define METRICS_HISTOGRAMS (METRIC_COUNT - METRIC_FIRST_HISTOGRAM)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* the registry, grouped by kind, a new metric also needs its name in metrics.c */
+typedef enum
+{
+	/* counters, totals since boot */
+	METRIC_WIFI_DISCONNECTS,
+	METRIC_MQTT_DISCONNECTS,
+	METRIC_MQTT_ERRORS,
+	METRIC_I2C_ERRORS,
+	/* gauges, set by metrics_sample() before each snapshot */
+	METRIC_HEAP_FREE,
+	METRIC_HEAP_MIN_FREE,
+	METRIC_HEAP_LARGEST,
+	METRIC_RSSI,
+	METRIC_STACK_MIN, /* least stack headroom of any registered task in bytes */
+	/* histograms */
+	METRIC_PUBACK_MS,
+	METRIC_CONNECT_MS,
+	METRIC_COUNT
+} metric_id_t;
+
+typedef struct
+{
+	uint32_t uptime_s;
+	uint32_t value[METRIC_FIRST_HISTOGRAM]; /* counter total, or gauge as int32_t */
+	uint32_t bins[METRICS_HISTOGRAMS][METRICS_HIST_BINS];
+	uint32_t sum[METRICS_HISTOGRAMS];
+} metrics_snapshot_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void metrics_add(metric_id_t id, uint32_t n);
+
+void metrics_set(metric_id_t id, int32_t value);
+
+void metrics_observe(metric_id_t id, uint32_t value);
+
+void metrics_sample(void);
+
+void metrics_snapshot(metrics_snapshot_t *out);
+
+const char *metrics_name(metric_id_t id);
+
+const uint32_t *metrics_edges(metric_id_t id);
+
+bool metrics_due(void);
+
+void metrics_rearm(void);
+
+void metrics_request(void);
+
+bool metrics_set_interval(uint32_t interval_s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,469 @@
+/*
+ * outbox.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_MQTT
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "outbox.h"
+#include "trace.h"
+#include "metrics.h"
+#include "mem_report.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+/* payload arena, a message takes adjacent blocks */
+#define OUTBOX_BLOCKS (OUTBOX_SLOTS)
+#define OUTBOX_BLOCK_BYTES (OUTBOX_BYTES / OUTBOX_BLOCKS)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef enum
+{
+	SLOT_FREE,
+	SLOT_QUEUED,
+	SLOT_SENDING,   /* in the mqtt client call, the payload must stay */
+	SLOT_IN_FLIGHT, /* QoS1 waiting for PUBACK */
+} slot_state_t;
+
+typedef struct
+{
+	char *data;
+	const char *topic; /* topics are static strings */
+	uint16_t len;
+	uint8_t block; /* first arena block */
+	uint8_t blocks;
+	uint8_t state;
+	uint8_t qos;
+	uint8_t prio;
+	uint16_t trace_id;
+	int msg_id;
+	uint32_t seq; /* put order, a resent message keeps its place */
+	uint32_t sent_ms;
+} outbox_slot_t;
+
+/* one message in the retained area, the payload follows padded to 4 bytes */
+typedef struct
+{
+	const char *topic; /* static buffer, the image is the same after deep sleep */
+	uint16_t len;
+	uint8_t qos;
+	uint8_t prio;
+} outbox_retained_t;
+
+/* survives deep sleep only, every other reset loads it from the image again */
+typedef struct
+{
+	uint16_t count;
+	uint16_t used;
+	uint8_t data[OUTBOX_RETAIN_BYTES] __attribute__((aligned(4)));
+} outbox_retain_area_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static outbox_slot_t slots[OUTBOX_SLOTS];
+static char arena[OUTBOX_BLOCKS][OUTBOX_BLOCK_BYTES] __attribute__((aligned(4)));
+static uint32_t arena_used; /* one bit per block */
+static SemaphoreHandle_t outbox_lock;
+static outbox_send_t outbox_send;
+static uint8_t window = OUTBOX_WINDOW;
+static uint16_t bytes;
+static uint32_t next_seq;
+static outbox_stats_t stats;
+static uint64_t ack_sum_ms;
+static RTC_DATA_ATTR outbox_retain_area_t retained;
+
+static int8_t outbox_next(void);
+static int8_t outbox_victim(outbox_prio_t prio);
+static uint8_t outbox_in_flight(void);
+static int8_t outbox_alloc(uint8_t blocks);
+static void outbox_release(outbox_slot_t *slot);
+static void outbox_requeue_stale(void);
+static void outbox_restore(void);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: outbox_init
+* Description  : the outbox keeps messages from outbox_put() until they are published, QoS1 ones until PUBACK.
+*                Boot time, only the first call counts. After standby it takes back what outbox_retain() kept.
+* Arguments    : send - mqtt client publish
+* Return Value : none
+***********************************************************************************************************************/
+void outbox_init(outbox_send_t send)
+{
+	static StaticSemaphore_t lock_buffer;
+
+	if (outbox_lock != NULL)
+		return;
+	outbox_lock = xSemaphoreCreateMutexStatic(&lock_buffer);
+	outbox_send = send;
+	mem_report_static("outbox", sizeof(slots) + sizeof(arena));
+	outbox_restore();
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_put
+* Description  : copy a message into the outbox arena. Over OUTBOX_BYTES or OUTBOX_SLOTS queued messages are dropped
+*                by the configured policy, in-flight ones never.
+* Arguments    : topic - static string, data, len, qos - 0 or 1, prio, trace_id - TRACE_ID_NONE when untraced
+* Return Value : false when the message was dropped
+***********************************************************************************************************************/
+bool outbox_put(const char *topic, const char *data, uint16_t len, uint8_t qos, outbox_prio_t prio, uint16_t trace_id)
+{
+	int8_t free_slot = -1;
+	int8_t block = -1;
+	uint8_t blocks = (len + OUTBOX_BLOCK_BYTES - 1) / OUTBOX_BLOCK_BYTES;
+
+	if ((outbox_lock == NULL) || (len == 0) || (len > OUTBOX_BYTES))
+		return false;
+	xSemaphoreTake(outbox_lock, portMAX_DELAY);
+	while (1)
+	{
+		for (int8_t i = 0; (i < OUTBOX_SLOTS) && (free_slot < 0); i++)
+		{
+			if (slots[i].state == SLOT_FREE)
+				free_slot = i;
+		}
+		if ((free_slot >= 0) && ((block = outbox_alloc(blocks)) >= 0))
+			break;
+		int8_t victim = outbox_victim(prio);
+		stats.dropped++;
+		if (victim < 0)
+		{
+			xSemaphoreGive(outbox_lock);
+			APP_LOGW("outbox full, dropped %u B prio %d", len, prio);
+			return false;
+		}
+		APP_LOGW("outbox full, dropped queued %u B prio %d", slots[victim].len, slots[victim].prio);
+		outbox_release(&slots[victim]);
+	}
+	arena_used |= ((1UL << blocks) - 1) << block;
+	memcpy(arena[block], data, len);
+	slots[free_slot] = (outbox_slot_t){
+		.data = arena[block],
+		.topic = topic,
+		.len = len,
+		.block = block,
+		.blocks = blocks,
+		.state = SLOT_QUEUED,
+		.qos = qos,
+		.prio = prio,
+		.trace_id = trace_id,
+		.msg_id = -1,
+		.seq = next_seq++,
+	};
+	bytes += len;
+	xSemaphoreGive(outbox_lock);
+	return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_pump
+* Description  : publish queued messages, highest priority first, while fewer than the window await PUBACK. Call it
+*                when connected, after outbox_put() and after every PUBACK. The client call runs unlocked, the mqtt
+*                task delivers PUBACKs meanwhile.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void outbox_pump(void)
+{
+	if (outbox_lock == NULL)
+		return;
+	xSemaphoreTake(outbox_lock, portMAX_DELAY);
+	outbox_requeue_stale();
+	while (1)
+	{
+		int8_t next = outbox_next();
+		if ((next < 0) || ((slots[next].qos > 0) && (outbox_in_flight() >= window)))
+			break;
+		outbox_slot_t *slot = &slots[next];
+		slot->state = SLOT_SENDING;
+		xSemaphoreGive(outbox_lock);
+		int msg_id = outbox_send(slot->topic, slot->data, slot->len, slot->qos);
+		xSemaphoreTake(outbox_lock, portMAX_DELAY);
+		if (msg_id < 0)
+		{
+			slot->state = SLOT_QUEUED; // client disconnected or its own outbox full, retried on the next pump
+			break;
+		}
+		stats.sent++;
+		trace_point(slot->trace_id, TRACE_MQTT_PUBLISHED);
+		if (slot->qos == 0)
+			outbox_release(slot);
+		else
+		{
+			slot->state = SLOT_IN_FLIGHT;
+			slot->msg_id = msg_id;
+			slot->sent_ms = usertimer_gettick();
+		}
+	}
+	xSemaphoreGive(outbox_lock);
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_acked
+* Description  : PUBACK from MQTT_EVENT_PUBLISHED, frees the message and a window place
+* Arguments    : msg_id
+* Return Value : none
+***********************************************************************************************************************/
+void outbox_acked(int msg_id)
+{
+	if (outbox_lock == NULL)
+		return;
+	xSemaphoreTake(outbox_lock, portMAX_DELAY);
+	for (uint8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if ((slots[i].state != SLOT_IN_FLIGHT) || (slots[i].msg_id != msg_id))
+			continue;
+		uint32_t latency_ms = usertimer_gettick() - slots[i].sent_ms;
+		stats.acked++;
+		ack_sum_ms += latency_ms;
+		if (latency_ms > stats.ack_max_ms)
+			stats.ack_max_ms = latency_ms;
+		metrics_observe(METRIC_PUBACK_MS, latency_ms);
+		trace_point(slots[i].trace_id, TRACE_MQTT_ACKED);
+		outbox_release(&slots[i]);
+		break;
+	}
+	xSemaphoreGive(outbox_lock);
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_expired
+* Description  : the mqtt client gave up on a QoS1 message, it goes back to the queue in its old place
+* Arguments    : msg_id
+* Return Value : none
+***********************************************************************************************************************/
+void outbox_expired(int msg_id)
+{
+	if (outbox_lock == NULL)
+		return;
+	xSemaphoreTake(outbox_lock, portMAX_DELAY);
+	for (uint8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if ((slots[i].state == SLOT_IN_FLIGHT) && (slots[i].msg_id == msg_id))
+		{
+			slots[i].state = SLOT_QUEUED;
+			stats.resent++;
+		}
+	}
+	xSemaphoreGive(outbox_lock);
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_set_window
+* Description  : QoS1 messages awaiting PUBACK at once, 1 is stop-and-wait
+* Arguments    : value - clamped to 1..OUTBOX_WINDOW_MAX
+* Return Value : none
+***********************************************************************************************************************/
+void outbox_set_window(uint8_t value)
+{
+	window = (value == 0) ? 1 : ((value > OUTBOX_WINDOW_MAX) ? OUTBOX_WINDOW_MAX : value);
+	APP_LOGI("outbox window %u", window);
+}
+
+bool outbox_empty(void)
+{
+	for (uint8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if (slots[i].state != SLOT_FREE)
+			return false;
+	}
+	return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_retain
+* Description  : standby_enter() hook, keeps the high priority messages not yet acknowledged in RTC memory, oldest
+*                first while OUTBOX_RETAIN_BYTES lasts. An in-flight one may reach the broker twice, QoS1 allows it.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void outbox_retain(void)
+{
+	int8_t prev = -1;
+
+	retained.count = 0;
+	retained.used = 0;
+	if (outbox_lock == NULL)
+		return;
+	xSemaphoreTake(outbox_lock, portMAX_DELAY);
+	while (1)
+	{
+		int8_t next = -1;
+
+		for (int8_t i = 0; i < OUTBOX_SLOTS; i++)
+		{
+			if ((slots[i].state == SLOT_FREE) || (slots[i].prio != OUTBOX_PRIO_HIGH) ||
+				((prev >= 0) && ((int32_t)(slots[i].seq - slots[prev].seq) <= 0)))
+				continue;
+			if ((next < 0) || ((int32_t)(slots[i].seq - slots[next].seq) < 0))
+				next = i;
+		}
+		if (next < 0)
+			break;
+		prev = next;
+		uint16_t size = sizeof(outbox_retained_t) + ((slots[next].len + 3) & ~3);
+		if (retained.used + size > OUTBOX_RETAIN_BYTES)
+			break;
+		outbox_retained_t *record = (outbox_retained_t *)&retained.data[retained.used];
+		*record = (outbox_retained_t){
+			.topic = slots[next].topic,
+			.len = slots[next].len,
+			.qos = slots[next].qos,
+			.prio = slots[next].prio,
+		};
+		memcpy(record + 1, slots[next].data, slots[next].len);
+		retained.used += size;
+		retained.count++;
+	}
+	xSemaphoreGive(outbox_lock);
+	APP_LOGI("outbox retained %u messages, %u B", retained.count, retained.used);
+}
+
+void outbox_stats(outbox_stats_t *out)
+{
+	if (outbox_lock == NULL)
+	{
+		memset(out, 0x00, sizeof(*out));
+		return;
+	}
+	xSemaphoreTake(outbox_lock, portMAX_DELAY);
+	*out = stats;
+	out->queued = 0;
+	for (uint8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if (slots[i].state == SLOT_QUEUED)
+			out->queued++;
+	}
+	out->in_flight = outbox_in_flight();
+	out->bytes = bytes;
+	out->window = window;
+	out->ack_avg_ms = (stats.acked > 0) ? (uint32_t)(ack_sum_ms / stats.acked) : 0;
+	xSemaphoreGive(outbox_lock);
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/* highest priority queued message, the oldest among equals */
+static int8_t outbox_next(void)
+{
+	int8_t next = -1;
+
+	for (int8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if (slots[i].state != SLOT_QUEUED)
+			continue;
+		if ((next < 0) || (slots[i].prio > slots[next].prio) ||
+			((slots[i].prio == slots[next].prio) && ((int32_t)(slots[i].seq - slots[next].seq) < 0)))
+			next = i;
+	}
+	return next;
+}
+
+/***********************************************************************************************************************
+* Function Name: outbox_victim
+* Description  : queued message to drop for a new one. Drop-oldest takes the oldest, drop-low-priority the lowest
+*                priority not above the new message, the oldest among equals.
+* Arguments    : prio - of the new message
+* Return Value : slot index, -1 when the new message is the one to drop
+***********************************************************************************************************************/
+static int8_t outbox_victim(outbox_prio_t prio)
+{
+	int8_t victim = -1;
+
+	for (int8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if ((slots[i].state != SLOT_QUEUED) || ((OUTBOX_DROP_OLDEST == 0) && (slots[i].prio > prio)))
+			continue;
+		if ((victim < 0) || ((OUTBOX_DROP_OLDEST == 0) && (slots[i].prio < slots[victim].prio)) ||
+			(((OUTBOX_DROP_OLDEST != 0) || (slots[i].prio == slots[victim].prio)) &&
+			 ((int32_t)(slots[i].seq - slots[victim].seq) < 0)))
+			victim = i;
+	}
+	return victim;
+}
+
+static uint8_t outbox_in_flight(void)
+{
+	uint8_t count = 0;
+
+	for (uint8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if (((slots[i].state == SLOT_SENDING) && (slots[i].qos > 0)) || (slots[i].state == SLOT_IN_FLIGHT))
+			count++;
+	}
+	return count;
+}
+
+/* first of a run of free arena blocks, -1 when none is long enough */
+static int8_t outbox_alloc(uint8_t blocks)
+{
+	uint32_t run = (1UL << blocks) - 1;
+
+	for (int8_t i = 0; i + blocks <= OUTBOX_BLOCKS; i++)
+	{
+		if ((arena_used & (run << i)) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static void outbox_release(outbox_slot_t *slot)
+{
+	bytes -= slot->len;
+	arena_used &= ~(((1UL << slot->blocks) - 1) << slot->block);
+	memset(slot, 0x00, sizeof(*slot));
+}
+
+/* queue what outbox_retain() kept before standby, the area is empty after any other reset */
+static void outbox_restore(void)
+{
+	uint16_t offset = 0;
+
+	for (uint16_t i = 0; (i < retained.count) && (offset + sizeof(outbox_retained_t) <= retained.used); i++)
+	{
+		const outbox_retained_t *record = (const outbox_retained_t *)&retained.data[offset];
+
+		outbox_put(record->topic, (const char *)(record + 1), record->len, record->qos, record->prio, TRACE_ID_NONE);
+		offset += sizeof(outbox_retained_t) + ((record->len + 3) & ~3);
+	}
+	if (retained.count > 0)
+		APP_LOGI("outbox restored %u messages", retained.count);
+	retained.count = 0;
+	retained.used = 0;
+}
+
+/* no PUBACK within OUTBOX_ACK_TIMEOUT_MS, e.g. the client dropped it over a reconnect */
+static void outbox_requeue_stale(void)
+{
+	uint32_t now = usertimer_gettick();
+
+	for (uint8_t i = 0; i < OUTBOX_SLOTS; i++)
+	{
+		if ((slots[i].state == SLOT_IN_FLIGHT) && (now - slots[i].sent_ms >= OUTBOX_ACK_TIMEOUT_MS))
+		{
+			APP_LOGW("msg %d not acknowledged, publishing again", slots[i].msg_id);
+			slots[i].state = SLOT_QUEUED;
+			stats.resent++;
+		}
+	}
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,83 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef CONFIG_OUTBOX_BYTES
+#define OUTBOX_BYTES CONFIG_OUTBOX_BYTES
+#define OUTBOX_WINDOW CONFIG_OUTBOX_WINDOW
+#else
+#define OUTBOX_BYTES (8192)
+#define OUTBOX_WINDOW (4)
+#endif
+
+#ifdef CONFIG_OUTBOX_DROP_OLDEST
+#define OUTBOX_DROP_OLDEST (1)
+#else
+#define OUTBOX_DROP_OLDEST (0) // drop the lowest priority first, the oldest among equals
+#endif
+
+#define OUTBOX_SLOTS (16) // also the payload arena blocks, at most 31
+#define OUTBOX_WINDOW_MAX (OUTBOX_SLOTS)
+#define OUTBOX_ACK_TIMEOUT_MS (30000) // unacknowledged this long, published again
+#define OUTBOX_RETAIN_BYTES (1536)    // RTC memory for high priority messages over standby
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+	OUTBOX_PRIO_LOW,    /* diagnostics */
+	OUTBOX_PRIO_NORMAL, /* button events */
+	OUTBOX_PRIO_HIGH,   /* hit reports, strike summaries */
+} outbox_prio_t;
+
+/* hands one message to the mqtt client, returns the message id or -1 */
+typedef int (*outbox_send_t)(const char *topic, const char *data, uint16_t len, uint8_t qos);
+
+typedef struct
+{
+	uint16_t queued;
+	uint16_t in_flight;
+	uint16_t bytes;
+	uint8_t window;
+	uint32_t sent;
+	uint32_t acked;
+	uint32_t dropped;
+	uint32_t resent;
+	uint32_t ack_avg_ms; /* publish to PUBACK */
+	uint32_t ack_max_ms;
+} outbox_stats_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void outbox_init(outbox_send_t send);
+
+bool outbox_put(const char *topic, const char *data, uint16_t len, uint8_t qos, outbox_prio_t prio, uint16_t trace_id);
+
+void outbox_pump(void);
+
+void outbox_acked(int msg_id);
+
+void outbox_expired(int msg_id);
+
+void outbox_set_window(uint8_t value);
+
+bool outbox_empty(void);
+
+void outbox_retain(void);
+
+void outbox_stats(outbox_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
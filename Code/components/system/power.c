@@ -0,0 +1,262 @@
+/*
+ * power.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "power.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_pm.h"
+#include "esp32/pm.h"
+#include "esp_sleep.h"
+#include "esp_attr.h"
+#include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#ifdef CONFIG_POWER_MIN_FREQ_MHZ
+#define POWER_MIN_FREQ_MHZ CONFIG_POWER_MIN_FREQ_MHZ
+#else
+#define POWER_MIN_FREQ_MHZ (80)
+#endif
+
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#define POWER_LIGHT_SLEEP (true)
+#else
+#define POWER_LIGHT_SLEEP (false)
+#endif
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef struct
+{
+	const char *name;
+#ifdef CONFIG_PM_ENABLE
+	esp_pm_lock_type_t type;
+	esp_pm_lock_handle_t handle;
+#endif
+	uint8_t depth;    /* nested power_lock() calls */
+	int64_t since_us; /* start of the current hold, or of the window when held across power_stats() */
+	int64_t held_us;  /* closed holds in the window */
+	uint32_t acquired;
+} power_lock_state_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+#ifdef CONFIG_PM_ENABLE
+#define POWER_LOCK_DEF(lock_name, lock_type) {.name = (lock_name), .type = (lock_type)}
+#else
+#define POWER_LOCK_DEF(lock_name, lock_type) {.name = (lock_name)}
+#endif
+
+static power_lock_state_t power_locks[POWER_LOCK_COUNT] = {
+	[POWER_LOCK_IMU] = POWER_LOCK_DEF("imu", ESP_PM_CPU_FREQ_MAX),
+	[POWER_LOCK_NET] = POWER_LOCK_DEF("net", ESP_PM_CPU_FREQ_MAX),
+	// LEDC_AUTO_CLK picks the APB clock, at 40 MHz or in light sleep the PWM and the fades stall
+	[POWER_LOCK_HAPTIC] = POWER_LOCK_DEF("haptic", ESP_PM_APB_FREQ_MAX),
+	[POWER_LOCK_LEDS] = POWER_LOCK_DEF("leds", ESP_PM_APB_FREQ_MAX),
+};
+/*
+ * light sleep wake: IMU INT1 and the buttons. ESP32 GPIOs wake on a level only, the drivers configure these pins with
+ * the level opposite to the idle one and re-arm the other level in their ISR (power_wake_rearm_isr).
+ */
+static const struct
+{
+	uint8_t gpio;
+	gpio_int_type_t level;
+} power_wake_pins[] = {
+	{GPIO_IMU_INT1, GPIO_INTR_HIGH_LEVEL},
+	{GPIO_USER_BUTTON, GPIO_INTR_LOW_LEVEL},
+	{GPIO_USER_BOOT_BUTTON, GPIO_INTR_LOW_LEVEL},
+};
+static portMUX_TYPE power_mux = portMUX_INITIALIZER_UNLOCKED;
+static int64_t window_start_us;
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: power_init
+* Description  : dynamic frequency scaling between POWER_MIN_FREQ_MHZ and the default CPU frequency, automatic light
+*                sleep when tickless idle is enabled, motion and the buttons wake it. Runs before the drivers configure
+*                their pins.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void power_init(void)
+{
+	window_start_us = esp_timer_get_time();
+	for (uint8_t i = 0; i < sizeof(power_wake_pins) / sizeof(power_wake_pins[0]); i++)
+		ESP_ERROR_CHECK(gpio_wakeup_enable(power_wake_pins[i].gpio, power_wake_pins[i].level));
+	ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#ifdef CONFIG_PM_ENABLE
+	esp_pm_config_esp32_t config = {
+		.max_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ,
+		.min_freq_mhz = POWER_MIN_FREQ_MHZ,
+		.light_sleep_enable = POWER_LIGHT_SLEEP,
+	};
+	esp_err_t err = esp_pm_configure(&config);
+
+	if (err != ESP_OK)
+	{
+		APP_LOGE("pm configure err %d", err);
+		return;
+	}
+	for (uint8_t i = 0; i < POWER_LOCK_COUNT; i++)
+		ESP_ERROR_CHECK(esp_pm_lock_create(power_locks[i].type, 0, power_locks[i].name, &power_locks[i].handle));
+	APP_LOGI("dfs %d-%d MHz, light sleep %d", POWER_MIN_FREQ_MHZ, CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ, POWER_LIGHT_SLEEP);
+#else
+	APP_LOGI("power management disabled");
+#endif
+}
+
+/***********************************************************************************************************************
+* Function Name: power_lock
+* Description  : keep the CPU at full speed until the matching power_unlock, calls nest
+* Arguments    : lock
+* Return Value : none
+***********************************************************************************************************************/
+void power_lock(power_lock_t lock)
+{
+	power_lock_state_t *state = &power_locks[lock];
+	bool first;
+
+	portENTER_CRITICAL(&power_mux);
+	first = (state->depth++ == 0);
+	if (first)
+	{
+		state->since_us = esp_timer_get_time();
+		state->acquired++;
+	}
+	portEXIT_CRITICAL(&power_mux);
+#ifdef CONFIG_PM_ENABLE
+	if (first && (state->handle != NULL))
+		esp_pm_lock_acquire(state->handle);
+#endif
+}
+
+void power_unlock(power_lock_t lock)
+{
+	power_lock_state_t *state = &power_locks[lock];
+	bool last = false;
+
+	portENTER_CRITICAL(&power_mux);
+	if (state->depth > 0)
+	{
+		last = (--state->depth == 0);
+		if (last)
+			state->held_us += esp_timer_get_time() - state->since_us;
+	}
+	portEXIT_CRITICAL(&power_mux);
+#ifdef CONFIG_PM_ENABLE
+	if (last && (state->handle != NULL))
+		esp_pm_lock_release(state->handle);
+#endif
+}
+
+/***********************************************************************************************************************
+* Function Name: power_wifi_connected
+* Description  : called on every got-IP, the saved wifi_manager settings may still carry WIFI_PS_NONE
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void power_wifi_connected(void)
+{
+	esp_err_t err = esp_wifi_set_ps(POWER_WIFI_PS);
+
+	if (err != ESP_OK)
+		APP_LOGE("wifi power save err %d", err);
+}
+
+/***********************************************************************************************************************
+* Function Name: power_wake_rearm_isr
+* Description  : from the pin's ISR, trigger on the level the pin is not at, so both edges interrupt and wake the chip
+*                from light sleep like GPIO_INTR_ANYEDGE would while awake
+* Arguments    : gpio
+* Return Value : level the pin is at
+***********************************************************************************************************************/
+bool IRAM_ATTR power_wake_rearm_isr(uint8_t gpio)
+{
+	bool level = (gpio_ll_get_level(&GPIO, gpio) != 0);
+
+	gpio_ll_set_intr_type(&GPIO, gpio, level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+	return level;
+}
+
+/***********************************************************************************************************************
+* Function Name: power_stats
+* Description  : measured lock duty since the previous call, then start a new window
+* Arguments    : stats - output
+* Return Value : none
+***********************************************************************************************************************/
+void power_stats(power_stats_t *stats)
+{
+	int64_t now = esp_timer_get_time();
+	int64_t window_us;
+
+	portENTER_CRITICAL(&power_mux);
+	window_us = now - window_start_us;
+	window_start_us = now;
+	for (uint8_t i = 0; i < POWER_LOCK_COUNT; i++)
+	{
+		power_lock_state_t *state = &power_locks[i];
+		int64_t held_us = state->held_us;
+
+		if (state->depth > 0)
+		{
+			held_us += now - state->since_us;
+			state->since_us = now;
+		}
+		stats->locks[i].acquired = state->acquired;
+		stats->locks[i].held_ms = held_us / 1000;
+		stats->locks[i].duty_permille = (window_us > 0) ? (held_us * 1000 / window_us) : 0;
+		state->held_us = 0;
+		state->acquired = 0;
+	}
+	portEXIT_CRITICAL(&power_mux);
+	stats->window_ms = window_us / 1000;
+	stats->light_sleep = POWER_LIGHT_SLEEP;
+	stats->min_freq_mhz = POWER_MIN_FREQ_MHZ;
+	stats->max_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+}
+
+/***********************************************************************************************************************
+* Function Name: power_log
+* Description  : log a power_stats() window, with CONFIG_PM_PROFILING the IDF per-mode residency follows on stdout
+* Arguments    : stats
+* Return Value : none
+***********************************************************************************************************************/
+void power_log(const power_stats_t *stats)
+{
+	for (uint8_t i = 0; i < POWER_LOCK_COUNT; i++)
+	{
+		APP_LOGI("pm lock %-6s %u.%u%% %u ms %u holds in %u ms", power_locks[i].name,
+				 stats->locks[i].duty_permille / 10, stats->locks[i].duty_permille % 10, stats->locks[i].held_ms,
+				 stats->locks[i].acquired, stats->window_ms);
+	}
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_PM_PROFILING)
+	esp_pm_dump_locks(stdout);
+#endif
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
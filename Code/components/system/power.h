@@ -0,0 +1,69 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/* modem sleep once associated, the listen interval is set in wifi_manager (DEFAULT_STA_LISTEN_INTERVAL) */
+#define POWER_WIFI_PS WIFI_PS_MAX_MODEM
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/*
+ * Application PM locks. The CPU locks pin the CPU at its maximum frequency while held, the output locks keep the APB
+ * clock the LEDC timers run from, which also rules out light sleep. Outside of them the scheduler scales down and,
+ * with tickless idle, light-sleeps between events.
+ */
+typedef enum
+{
+	POWER_LOCK_IMU,    /* FIFO burst and DSP */
+	POWER_LOCK_NET,    /* TLS handshake and publish */
+	POWER_LOCK_HAPTIC, /* a haptic pattern is playing */
+	POWER_LOCK_LEDS,   /* an LED is lit or animating */
+	POWER_LOCK_COUNT
+} power_lock_t;
+
+typedef struct
+{
+	uint32_t acquired; /* acquisitions in the window */
+	uint32_t held_ms;
+	uint16_t duty_permille;
+} power_lock_stats_t;
+
+typedef struct
+{
+	uint32_t window_ms; /* since the previous power_stats() */
+	bool light_sleep;   /* automatic light sleep configured */
+	uint16_t min_freq_mhz;
+	uint16_t max_freq_mhz;
+	power_lock_stats_t locks[POWER_LOCK_COUNT];
+} power_stats_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void power_init(void);
+
+void power_lock(power_lock_t lock);
+
+void power_unlock(power_lock_t lock);
+
+void power_wifi_connected(void);
+
+bool power_wake_rearm_isr(uint8_t gpio);
+
+void power_stats(power_stats_t *stats);
+
+void power_log(const power_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+/*
+ * prov_store.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "prov_store.h"
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "esp32/rom/crc.h"
+#include "mbedtls/base64.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define PROV_MAGIC (0x564F5250) // "PROV"
+#define PROV_VERSION (1)
+#define PROV_ALIGN(len) (((len) + 3) & ~3)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+/* partition image: header, then one record per item, each record padded to 4 bytes */
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t count;
+	uint32_t length; /* record bytes after the header */
+	uint32_t crc;    /* crc32 of the record bytes */
+} prov_header_t;
+
+typedef struct
+{
+	uint16_t type; /* prov_item_t */
+	uint16_t len;
+} prov_record_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static const esp_partition_t *prov_partition = NULL;
+static const uint8_t *prov_map = NULL;
+static spi_flash_mmap_handle_t prov_map_handle;
+static prov_blob_t prov_items[PROV_ITEM_COUNT];
+static bool prov_valid = false;
+static uint32_t unlock_until_ms = 0;
+static const char *const prov_names[PROV_ITEM_COUNT] = {
+	[PROV_ITEM_URI] = "uri",
+	[PROV_ITEM_CLIENT_ID] = "client_id",
+	[PROV_ITEM_CA] = "ca",
+	[PROV_ITEM_CERT] = "cert",
+	[PROV_ITEM_KEY] = "key",
+};
+
+static bool prov_parse(void);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: prov_store_init
+* Description  : map the provisioning partition into the data cache, items are read in place from then on
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void prov_store_init(void)
+{
+	esp_err_t err;
+
+	prov_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, PROV_PARTITION_SUBTYPE, PROV_PARTITION_LABEL);
+	if (prov_partition == NULL)
+	{
+		APP_LOGE("no %s partition", PROV_PARTITION_LABEL);
+		return;
+	}
+	err = esp_partition_mmap(prov_partition, 0, prov_partition->size, SPI_FLASH_MMAP_DATA, (const void **)&prov_map,
+							 &prov_map_handle);
+	if (err != ESP_OK)
+	{
+		APP_LOGE("prov mmap err %d", err);
+		return;
+	}
+	prov_valid = prov_parse();
+	if (prov_valid == true)
+		APP_LOGI("provisioned: %s, %s", (const char *)prov_items[PROV_ITEM_URI].data,
+				 (const char *)prov_items[PROV_ITEM_CLIENT_ID].data);
+	else
+		APP_LOGI("not provisioned, built-in identity");
+}
+
+/***********************************************************************************************************************
+* Function Name: prov_store_get
+* Description  : item in place in flash, valid until the next prov_store_write()
+* Arguments    : item, blob - output
+* Return Value : false when the store is empty or the item is missing
+***********************************************************************************************************************/
+bool prov_store_get(prov_item_t item, prov_blob_t *blob)
+{
+	if ((prov_valid == false) || (item >= PROV_ITEM_COUNT) || (prov_items[item].len == 0))
+		return false;
+	*blob = prov_items[item];
+	return true;
+}
+
+bool prov_store_provisioned(void)
+{
+	return prov_valid;
+}
+
+void prov_store_unlock(uint32_t seconds)
+{
+	unlock_until_ms = usertimer_gettick() + seconds * 1000;
+	APP_LOGI("provisioning open for %u s", seconds);
+}
+
+/***********************************************************************************************************************
+* Function Name: prov_store_writable
+* Description  : an empty store takes one write, a provisioned device only within an unlock window
+* Arguments    : none
+* Return Value : true when prov_store_write() is allowed
+***********************************************************************************************************************/
+bool prov_store_writable(void)
+{
+	return (prov_valid == false) || ((int32_t)(unlock_until_ms - usertimer_gettick()) > 0);
+}
+
+/***********************************************************************************************************************
+* Function Name: prov_store_write
+* Description  : replace the whole store. Items already handed out point to stale flash afterwards, the caller
+*                restarts.
+* Arguments    : items - every item is required
+* Return Value : true when written
+***********************************************************************************************************************/
+bool prov_store_write(const prov_blob_t items[PROV_ITEM_COUNT])
+{
+	prov_header_t header = {.magic = PROV_MAGIC, .version = PROV_VERSION, .count = PROV_ITEM_COUNT};
+	uint8_t *image;
+	uint32_t offset = sizeof(header);
+	esp_err_t err;
+
+	if ((prov_partition == NULL) || (prov_store_writable() == false))
+		return false;
+	for (uint8_t i = 0; i < PROV_ITEM_COUNT; i++)
+	{
+		if ((items[i].data == NULL) || (items[i].len == 0) || (items[i].len > PROV_ITEM_MAX_LEN))
+			return false;
+		header.length += sizeof(prov_record_t) + PROV_ALIGN(items[i].len);
+	}
+	if (sizeof(header) + header.length > prov_partition->size)
+		return false;
+	image = calloc(1, sizeof(header) + header.length);
+	if (image == NULL)
+		return false;
+	for (uint8_t i = 0; i < PROV_ITEM_COUNT; i++)
+	{
+		prov_record_t record = {.type = i, .len = items[i].len};
+
+		memcpy(image + offset, &record, sizeof(record));
+		memcpy(image + offset + sizeof(record), items[i].data, items[i].len);
+		offset += sizeof(record) + PROV_ALIGN(items[i].len);
+	}
+	header.crc = crc32_le(0, image + sizeof(header), header.length);
+	memcpy(image, &header, sizeof(header));
+
+	err = esp_partition_erase_range(prov_partition, 0, prov_partition->size);
+	if (err == ESP_OK)
+		err = esp_partition_write(prov_partition, 0, image, offset);
+	free(image);
+	prov_valid = false;
+	unlock_until_ms = usertimer_gettick();
+	if (err != ESP_OK)
+	{
+		APP_LOGE("prov write err %d", err);
+		return false;
+	}
+	APP_LOGI("provisioning stored, %u bytes", offset);
+	return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: prov_pem_to_der
+* Description  : base64 body between the BEGIN and END lines of the first PEM block
+* Arguments    : pem, der - output, der_size
+* Return Value : DER length, 0 when the block is malformed or does not fit
+***********************************************************************************************************************/
+size_t prov_pem_to_der(const char *pem, uint8_t *der, size_t der_size)
+{
+	const char *body = strstr(pem, "-----BEGIN ");
+	const char *end;
+	size_t der_len = 0;
+
+	if ((body == NULL) || ((body = strstr(body + 11, "-----\n")) == NULL) || ((end = strstr(body, "-----END ")) == NULL))
+		return 0;
+	body += 6;
+	if (mbedtls_base64_decode(der, der_size, &der_len, (const unsigned char *)body, end - body) != 0)
+		return 0;
+	return der_len;
+}
+
+const char *prov_item_name(prov_item_t item)
+{
+	return (item < PROV_ITEM_COUNT) ? prov_names[item] : "";
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/***********************************************************************************************************************
+* Function Name: prov_parse
+* Description  : check the mapped image and index its records
+* Arguments    : none
+* Return Value : true when every item is present
+***********************************************************************************************************************/
+static bool prov_parse(void)
+{
+	const prov_header_t *header = (const prov_header_t *)prov_map;
+	uint32_t offset = 0;
+
+	memset(prov_items, 0x00, sizeof(prov_items));
+	if ((header->magic != PROV_MAGIC) || (header->version != PROV_VERSION) ||
+		(header->length > prov_partition->size - sizeof(*header)))
+		return false;
+	if (crc32_le(0, prov_map + sizeof(*header), header->length) != header->crc)
+	{
+		APP_LOGE("prov crc mismatch");
+		return false;
+	}
+	while (offset + sizeof(prov_record_t) <= header->length)
+	{
+		const prov_record_t *record = (const prov_record_t *)(prov_map + sizeof(*header) + offset);
+
+		offset += sizeof(*record);
+		if (offset + record->len > header->length)
+			return false;
+		if (record->type < PROV_ITEM_COUNT)
+		{
+			prov_items[record->type].data = (const uint8_t *)record + sizeof(*record);
+			prov_items[record->type].len = record->len;
+		}
+		offset += PROV_ALIGN(record->len);
+	}
+	for (uint8_t i = 0; i < PROV_ITEM_COUNT; i++)
+	{
+		if (prov_items[i].len == 0)
+			return false;
+	}
+	/* strings are stored with their terminator */
+	return (prov_items[PROV_ITEM_URI].data[prov_items[PROV_ITEM_URI].len - 1] == '\0') &&
+		   (prov_items[PROV_ITEM_CLIENT_ID].data[prov_items[PROV_ITEM_CLIENT_ID].len - 1] == '\0');
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
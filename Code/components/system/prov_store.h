@@ -0,0 +1,62 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define PROV_PARTITION_LABEL "prov"
+#define PROV_PARTITION_SUBTYPE (0x40)
+#define PROV_ITEM_MAX_LEN (4096)
+#define PROV_UNLOCK_S (300) // overwrite window opened by the service chord
+#define PROV_BODY_MAX (16384) // POST /prov JSON, three PEM items
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* per-device identity and endpoint, certificates and key in DER */
+typedef enum
+{
+	PROV_ITEM_URI,       /* broker URI, NUL terminated */
+	PROV_ITEM_CLIENT_ID, /* MQTT client ID, NUL terminated */
+	PROV_ITEM_CA,        /* broker CA certificate */
+	PROV_ITEM_CERT,      /* device certificate */
+	PROV_ITEM_KEY,       /* device private key, RSA or ECDSA P-256 */
+	PROV_ITEM_COUNT
+} prov_item_t;
+
+/* points into the memory-mapped partition after prov_store_get(), into the caller's buffers for prov_store_write() */
+typedef struct
+{
+	const uint8_t *data;
+	uint16_t len;
+} prov_blob_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void prov_store_init(void);
+
+bool prov_store_get(prov_item_t item, prov_blob_t *blob);
+
+bool prov_store_provisioned(void);
+
+void prov_store_unlock(uint32_t seconds);
+
+bool prov_store_writable(void);
+
+bool prov_store_write(const prov_blob_t items[PROV_ITEM_COUNT]);
+
+size_t prov_pem_to_der(const char *pem, uint8_t *der, size_t der_size);
+
+const char *prov_item_name(prov_item_t item);
+
+#ifdef __cplusplus
+}
+#endif
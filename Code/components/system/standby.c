@@ -0,0 +1,247 @@
+/*
+ * standby.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "standby.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "driver/rtc_io.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define STANDBY_RTC_MAGIC (0x48414D52) // "HAMR"
+#define STANDBY_LOG_FLUSH_MS (50)      // let log_task print the last lines
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+/* survives deep sleep only, every other reset loads it from the image again */
+typedef struct
+{
+	uint32_t magic;
+	uint32_t sleeps;
+	uint32_t idle_s;
+	bool wifi_valid;
+	uint8_t bssid[6];
+	uint8_t channel;
+	bool event_pending; /* a hit report that was not published before sleeping */
+	sensor_data_t event;
+} standby_rtc_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static RTC_DATA_ATTR standby_rtc_t rtc_state;
+static bool warm_boot = false;
+static volatile uint32_t last_activity_ms;
+static int32_t wake_ms = -1;
+static standby_prepare_t prepare_list[STANDBY_MAX_PREPARE];
+static uint8_t prepare_count;
+static standby_hold_t hold_list[STANDBY_MAX_HOLD];
+static uint8_t hold_count;
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: standby_init
+* Description  : called first in app_main, a wake from standby restores the retained state
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void standby_init(void)
+{
+	esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+
+	last_activity_ms = usertimer_gettick();
+	warm_boot = (cause != ESP_SLEEP_WAKEUP_UNDEFINED) && (rtc_state.magic == STANDBY_RTC_MAGIC);
+	if (warm_boot == false)
+	{
+		memset(&rtc_state, 0x00, sizeof(rtc_state));
+		rtc_state.magic = STANDBY_RTC_MAGIC;
+		rtc_state.idle_s = STANDBY_IDLE_S;
+		return;
+	}
+	rtc_gpio_deinit(GPIO_IMU_INT1);
+	rtc_gpio_deinit(GPIO_USER_BUTTON);
+	if (rtc_state.event_pending == true)
+	{
+		deive_data.sensor = rtc_state.event;
+		deive_data.sensor.hammer_detect = kHammer_Active;
+		rtc_state.event_pending = false;
+	}
+	APP_LOGI("wake %d from standby #%u, wifi hint %d, event %d", cause, rtc_state.sleeps, rtc_state.wifi_valid,
+			 deive_data.sensor.hammer_detect);
+}
+
+bool standby_warm_boot(void)
+{
+	return warm_boot;
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_activity
+* Description  : restart the idle period, safe from an ISR
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void IRAM_ATTR standby_activity(void)
+{
+	last_activity_ms = (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_set_idle
+* Description  : idle period before standby, kept across standby cycles
+* Arguments    : idle_s - 0 never goes to standby
+* Return Value : none
+***********************************************************************************************************************/
+void standby_set_idle(uint32_t idle_s)
+{
+	rtc_state.idle_s = idle_s;
+	standby_activity();
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_due
+* Description  : the idle period has run out, the hammer is not held (buttons_hold is cleared on buttonUp) and no
+*                hold hook defers it. A hold defers standby by STANDBY_HOLD_MAX_S at most.
+* Arguments    : none
+* Return Value : true when standby_enter() should be called
+***********************************************************************************************************************/
+bool standby_due(void)
+{
+	uint32_t idle_ms;
+
+	if ((rtc_state.idle_s == 0) || (deive_data.sensor.buttons_hold == true))
+		return false;
+	idle_ms = usertimer_gettick() - last_activity_ms;
+	if (idle_ms < rtc_state.idle_s * 1000)
+		return false;
+	if (idle_ms >= (rtc_state.idle_s + STANDBY_HOLD_MAX_S) * 1000)
+		return true;
+	for (uint8_t i = 0; i < hold_count; i++)
+	{
+		if (hold_list[i]() == true)
+			return false;
+	}
+	return true;
+}
+
+void standby_register_prepare(standby_prepare_t prepare)
+{
+	if (prepare_count < STANDBY_MAX_PREPARE)
+		prepare_list[prepare_count++] = prepare;
+}
+
+void standby_register_hold(standby_hold_t hold)
+{
+	if (hold_count < STANDBY_MAX_HOLD)
+		hold_list[hold_count++] = hold;
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_enter
+* Description  : retain the warm state, arm motion (ext0, IMU INT1 high) and the user button (ext1, low) as wake
+*                sources and power down. Does not return.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void standby_enter(void)
+{
+	if (deive_data.sensor.hammer_detect == kHammer_Active)
+	{
+		rtc_state.event = deive_data.sensor;
+		rtc_state.event_pending = true;
+	}
+	rtc_state.sleeps++;
+	APP_LOGI("standby after %u s idle, event retained %d", rtc_state.idle_s, rtc_state.event_pending);
+	for (uint8_t i = 0; i < prepare_count; i++)
+		prepare_list[i]();
+
+	esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO); // light sleep only, power_init
+	rtc_gpio_pullup_dis(GPIO_IMU_INT1);
+	rtc_gpio_pulldown_en(GPIO_IMU_INT1);
+	ESP_ERROR_CHECK(esp_sleep_enable_ext0_wakeup(GPIO_IMU_INT1, 1));
+	rtc_gpio_pulldown_dis(GPIO_USER_BUTTON);
+	rtc_gpio_pullup_en(GPIO_USER_BUTTON);
+	ESP_ERROR_CHECK(esp_sleep_enable_ext1_wakeup(1ULL << GPIO_USER_BUTTON, ESP_EXT1_WAKEUP_ALL_LOW));
+	esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON); // keeps the RTC pull resistors
+
+	esp_wifi_stop();
+	vTaskDelay(STANDBY_LOG_FLUSH_MS / portTICK_PERIOD_MS);
+	esp_deep_sleep_start();
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_save_wifi
+* Description  : remember the access point of the current connection, the wake path connects to it without a scan
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void standby_save_wifi(void)
+{
+	wifi_ap_record_t ap;
+
+	if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK)
+		return;
+	memcpy(rtc_state.bssid, ap.bssid, sizeof(rtc_state.bssid));
+	rtc_state.channel = ap.primary;
+	rtc_state.wifi_valid = true;
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_wifi_hint
+* Description  : access point retained over standby, only after a warm boot
+* Arguments    : bssid - 6 bytes out, channel - out
+* Return Value : true when a hint is available
+***********************************************************************************************************************/
+bool standby_wifi_hint(uint8_t *bssid, uint8_t *channel)
+{
+	if ((warm_boot == false) || (rtc_state.wifi_valid == false))
+		return false;
+	memcpy(bssid, rtc_state.bssid, sizeof(rtc_state.bssid));
+	*channel = rtc_state.channel;
+	return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: standby_first_publish
+* Description  : call after every publish, the first one after boot is timed from app start (bootloader excluded)
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void standby_first_publish(void)
+{
+	if (wake_ms >= 0)
+		return;
+	wake_ms = (int32_t)(esp_timer_get_time() / 1000);
+	APP_LOGI("%s boot to first publish %d ms", warm_boot ? "warm" : "cold", wake_ms);
+}
+
+int32_t standby_wake_ms(void)
+{
+	return wake_ms;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,62 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef CONFIG_STANDBY_IDLE_S
+#define STANDBY_IDLE_S CONFIG_STANDBY_IDLE_S
+#else
+#define STANDBY_IDLE_S (600)
+#endif
+
+#define STANDBY_MAX_PREPARE (4)
+#define STANDBY_MAX_HOLD (2)
+#define STANDBY_HOLD_MAX_S (60) // longest a hold defers standby past the idle period
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* runs in standby_enter() before the chip powers down, e.g. to arm the sensor wake-up interrupt */
+typedef void (*standby_prepare_t)(void);
+
+/* polled by standby_due() once the idle period ran out, true defers standby, e.g. while messages await a PUBACK */
+typedef bool (*standby_hold_t)(void);
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void standby_init(void);
+
+bool standby_warm_boot(void);
+
+void standby_activity(void);
+
+void standby_set_idle(uint32_t idle_s);
+
+bool standby_due(void);
+
+void standby_register_prepare(standby_prepare_t prepare);
+
+void standby_register_hold(standby_hold_t hold);
+
+void standby_enter(void);
+
+void standby_save_wifi(void);
+
+bool standby_wifi_hint(uint8_t *bssid, uint8_t *channel);
+
+void standby_first_publish(void);
+
+int32_t standby_wake_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
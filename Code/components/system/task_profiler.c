@@ -0,0 +1,181 @@
+/*
+ * task_profiler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "task_profiler.h"
+#include "task_registry.h"
+#include "mem_report.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#if !defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) || !defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+#error "task_profiler needs CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS"
+#endif
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef struct
+{
+	TaskHandle_t handle;
+	uint32_t run_time;
+} task_run_time_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static SemaphoreHandle_t profiler_lock;
+static TaskStatus_t task_status[TASK_PROFILER_MAX_TASKS];
+static task_run_time_t last_run_time[TASK_PROFILER_MAX_TASKS];
+static uint8_t last_count;
+static uint32_t last_total;
+static int64_t last_sample_us;
+static uint32_t last_wakes[TASK_ID_COUNT];
+static task_profile_t profile_snapshot;
+
+static uint32_t task_profiler_last_run_time(TaskHandle_t handle);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: task_profiler_init
+* Description  : the first sample covers the time since boot
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void task_profiler_init(void)
+{
+	static StaticSemaphore_t lock_buffer;
+
+	if (profiler_lock != NULL)
+		return;
+	profiler_lock = xSemaphoreCreateMutexStatic(&lock_buffer);
+	mem_report_static("task_profiler", sizeof(task_status) + sizeof(last_run_time) + sizeof(profile_snapshot));
+}
+
+/***********************************************************************************************************************
+* Function Name: task_profiler_acquire
+* Description  : per-task CPU share, stack high-water mark and wake-up rate since the previous sample. The run time
+*                counter is the 32-bit esp_timer clock, sample at least once an hour to stay inside one wrap.
+*                The snapshot is static and stays valid until task_profiler_release().
+* Arguments    : none
+* Return Value : snapshot, NULL when the profiler is busy or more tasks exist than TASK_PROFILER_MAX_TASKS
+***********************************************************************************************************************/
+const task_profile_t *task_profiler_acquire(void)
+{
+	task_profile_t *profile = &profile_snapshot;
+	uint32_t total;
+	uint32_t window;
+	int64_t now_us = esp_timer_get_time();
+	UBaseType_t count;
+
+	if ((profiler_lock == NULL) || (xSemaphoreTake(profiler_lock, 100 / portTICK_PERIOD_MS) != pdTRUE))
+		return NULL;
+	count = uxTaskGetSystemState(task_status, TASK_PROFILER_MAX_TASKS, &total);
+	if (count == 0)
+	{
+		xSemaphoreGive(profiler_lock);
+		APP_LOGE("more than %d tasks", TASK_PROFILER_MAX_TASKS);
+		return NULL;
+	}
+	window = total - last_total;
+	if (window == 0)
+		window = 1;
+	memset(profile, 0x00, sizeof(task_profile_t));
+	profile->window_ms = (uint32_t)((now_us - last_sample_us) / 1000);
+	profile->count = count;
+	for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+		profile->load_permille[core] = 1000;
+
+	for (UBaseType_t i = 0; i < count; i++)
+	{
+		TaskStatus_t *status = &task_status[i];
+		task_profile_entry_t *entry = &profile->tasks[i];
+		BaseType_t affinity = xTaskGetAffinity(status->xHandle);
+		task_id_t id = task_registry_find(status->xHandle);
+		uint32_t busy = status->ulRunTimeCounter - task_profiler_last_run_time(status->xHandle);
+
+		strncpy(entry->name, status->pcTaskName, sizeof(entry->name) - 1);
+		entry->core = (affinity == tskNO_AFFINITY) ? TASK_PROFILER_CORE_ANY : (uint8_t)affinity;
+		entry->priority = status->uxCurrentPriority;
+		entry->cpu_permille = (uint16_t)(((uint64_t)busy * 1000) / window);
+		entry->stack_free = status->usStackHighWaterMark;
+		entry->wakes_per_s = TASK_PROFILER_WAKES_UNKNOWN;
+		if ((id != TASK_ID_COUNT) && (profile->window_ms > 0))
+		{
+			uint32_t wakes = task_registry_wakes(id);
+			entry->wakes_per_s = (int32_t)(((uint64_t)(wakes - last_wakes[id]) * 1000) / profile->window_ms);
+			last_wakes[id] = wakes;
+		}
+		for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+		{
+			if (status->xHandle == xTaskGetIdleTaskHandleForCPU(core))
+				profile->load_permille[core] = (entry->cpu_permille < 1000) ? (1000 - entry->cpu_permille) : 0;
+		}
+	}
+
+	for (UBaseType_t i = 0; i < count; i++)
+	{
+		last_run_time[i].handle = task_status[i].xHandle;
+		last_run_time[i].run_time = task_status[i].ulRunTimeCounter;
+	}
+	last_count = count;
+	last_total = total;
+	last_sample_us = now_us;
+	return profile;
+}
+
+void task_profiler_release(void)
+{
+	xSemaphoreGive(profiler_lock);
+}
+
+/***********************************************************************************************************************
+* Function Name: task_profiler_log
+* Description  : one console line per task
+* Arguments    : profile
+* Return Value : none
+***********************************************************************************************************************/
+void task_profiler_log(const task_profile_t *profile)
+{
+	APP_LOGI("profile %d ms, core0 %d.%d%%, core1 %d.%d%%", profile->window_ms,
+			 profile->load_permille[0] / 10, profile->load_permille[0] % 10,
+			 profile->load_permille[portNUM_PROCESSORS - 1] / 10, profile->load_permille[portNUM_PROCESSORS - 1] % 10);
+	for (uint8_t i = 0; i < profile->count; i++)
+	{
+		const task_profile_entry_t *entry = &profile->tasks[i];
+		APP_LOGI("%-16s core %3d prio %2d cpu %3d.%d%% stack free %5d wakes/s %d", entry->name,
+				 (entry->core == TASK_PROFILER_CORE_ANY) ? -1 : entry->core, entry->priority,
+				 entry->cpu_permille / 10, entry->cpu_permille % 10, entry->stack_free, entry->wakes_per_s);
+	}
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/* previous run time of a task, tasks created since then start from zero */
+static uint32_t task_profiler_last_run_time(TaskHandle_t handle)
+{
+	for (uint8_t i = 0; i < last_count; i++)
+	{
+		if (last_run_time[i].handle == handle)
+			return last_run_time[i].run_time;
+	}
+	return 0;
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TASK_PROFILER_MAX_TASKS (24)
+#define TASK_PROFILER_CORE_ANY (0xFF)
+#define TASK_PROFILER_WAKES_UNKNOWN (-1) /* only registry tasks count their wake-ups */
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+	char name[configMAX_TASK_NAME_LEN];
+	uint8_t core;          /* 0, 1 or TASK_PROFILER_CORE_ANY */
+	uint8_t priority;
+	uint16_t cpu_permille; /* share of one core over the window */
+	uint32_t stack_free;   /* high-water mark, bytes never touched */
+	int32_t wakes_per_s;
+} task_profile_entry_t;
+
+typedef struct
+{
+	uint32_t window_ms;                          /* time since the previous sample */
+	uint16_t load_permille[portNUM_PROCESSORS]; /* busy share per core */
+	uint8_t count;
+	task_profile_entry_t tasks[TASK_PROFILER_MAX_TASKS];
+} task_profile_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void task_profiler_init(void);
+
+const task_profile_t *task_profiler_acquire(void);
+
+void task_profiler_release(void);
+
+void task_profiler_log(const task_profile_t *profile);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,202 @@
+/*
+ * task_registry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_SYSTEM
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "task_registry.h"
+#include "mem_report.h"
+#include "esp_attr.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define TASK_STACK_PLANT (6 * 1024)
+#define TASK_STACK_IMU (4 * 1024)
+#define TASK_STACK_MQTT_SEND (3 * 1024)
+#define TASK_STACK_HAPTIC (2 * 1024)
+#define TASK_STACK_LOG (3 * 1024)
+#define TASK_STACK_JOB (4 * 1024)
+
+/* stack and TCB live in .bss, a task never touches the heap to start */
+#define TASK_STATIC(task, size) static StackType_t task##_stack[size]; static StaticTask_t task##_tcb
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+TASK_STATIC(plant, TASK_STACK_PLANT);
+TASK_STATIC(imu, TASK_STACK_IMU);
+TASK_STATIC(mqtt_send, TASK_STACK_MQTT_SEND);
+TASK_STATIC(haptic, TASK_STACK_HAPTIC);
+TASK_STATIC(log, TASK_STACK_LOG);
+TASK_STATIC(job, TASK_STACK_JOB);
+
+/* every application task, one place to move a task to another core or priority */
+static const task_spec_t task_specs[TASK_ID_COUNT] = {
+	/*                      name              stack                 prio core           buffers */
+	[TASK_ID_PLANT] =     {"plant_task",     TASK_STACK_PLANT,     2,   TASK_CORE_APP, plant_stack, &plant_tcb},
+	[TASK_ID_IMU] =       {"imu_task",       TASK_STACK_IMU,       3,   TASK_CORE_APP, imu_stack, &imu_tcb},
+	[TASK_ID_MQTT_SEND] = {"mqtt_send_task", TASK_STACK_MQTT_SEND, 6,   TASK_CORE_APP, mqtt_send_stack, &mqtt_send_tcb},
+	/* only wakes on segment boundaries, strictly above every other application task: an ISR notify only yields
+	 * to a higher priority, an equal one would wait for the next tick */
+	[TASK_ID_HAPTIC] =    {"haptic_task",    TASK_STACK_HAPTIC,    7,   TASK_CORE_APP, haptic_stack, &haptic_tcb},
+	/* drains APP_LOG, lowest priority so formatting and the UART never delay real work */
+	[TASK_ID_LOG] =       {"log_task",       TASK_STACK_LOG,       1,   TASK_CORE_NET, log_stack, &log_tcb},
+	/* jobs from the cloud, may block for seconds so never on the mqtt event task */
+	[TASK_ID_JOB] =       {"job_task",       TASK_STACK_JOB,       2,   TASK_CORE_APP, job_stack, &job_tcb},
+};
+
+static TaskHandle_t task_handles[TASK_ID_COUNT];
+static volatile uint32_t task_wakes[TASK_ID_COUNT];
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: task_registry_start
+* Description  : create a task with its registered core, priority and stack. A task that is already running is not
+*                started twice.
+* Arguments    : id, entry, param, handle - optional, receives the task handle
+* Return Value : true when the task is running
+***********************************************************************************************************************/
+bool task_registry_start(task_id_t id, TaskFunction_t entry, void *param, TaskHandle_t *handle)
+{
+	const task_spec_t *spec;
+
+	if (id >= TASK_ID_COUNT)
+		return false;
+	spec = &task_specs[id];
+	if (task_handles[id] == NULL)
+	{
+		task_handles[id] = xTaskCreateStaticPinnedToCore(entry, spec->name, spec->stack_bytes, param,
+														 spec->priority | portPRIVILEGE_BIT, spec->stack, spec->tcb,
+														 spec->core);
+		if (task_handles[id] == NULL)
+		{
+			APP_LOGE("create %s failed", spec->name);
+			return false;
+		}
+		APP_LOGD("%s core %d prio %d stack %d", spec->name, spec->core, spec->priority, spec->stack_bytes);
+	}
+	if (handle != NULL)
+		*handle = task_handles[id];
+	return true;
+}
+
+const task_spec_t *task_registry_spec(task_id_t id)
+{
+	return (id < TASK_ID_COUNT) ? &task_specs[id] : NULL;
+}
+
+/***********************************************************************************************************************
+* Function Name: task_registry_report
+* Description  : book every registered stack and TCB in the boot memory report, started or not
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void task_registry_report(void)
+{
+	for (uint8_t i = 0; i < TASK_ID_COUNT; i++)
+		mem_report_static(task_specs[i].name, task_specs[i].stack_bytes + sizeof(StaticTask_t));
+}
+
+/***********************************************************************************************************************
+* Function Name: task_registry_find
+* Description  : map a handle back to its registry entry
+* Arguments    : handle
+* Return Value : task id, TASK_ID_COUNT for a task the registry did not start
+***********************************************************************************************************************/
+task_id_t task_registry_find(TaskHandle_t handle)
+{
+	for (uint8_t i = 0; i < TASK_ID_COUNT; i++)
+	{
+		if ((handle != NULL) && (task_handles[i] == handle))
+			return (task_id_t)i;
+	}
+	return TASK_ID_COUNT;
+}
+
+/***********************************************************************************************************************
+* Function Name: task_registry_wake
+* Description  : count one wake-up, called at the top of a task loop. A blocking loop switches in once per iteration
+*                so this is the task's context-switch count.
+* Arguments    : id
+* Return Value : none
+***********************************************************************************************************************/
+void task_registry_wake(task_id_t id)
+{
+	task_wakes[id]++;
+}
+
+uint32_t task_registry_wakes(task_id_t id)
+{
+	return task_wakes[id];
+}
+
+/***********************************************************************************************************************
+* Function Name: task_registry_stack_min
+* Description  : least stack headroom of the started tasks, each task's high-water mark since it started
+* Arguments    : id - optional, receives the task with the least headroom
+* Return Value : headroom in bytes
+***********************************************************************************************************************/
+uint32_t task_registry_stack_min(task_id_t *id)
+{
+	uint32_t least = UINT32_MAX;
+
+	for (uint8_t i = 0; i < TASK_ID_COUNT; i++)
+	{
+		if (task_handles[i] == NULL)
+			continue;
+		uint32_t headroom = uxTaskGetStackHighWaterMark(task_handles[i]);
+		if (headroom < least)
+		{
+			least = headroom;
+			if (id != NULL)
+				*id = (task_id_t)i;
+		}
+	}
+	return least;
+}
+
+/***********************************************************************************************************************
+* Function Name: task_registry_notify
+* Description  : wake a task blocked in ulTaskNotifyTake, a task that is not running yet is skipped
+* Arguments    : id
+* Return Value : none
+***********************************************************************************************************************/
+void task_registry_notify(task_id_t id)
+{
+	if ((id < TASK_ID_COUNT) && (task_handles[id] != NULL))
+		xTaskNotifyGive(task_handles[id]);
+}
+
+/* Return Value : true when the caller must yield on the way out of the ISR */
+bool IRAM_ATTR task_registry_notify_from_isr(task_id_t id)
+{
+	BaseType_t woken = pdFALSE;
+
+	if ((id < TASK_ID_COUNT) && (task_handles[id] != NULL))
+		vTaskNotifyGiveFromISR(task_handles[id], &woken);
+	return (woken == pdTRUE);
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
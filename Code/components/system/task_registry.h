@@ -0,0 +1,70 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+/**
+ * Core plan: the radio side (Wi-Fi, lwIP, esp-mqtt, httpd, dns, wifi manager) is pinned to core 0 through sdkconfig
+ * and the wifi manager, so core 1 only runs the application tasks below.
+ */
+#define TASK_CORE_NET (0)
+#define TASK_CORE_APP (1)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+	TASK_ID_PLANT,
+	TASK_ID_IMU,
+	TASK_ID_MQTT_SEND,
+	TASK_ID_HAPTIC,
+	TASK_ID_LOG,
+	TASK_ID_JOB,
+	TASK_ID_COUNT
+} task_id_t;
+
+typedef struct
+{
+	const char *name;
+	uint32_t stack_bytes;
+	UBaseType_t priority;
+	BaseType_t core;
+	StackType_t *stack; /* static, stack_bytes long */
+	StaticTask_t *tcb;
+} task_spec_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+bool task_registry_start(task_id_t id, TaskFunction_t entry, void *param, TaskHandle_t *handle);
+
+const task_spec_t *task_registry_spec(task_id_t id);
+
+task_id_t task_registry_find(TaskHandle_t handle);
+
+void task_registry_report(void);
+
+void task_registry_wake(task_id_t id);
+
+uint32_t task_registry_wakes(task_id_t id);
+
+uint32_t task_registry_stack_min(task_id_t *id);
+
+void task_registry_notify(task_id_t id);
+
+bool task_registry_notify_from_isr(task_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
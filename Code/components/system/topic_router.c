@@ -0,0 +1,259 @@
+/*
+ * topic_router.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_MQTT
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "topic_router.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define NODE_NONE (-1)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef struct
+{
+	char filter[TOPIC_FILTER_LEN];
+	uint8_t qos;
+	topic_handler_t handler;
+} topic_route_t;
+
+/* one filter level, children of a level are a sibling list */
+typedef struct
+{
+	const char *level; /* into the route's filter copy */
+	uint8_t level_len;
+	int8_t child;
+	int8_t sibling;
+	int8_t route; /* a filter ends at this level */
+} topic_node_t;
+
+/* the topic being dispatched */
+typedef struct
+{
+	const char *topic;
+	uint16_t topic_len;
+	const char *data;
+	uint16_t len;
+	uint8_t handled;
+} topic_message_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static topic_route_t routes[TOPIC_ROUTER_ROUTES];
+static uint8_t route_count;
+static topic_node_t nodes[TOPIC_ROUTER_NODES];
+static uint8_t node_count;
+static int8_t first_level = NODE_NONE;
+
+static bool topic_filter_valid(const char *filter);
+static uint8_t topic_levels_missing(const char *filter);
+static int8_t topic_node_find(int8_t *list, const char *level, uint8_t level_len, bool create);
+static void topic_match(int8_t list, const char *level, const char *end, topic_message_t *message);
+static void topic_fire(int8_t node, topic_message_t *message);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: topic_router_add
+* Description  : route a topic filter with + and # wildcards to a handler. Register before the mqtt client starts,
+*                the same filter again replaces its handler. A filter is added whole or not at all, the nodes it needs
+*                are counted before any is created.
+* Arguments    : filter, qos - of the subscription, handler
+* Return Value : false when the filter is malformed or the router is full
+***********************************************************************************************************************/
+bool topic_router_add(const char *filter, uint8_t qos, topic_handler_t handler)
+{
+	topic_route_t *route = &routes[route_count];
+	int8_t *list = &first_level;
+	const char *level;
+	int8_t node = NODE_NONE;
+
+	if ((route_count >= TOPIC_ROUTER_ROUTES) || (strlen(filter) >= TOPIC_FILTER_LEN) ||
+		(topic_filter_valid(filter) == false))
+	{
+		APP_LOGE("topic filter %s rejected", filter);
+		return false;
+	}
+	// new nodes point into the route's filter copy, a filter that does not fit must leave none behind
+	if (node_count + topic_levels_missing(filter) > TOPIC_ROUTER_NODES)
+	{
+		APP_LOGE("topic router full at %s", filter);
+		return false;
+	}
+	strcpy(route->filter, filter);
+	level = route->filter;
+	while (1)
+	{
+		const char *end = strchr(level, '/');
+		uint8_t level_len = (end != NULL) ? (end - level) : strlen(level);
+
+		node = topic_node_find(list, level, level_len, true);
+		if (end == NULL)
+			break;
+		list = &nodes[node].child;
+		level = end + 1;
+	}
+	if (nodes[node].route != NODE_NONE)
+		route = &routes[nodes[node].route];
+	else
+		nodes[node].route = route_count++;
+	route->qos = qos;
+	route->handler = handler;
+	APP_LOGI("route %s, qos %u", filter, qos);
+	return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: topic_router_subscribe
+* Description  : subscribe every routed filter, on each MQTT_EVENT_CONNECTED of a clean session
+* Arguments    : subscribe - mqtt client subscribe
+* Return Value : none
+***********************************************************************************************************************/
+void topic_router_subscribe(topic_subscribe_t subscribe)
+{
+	for (uint8_t i = 0; i < route_count; i++)
+	{
+		int msg_id = subscribe(routes[i].filter, routes[i].qos);
+		APP_LOGD("subscribe %s, msg_id=%d", routes[i].filter, msg_id);
+	}
+}
+
+/***********************************************************************************************************************
+* Function Name: topic_router_dispatch
+* Description  : call the handler of every filter matching the topic, the trie walk visits only levels that can match
+* Arguments    : topic, topic_len, data, len
+* Return Value : handlers called
+***********************************************************************************************************************/
+uint8_t topic_router_dispatch(const char *topic, uint16_t topic_len, const char *data, uint16_t len)
+{
+	topic_message_t message = {.topic = topic, .topic_len = topic_len, .data = data, .len = len};
+
+	topic_match(first_level, topic, topic + topic_len, &message);
+	if (message.handled == 0)
+		APP_LOGW("no route for %.*s", topic_len, topic);
+	return message.handled;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/* # only as the whole last level, + only as a whole level */
+static bool topic_filter_valid(const char *filter)
+{
+	for (const char *c = filter; *c != '\0'; c++)
+	{
+		bool whole = ((c == filter) || (c[-1] == '/')) && ((c[1] == '\0') || (c[1] == '/'));
+
+		if ((*c == '+') && (whole == false))
+			return false;
+		if ((*c == '#') && ((whole == false) || (c[1] != '\0')))
+			return false;
+	}
+	return *filter != '\0';
+}
+
+/* levels of the filter without a node yet, once one is missing all below it are */
+static uint8_t topic_levels_missing(const char *filter)
+{
+	int8_t list = first_level;
+	const char *level = filter;
+	uint8_t missing = 0;
+
+	while (level != NULL)
+	{
+		const char *end = strchr(level, '/');
+		uint8_t level_len = (end != NULL) ? (end - level) : strlen(level);
+		int8_t node = (missing == 0) ? topic_node_find(&list, level, level_len, false) : NODE_NONE;
+
+		if (node == NODE_NONE)
+			missing++;
+		else
+			list = nodes[node].child;
+		level = (end != NULL) ? (end + 1) : NULL;
+	}
+	return missing;
+}
+
+static int8_t topic_node_find(int8_t *list, const char *level, uint8_t level_len, bool create)
+{
+	for (int8_t n = *list; n != NODE_NONE; n = nodes[n].sibling)
+	{
+		if ((nodes[n].level_len == level_len) && (memcmp(nodes[n].level, level, level_len) == 0))
+			return n;
+	}
+	if ((create == false) || (node_count >= TOPIC_ROUTER_NODES))
+		return NODE_NONE;
+	nodes[node_count] = (topic_node_t){
+		.level = level,
+		.level_len = level_len,
+		.child = NODE_NONE,
+		.sibling = *list,
+		.route = NODE_NONE,
+	};
+	*list = node_count;
+	return node_count++;
+}
+
+/***********************************************************************************************************************
+* Function Name: topic_match
+* Description  : match one topic level against a sibling list and descend. + takes any one level, # the rest of the
+*                topic including its parent level. Wildcards at the first level skip $ topics.
+* Arguments    : list - siblings of this level, level - in the topic, end - of the topic, message
+* Return Value : none
+***********************************************************************************************************************/
+static void topic_match(int8_t list, const char *level, const char *end, topic_message_t *message)
+{
+	const char *level_end = memchr(level, '/', end - level);
+	bool last = (level_end == NULL);
+	bool system_topic = (level == message->topic) && (level < end) && (*level == '$');
+
+	if (last)
+		level_end = end;
+	for (int8_t n = list; n != NODE_NONE; n = nodes[n].sibling)
+	{
+		bool wildcard = (nodes[n].level_len == 1) && ((nodes[n].level[0] == '+') || (nodes[n].level[0] == '#'));
+
+		if (wildcard && system_topic)
+			continue;
+		if ((nodes[n].level_len == 1) && (nodes[n].level[0] == '#'))
+		{
+			topic_fire(n, message);
+			continue;
+		}
+		if (!wildcard && ((nodes[n].level_len != level_end - level) ||
+						  (memcmp(nodes[n].level, level, level_end - level) != 0)))
+			continue;
+		if (last)
+		{
+			topic_fire(n, message);
+			/* "a/#" also matches "a" */
+			topic_fire(topic_node_find(&nodes[n].child, "#", 1, false), message);
+		}
+		else
+			topic_match(nodes[n].child, level_end + 1, end, message);
+	}
+}
+
+static void topic_fire(int8_t node, topic_message_t *message)
+{
+	if ((node == NODE_NONE) || (nodes[node].route == NODE_NONE))
+		return;
+	routes[nodes[node].route].handler(message->topic, message->topic_len, message->data, message->len);
+	message->handled++;
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
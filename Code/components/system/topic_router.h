@@ -0,0 +1,38 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TOPIC_ROUTER_ROUTES (8)
+#define TOPIC_ROUTER_NODES (24) // one per distinct filter level
+#define TOPIC_FILTER_LEN (100)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* topic is not NUL terminated, data is a complete message */
+typedef void (*topic_handler_t)(const char *topic, uint16_t topic_len, const char *data, uint16_t len);
+
+/* mqtt client subscribe, returns the message id or -1 */
+typedef int (*topic_subscribe_t)(const char *filter, uint8_t qos);
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+bool topic_router_add(const char *filter, uint8_t qos, topic_handler_t handler);
+
+void topic_router_subscribe(topic_subscribe_t subscribe);
+
+uint8_t topic_router_dispatch(const char *topic, uint16_t topic_len, const char *data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
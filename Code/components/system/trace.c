@@ -0,0 +1,125 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) != 0
+#error "TRACE_RING_SIZE must be a power of two"
+#endif
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static trace_record_t trace_ring[TRACE_RING_SIZE];
+static uint32_t trace_head; /* records ever written, the ring holds the last TRACE_RING_SIZE */
+static uint16_t trace_next_id;
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: trace_begin
+* Description  : open a new event and record its first hop now
+* Arguments    : stage
+* Return Value : event id, never TRACE_ID_NONE
+***********************************************************************************************************************/
+uint16_t IRAM_ATTR trace_begin(trace_stage_t stage)
+{
+	uint16_t id;
+
+	portENTER_CRITICAL_SAFE(&trace_lock);
+	if (++trace_next_id == TRACE_ID_NONE)
+		++trace_next_id;
+	id = trace_next_id;
+	portEXIT_CRITICAL_SAFE(&trace_lock);
+	trace_point_at(id, stage, esp_timer_get_time());
+	return id;
+}
+
+void IRAM_ATTR trace_point(uint16_t id, trace_stage_t stage)
+{
+	trace_point_at(id, stage, esp_timer_get_time());
+}
+
+/***********************************************************************************************************************
+* Function Name: trace_point_at
+* Description  : record a hop with an earlier timestamp, e.g. one taken in an interrupt before the id existed.
+*                Task or ISR context, about a dozen instructions under the spinlock.
+* Arguments    : id, stage, t_us - esp_timer time of the hop
+* Return Value : none
+***********************************************************************************************************************/
+void IRAM_ATTR trace_point_at(uint16_t id, trace_stage_t stage, int64_t t_us)
+{
+	trace_record_t *record;
+
+	if (id == TRACE_ID_NONE)
+		return;
+	portENTER_CRITICAL_SAFE(&trace_lock);
+	record = &trace_ring[trace_head & (TRACE_RING_SIZE - 1)];
+	record->t_us = (uint32_t)t_us;
+	record->id = id;
+	record->stage = stage;
+	record->core = xPortGetCoreID();
+	trace_head++;
+	portEXIT_CRITICAL_SAFE(&trace_lock);
+}
+
+/***********************************************************************************************************************
+* Function Name: trace_read
+* Description  : copy records oldest first. A cursor the writer has lapped skips ahead to the oldest record kept.
+* Arguments    : cursor - start at trace_oldest(), advanced past the records copied; records, max
+* Return Value : number copied, 0 once the cursor caught up
+***********************************************************************************************************************/
+uint16_t trace_read(uint32_t *cursor, trace_record_t *records, uint16_t max)
+{
+	uint16_t count = 0;
+
+	portENTER_CRITICAL(&trace_lock);
+	if (trace_head - *cursor > TRACE_RING_SIZE)
+		*cursor = trace_head - TRACE_RING_SIZE;
+	while ((count < max) && (*cursor != trace_head))
+	{
+		records[count++] = trace_ring[*cursor & (TRACE_RING_SIZE - 1)];
+		(*cursor)++;
+	}
+	portEXIT_CRITICAL(&trace_lock);
+	return count;
+}
+
+uint32_t trace_oldest(void)
+{
+	uint32_t head = trace_head;
+
+	return (head > TRACE_RING_SIZE) ? (head - TRACE_RING_SIZE) : 0;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
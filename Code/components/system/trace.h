@@ -0,0 +1,57 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define TRACE_RING_SIZE (256) /* power of two */
+#define TRACE_ID_NONE (0)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* hop order of each path, Code/tools/trace_latency.py keeps the same names */
+typedef enum
+{
+	TRACE_STRIKE_IMPACT,   /* impact interrupt */
+	TRACE_STRIKE_TRIGGER,  /* envelope crossed the threshold in the FIFO batch */
+	TRACE_STRIKE_REPORT,   /* features done, report flagged for mqtt */
+	TRACE_BUTTON_GESTURE,  /* gesture completed */
+	TRACE_MQTT_PICKUP,     /* mqtt_send_task saw the flag */
+	TRACE_MQTT_SERIALIZED, /* JSON built */
+	TRACE_MQTT_PUBLISHED,  /* handed to the mqtt client */
+	TRACE_MQTT_ACKED,      /* PUBACK received, QoS1 only */
+	TRACE_STAGE_COUNT
+} trace_stage_t;
+
+typedef struct
+{
+	uint32_t t_us; /* esp_timer, low 32 bits */
+	uint16_t id;
+	uint8_t stage;
+	uint8_t core;
+} trace_record_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+uint16_t trace_begin(trace_stage_t stage);
+
+void trace_point(uint16_t id, trace_stage_t stage);
+
+void trace_point_at(uint16_t id, trace_stage_t stage, int64_t t_us);
+
+uint16_t trace_read(uint32_t *cursor, trace_record_t *records, uint16_t max);
+
+uint32_t trace_oldest(void);
+
+#ifdef __cplusplus
+}
+#endif
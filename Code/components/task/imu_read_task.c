@@ -7,27 +7,140 @@
 /***********************************************************************************************************************
 * Pragma directive
 ***********************************************************************************************************************/
-
+#define APP_LOG_MODULE LOG_MODULE_IMU
 /***********************************************************************************************************************
 * Includes <System Includes>
 ***********************************************************************************************************************/
 #include "imu_read_task.h"
 // #include "../user_driver/LSM6DSL_ACC_GYRO_Driver.h"
 #include "../user_driver/LSM6DSLSensor.h"
+#include "../user_driver/imu_calibration.h"
+#include "../dsp/dsp_filter.h"
+#include "../dsp/dsp_fft.h"
+#include "../dsp/dsp_orientation.h"
+#include "../user_driver/strike_model.h"
+#include "../user_driver/strike_stats.h"
+#include "../user_driver/haptic.h"
+#include "../user_driver/user_leds.h"
+#include "../system/task_registry.h"
+#include "../system/trace.h"
+#include "../system/power.h"
+#include "../system/standby.h"
+#include "soc/cpu.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include <math.h>
 /***********************************************************************************************************************
 * Macro definitions
 ***********************************************************************************************************************/
+#define IMU_FIFO_WORDS_PER_TICK (6)                                                            // G x, y, z then XL x, y, z
+#define IMU_FIFO_PATTERN_LEN (LSM6DSL_FIFO_TEMP_DECIMATION * IMU_FIFO_WORDS_PER_TICK + 3) // + temperature triplet
+#define IMU_FIFO_XL_SLOT (3)
+#define IMU_FIFO_BATCH_MAX_WORDS (IMU_BATCH_MAX_SAMPLES * IMU_FIFO_WORDS_PER_TICK)
+
+#define IMU_HP_CUTOFF_HZ (10.0f)        // gravity and swing orientation are removed below this
+#define IMU_ENV_ATTACK_SHIFT (1)        // ~2 samples
+#define IMU_ENV_RELEASE_SHIFT (6)       // ~150 ms at 416 Hz
+#define IMU_NOISE_FLOOR_SHIFT (10)      // ~2.5 s
+#define IMU_NOISE_FLOOR_RATIO_Q4 (8 << 4)
+#define IMU_DSP_PROFILE_SAMPLES (4096)  // log the front-end cost every ~10 s
+
+#define IMU_GYRO_FS_DPS (2000.0f)
+#define IMU_MAHONY_KP (1.0f)
+#define IMU_MAHONY_KI (0.05f)
+#define IMU_SWING_REST_DPS (30) // below this the hammer is held still, the swing is measured from here
+#define IMU_MDPS_TO_RAD (0.0000174533f)
+
+#define IMU_IMPACT_TAP_THS (12)          // 12 x 8 g / 32 = 3 g, same as the detector floor
+#define IMU_IMPACT_REARM_US (300 * 1000) // one haptic trigger per strike
+
+#define IMU_POLL_MS (10)                         // hammer in use, keeps the strike report latency low
+#define IMU_IDLE_POLL_MS (100)                   // one FIFO burst per 100 ms, IMU_BATCH_MAX_SAMPLES covers ~150 ms
+#define IMU_ACTIVE_HOLD_US (2 * 1000 * 1000)     // stay on the fast poll this long after the last impact interrupt
 
+#define IMU_COLD_START_MS (1000)
+#define IMU_WARM_START_MS (20)   // sensor already powered through standby, only its boot time
+#define IMU_WAKE_ODR_HZ (26.0f)  // wake-up detection while the ESP32 is in deep sleep
+#define IMU_WAKE_THS (4)         // 4 x 2 g / 64 = 125 mg
+#define IMU_STANDBY_ARM_MS (500) // longest standby_enter() waits for the sensor to be armed
+
+#define IMU_FREEFALL_MG (350)                           // |a| below this counts as free fall
+#define IMU_FREEFALL_GAP_SAMPLES (IMU_SAMPLE_RATE_HZ / 10) // the low-g run must end within 100 ms of the trigger
+#define IMU_HIT_WINDOW_SAMPLES (IMU_SAMPLE_RATE_HZ * 200 / 1000) // 200 ms after the trigger, 83 samples
+
+#if DSP_FFT_BANDS != SENSOR_HIT_BANDS
+#error "sensor_data_t hit bands do not match the spectrum stage"
+#endif
 /***********************************************************************************************************************
 * Typedef definitions
 ***********************************************************************************************************************/
-#define GYRO_THRESS_HIT_DETECT 4.00
+#define GYRO_THRESS_HIT_DETECT 3.00 // g above gravity, lower bound of the adaptive threshold
 /***********************************************************************************************************************
 * Private global variables and functions
 ***********************************************************************************************************************/
 static void imu_task(void *pvParameters);
 static void display_6D(void);
-static bool hammer_hit_detection(int32_t acc_z);
+static bool hammer_hit_detection(int32_t envelope, int32_t threshold);
+static uint16_t imu_fifo_read_batch(imu_sample_t *samples);
+static void imu_dsp_init(void);
+static void imu_process_batch(imu_sample_t *samples, uint16_t count);
+static void imu_orientation_update(const imu_sample_t *sample);
+static void imu_impact_irq_init(void);
+static void imu_impact_isr(void *arg);
+static uint32_t imu_poll_ms(void);
+static void imu_standby_prepare(void);
+static void imu_standby_arm(void);
+static void imu_freefall_track(const int32_t *acc_mg);
+static void imu_strike_start(void);
+static void imu_strike_feed(int32_t envelope);
+static strike_label_t imu_strike_classify(void);
+#ifdef CONFIG_DSP_SPECTRUM_ENABLE
+static void imu_spectrum_start(void);
+static void imu_spectrum_feed(int32_t z);
+#endif
+
+uint16_t hit_detect_samples = 0;
+uint8_t hit_detect_state = 0;
+
+static int16_t fifo_words[IMU_FIFO_BATCH_MAX_WORDS];
+static imu_sample_t imu_batch[IMU_BATCH_MAX_SAMPLES];
+static int16_t fifo_partial[IMU_FIFO_WORDS_PER_TICK];
+static int32_t acc_sensitivity_q16 = 0; // mg/LSB in Q16
+static int32_t gyro_sensitivity_q8 = 0;  // mdps/LSB in Q8, Q16 would overflow at 2000 dps
+
+static dsp_biquad_q14_t hp_z;
+static dsp_envelope_t env_z;
+static dsp_noise_floor_t noise_z;
+static uint16_t hit_min_mg = GYRO_THRESS_HIT_DETECT * 1000;
+static uint8_t hit_ratio = IMU_NOISE_FLOOR_RATIO_Q4 >> 4;
+static bool hp_primed = false;
+static int32_t dsp_z[IMU_BATCH_MAX_SAMPLES];
+static int32_t dsp_env[IMU_BATCH_MAX_SAMPLES];
+static int32_t dsp_thr[IMU_BATCH_MAX_SAMPLES];
+static uint32_t dsp_cycles = 0;
+static uint32_t dsp_samples = 0;
+static dsp_mahony_t orientation;
+static dsp_quat_t swing_rest;    // last orientation held still
+static int32_t swing_rate_peak = 0; // peak |w| since the hammer was last still [dps]
+static uint32_t orient_cycles = 0;
+static volatile int64_t impact_us = 0; // last impact interrupt [esp_timer us]
+static volatile int64_t motion_us = 0; // last impact interrupt, held or not [esp_timer us]
+static volatile bool standby_request = false;
+static volatile bool standby_armed = false;
+static uint16_t freefall_run = 0; // samples
+static uint16_t freefall_gap = IMU_FREEFALL_GAP_SAMPLES + 1;
+static uint16_t strike_freefall = 0; // samples
+static int32_t strike_peak = 0;
+static uint16_t strike_ringdown = 0; // samples
+static uint16_t strike_trace_id = TRACE_ID_NONE;
+#ifdef CONFIG_DSP_SPECTRUM_ENABLE
+// post-trigger window, 64 samples = 154 ms at 416 Hz, done before the hit is reported at 200 ms
+static int32_t spectrum_window[DSP_FFT_N];
+static float spectrum_power[DSP_FFT_BINS];
+static dsp_spectrum_t hit_spectrum;
+static uint16_t spectrum_fill = DSP_FFT_N; // DSP_FFT_N = idle
+#endif
 /***********************************************************************************************************************
 * Exported global variables and functions (to be accessed by other files)
 ***********************************************************************************************************************/
@@ -44,7 +157,29 @@ static bool hammer_hit_detection(int32_t acc_z);
 ***********************************************************************************************************************/
 void imu_read_task(void)
 {
-    xTaskCreatePinnedToCore(imu_task, "imu_task", 4 * 1024, NULL, 3 | portPRIVILEGE_BIT, NULL, 1);
+    task_registry_start(TASK_ID_IMU, imu_task, NULL, NULL);
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_set_hit_threshold
+* Description  : adaptive hit threshold, noise floor x ratio but never below min_mg. Word writes, the imu task picks
+*                them up with its next batch.
+* Arguments    : min_mg - above gravity, ratio - threshold / noise floor
+* Return Value : none
+***********************************************************************************************************************/
+void imu_set_hit_threshold(uint16_t min_mg, uint8_t ratio)
+{
+    hit_min_mg = min_mg;
+    hit_ratio = ratio;
+    noise_z.min_threshold = min_mg;
+    noise_z.ratio_q4 = ratio << 4;
+    APP_LOGI("hit threshold %u mg, x%u floor", min_mg, ratio);
+}
+
+void imu_get_hit_threshold(uint16_t *min_mg, uint8_t *ratio)
+{
+    *min_mg = hit_min_mg;
+    *ratio = hit_ratio;
 }
 /***********************************************************************************************************************
 * Static Functions
@@ -58,10 +193,13 @@ void imu_read_task(void)
 static void imu_task(void *pvParameters)
 {
     uint8_t buffer_who_am_i = 0x00;
-    int32_t accelerometer[3];
-    vTaskDelay(1000);
+    float sensitivity = 0;
+    uint16_t count;
+    vTaskDelay((standby_warm_boot() ? IMU_WARM_START_MS : IMU_COLD_START_MS) / portTICK_PERIOD_MS);
     // init acc sensor
     LSM6DSLStatusTypeDef ret_1 = LSM6DSLSensor_begin();
+    if (standby_warm_boot() == true)
+        LSM6DSLSensor_Disable_Wake_Up_Detection(); // left armed by imu_standby_arm()
     if (ret_1 == LSM6DSL_STATUS_ERROR)
         APP_LOGE("Init LSM6DSL err");
     else if (ret_1 == LSM6DSL_STATUS_OK)
@@ -71,49 +209,477 @@ static void imu_task(void *pvParameters)
         APP_LOGE("ID err");
     else if (ret_1 == LSM6DSL_STATUS_OK)
         APP_LOGI("ID ok : %x", buffer_who_am_i);
+    imu_calib_init();
+    LSM6DSLSensor_Set_X_ODR(IMU_SAMPLE_RATE_HZ);
     LSM6DSLSensor_Enable_X();
-    bool hit;
+    LSM6DSLSensor_Get_X_Sensitivity(&sensitivity);
+    acc_sensitivity_q16 = (int32_t)(sensitivity * 65536.0f);
+    LSM6DSLSensor_Set_G_FS(IMU_GYRO_FS_DPS);
+    LSM6DSLSensor_Set_G_ODR(IMU_SAMPLE_RATE_HZ);
+    LSM6DSLSensor_Enable_G();
+    LSM6DSLSensor_Get_G_Sensitivity(&sensitivity);
+    gyro_sensitivity_q8 = (int32_t)(sensitivity * 256.0f);
+    imu_dsp_init();
+    strike_model_load();
+    // accelerometer, gyroscope and temperature are batched by the sensor, the task only drains the FIFO
+    if (LSM6DSLSensor_Enable_FIFO_Stream(IMU_SAMPLE_RATE_HZ, 1, 1) != LSM6DSL_STATUS_OK)
+        APP_LOGE("LSM6DSL FIFO config err");
+    imu_impact_irq_init();
+    standby_register_prepare(imu_standby_prepare);
     while (1)
     {
-        LSM6DSLSensor_Get_X_Axes(accelerometer);
-        // printf("Acc z[mg]: %d.%d\r\n", accelerometer[2] / 1000, abs((accelerometer[2] % 1000)));
-        if (deive_data.sensor.buttons_hold == true)
+        task_registry_wake(TASK_ID_IMU);
+        if (standby_request == true)
+        {
+            imu_standby_arm();
+            standby_armed = true;
+            vTaskSuspend(NULL); // the chip powers down next, nothing resumes this task
+        }
+        power_lock(POWER_LOCK_IMU);
+        count = imu_fifo_read_batch(imu_batch);
+        if (count > 0)
+        {
+            imu_process_batch(imu_batch, count);
+        }
+        power_unlock(POWER_LOCK_IMU);
+        // a captured calibration point goes to NVS here, not inside the sample loop
+        imu_calib_flush();
+
+        // the impact interrupt cuts an idle wait short
+        ulTaskNotifyTake(pdTRUE, imu_poll_ms() / portTICK_PERIOD_MS);
+    }
+}
+/***********************************************************************************************************************
+* Function Name: imu_fifo_read_batch
+* Description  : drain up to IMU_BATCH_MAX_SAMPLES samples from the FIFO in one burst, temperature words update the
+*                thermal compensation on the way
+* Arguments    : samples - output array, IMU_BATCH_MAX_SAMPLES entries
+* Return Value : number of complete samples
+***********************************************************************************************************************/
+static uint16_t imu_fifo_read_batch(imu_sample_t *samples)
+{
+    uint16_t num_words = 0;
+    uint16_t pattern = 0;
+    uint16_t i, p, slot;
+    uint16_t count = 0;
+    int16_t temperature;
+
+    if ((LSM6DSLSensor_Get_FIFO_Num_Of_Entries(&num_words) != LSM6DSL_STATUS_OK) || (num_words == 0))
+        return 0;
+    if (LSM6DSLSensor_Get_FIFO_Pattern(&pattern) != LSM6DSL_STATUS_OK)
+        return 0;
+    if (num_words > IMU_FIFO_BATCH_MAX_WORDS)
+        num_words = IMU_FIFO_BATCH_MAX_WORDS;
+    if (LSM6DSLSensor_Get_FIFO_Words(fifo_words, num_words) != LSM6DSL_STATUS_OK)
+        return 0;
+
+    for (i = 0; i < num_words; i++)
+    {
+        p = (pattern + i) % IMU_FIFO_PATTERN_LEN;
+        if (p < IMU_FIFO_WORDS_PER_TICK)
+        {
+            slot = p;
+        }
+        else if (p < IMU_FIFO_WORDS_PER_TICK + 3)
+        {
+            if (p - IMU_FIFO_WORDS_PER_TICK == LSM6DSL_FIFO_TEMP_WORD)
+            {
+                temperature = LSM6DSL_TEMP_RAW_TO_CENTI_C(fifo_words[i]);
+                deive_data.sensor.temperature = temperature;
+                imu_calib_set_temperature(temperature);
+            }
+            continue;
+        }
+        else
+        {
+            slot = (p - IMU_FIFO_WORDS_PER_TICK - 3) % IMU_FIFO_WORDS_PER_TICK;
+        }
+
+        fifo_partial[slot] = fifo_words[i];
+        if (slot == IMU_FIFO_WORDS_PER_TICK - 1)
+        {
+            samples[count].gyro[0] = (fifo_partial[0] * gyro_sensitivity_q8) >> 8;
+            samples[count].gyro[1] = (fifo_partial[1] * gyro_sensitivity_q8) >> 8;
+            samples[count].gyro[2] = (fifo_partial[2] * gyro_sensitivity_q8) >> 8;
+            samples[count].acc[0] = (fifo_partial[IMU_FIFO_XL_SLOT + 0] * acc_sensitivity_q16) >> 16;
+            samples[count].acc[1] = (fifo_partial[IMU_FIFO_XL_SLOT + 1] * acc_sensitivity_q16) >> 16;
+            samples[count].acc[2] = (fifo_partial[IMU_FIFO_XL_SLOT + 2] * acc_sensitivity_q16) >> 16;
+            count++;
+        }
+    }
+    return count;
+}
+/***********************************************************************************************************************
+* Function Name: imu_dsp_init
+* Description  : high-pass (gravity removal) -> envelope -> adaptive noise floor on the Z axis
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_dsp_init(void)
+{
+    dsp_biquad_q14_highpass_init(&hp_z, IMU_HP_CUTOFF_HZ, IMU_SAMPLE_RATE_HZ, 0.707f);
+    dsp_envelope_init(&env_z, IMU_ENV_ATTACK_SHIFT, IMU_ENV_RELEASE_SHIFT);
+    dsp_noise_floor_init(&noise_z, 0, IMU_NOISE_FLOOR_SHIFT, hit_ratio << 4, hit_min_mg);
+    hp_primed = false;
+    dsp_mahony_init(&orientation, IMU_SAMPLE_RATE_HZ, IMU_MAHONY_KP, IMU_MAHONY_KI);
+    swing_rest = orientation.q;
+}
+/***********************************************************************************************************************
+* Function Name: imu_process_batch
+* Description  : calibration stage, dsp front-end, then the hit detector, one FIFO batch at a time. Free fall and
+*                orientation advance sample by sample with the detector, the trigger latches them at its own sample.
+* Arguments    : samples, count
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_process_batch(imu_sample_t *samples, uint16_t count)
+{
+    uint16_t i;
+    bool hit;
+    uint32_t start;
+    uint8_t prev_state;
+
+    for (i = 0; i < count; i++)
+    {
+        imu_calib_feed_capture(samples[i].acc);
+        imu_calib_apply(samples[i].acc);
+        dsp_z[i] = samples[i].acc[2];
+    }
+
+    if (hp_primed == false)
+    {
+        dsp_biquad_q14_reset(&hp_z, dsp_z[0]);
+        hp_primed = true;
+    }
+
+    start = esp_cpu_get_ccount();
+    dsp_biquad_q14_process(&hp_z, dsp_z, dsp_z, count);
+    dsp_envelope_process(&env_z, dsp_z, dsp_env, count);
+    dsp_noise_floor_process(&noise_z, dsp_env, dsp_thr, count);
+    dsp_cycles += esp_cpu_get_ccount() - start;
+    dsp_samples += count;
+    if (dsp_samples >= IMU_DSP_PROFILE_SAMPLES)
+    {
+        APP_LOGD("dsp front-end %d cycles/sample, noise floor %d mg", dsp_cycles / dsp_samples, noise_z.floor >> DSP_ENV_Q);
+        APP_LOGD("orientation %d cycles/update", orient_cycles / dsp_samples);
+        dsp_cycles = 0;
+        orient_cycles = 0;
+        dsp_samples = 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        imu_freefall_track(samples[i].acc);
+        start = esp_cpu_get_ccount();
+        imu_orientation_update(&samples[i]);
+        orient_cycles += esp_cpu_get_ccount() - start;
+        // printf("Acc z[mg]: %d.%d\r\n", samples[i].acc[2] / 1000, abs((samples[i].acc[2] % 1000)));
+        // a strike that started while held is measured to its end after the release
+        if ((deive_data.sensor.buttons_hold == true) || (hit_detect_state != 0))
         {
-            hit = hammer_hit_detection(accelerometer[2]);
+            prev_state = hit_detect_state;
+            hit = hammer_hit_detection(dsp_env[i], dsp_thr[i]);
+            if ((prev_state == 0) && (hit_detect_state == 1))
+            {
+                strike_trace_id = trace_begin(TRACE_STRIKE_TRIGGER);
+                // the interrupt path already started the motor unless the tap engine missed this one
+                if (esp_timer_get_time() - impact_us > IMU_IMPACT_REARM_US)
+                    haptic_play_event(HAPTIC_EVENT_HIT);
+                else
+                    trace_point_at(strike_trace_id, TRACE_STRIKE_IMPACT, impact_us);
+                leds_flash(LED_RED);
+                imu_strike_start();
+#ifdef CONFIG_DSP_SPECTRUM_ENABLE
+                imu_spectrum_start();
+#endif
+            }
+            imu_strike_feed(dsp_env[i]);
+#ifdef CONFIG_DSP_SPECTRUM_ENABLE
+            imu_spectrum_feed(dsp_z[i]);
+#endif
             if (hit == true)
             {
-                APP_LOGI("hit detection");
-                deive_data.sensor.hammer_detect = true;
-                deive_data.sensor.vibration_active = true;
+                deive_data.sensor.strike_label = imu_strike_classify();
+                APP_LOGI("hit detection: %s", strike_label_name(deive_data.sensor.strike_label));
+                strike_stats_record((strike_peak > UINT16_MAX) ? UINT16_MAX : strike_peak,
+                                    deive_data.sensor.strike_label, deive_data.sensor.swing_angle_deg,
+                                    deive_data.sensor.impact_rate_dps);
+                trace_point(strike_trace_id, TRACE_STRIKE_REPORT);
+                // the window summary covers this strike, a message of its own only while live reporting is on
+                if (strike_stats_live() == true)
+                {
+                    deive_data.sensor.trace_id = strike_trace_id;
+                    deive_data.sensor.hammer_detect = true;
+                    task_registry_notify(TASK_ID_MQTT_SEND);
+                }
             }
         }
-        memset(accelerometer, 0x00, sizeof(accelerometer));
+    }
+}
+/***********************************************************************************************************************
+* Function Name: imu_impact_irq_init
+* Description  : the sensor tap engine flags impacts on INT1, the GPIO interrupt starts the haptic engine without
+*                waiting for the next FIFO batch
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_impact_irq_init(void)
+{
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << GPIO_IMU_INT1),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_HIGH_LEVEL, // the rising edge, re-armed in the ISR so it wakes light sleep (power_init)
+    };
+    esp_err_t err;
+
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if ((err != ESP_OK) && (err != ESP_ERR_INVALID_STATE)) // already installed by someone else is fine
+        APP_LOGE("gpio isr service err %d", err);
+    ESP_ERROR_CHECK(gpio_isr_handler_add(GPIO_IMU_INT1, imu_impact_isr, NULL));
+    if (LSM6DSLSensor_Enable_Impact_Detection(LSM6DSL_INT1_PIN, IMU_IMPACT_TAP_THS) != LSM6DSL_STATUS_OK)
+        APP_LOGE("LSM6DSL impact interrupt config err");
+}
 
+static void IRAM_ATTR imu_impact_isr(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    bool woken;
+
+    if (power_wake_rearm_isr(GPIO_IMU_INT1) == false)
+        return; // falling edge
+    motion_us = now;
+    standby_activity();
+    woken = task_registry_notify_from_isr(TASK_ID_IMU);
+    if ((deive_data.sensor.buttons_hold == true) && (now - impact_us >= IMU_IMPACT_REARM_US))
+    {
+        impact_us = now;
+        woken |= haptic_play_event_from_isr(HAPTIC_EVENT_HIT, now);
+    }
+    if (woken == true)
+        portYIELD_FROM_ISR();
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_poll_ms
+* Description  : FIFO drain period, fast while the hammer is held or a strike is being measured, slow otherwise so
+*                the chip can light-sleep between bursts. buttons_hold ends with buttonUp, see plan_task.
+* Arguments    : none
+* Return Value : milliseconds until the next drain
+***********************************************************************************************************************/
+static uint32_t imu_poll_ms(void)
+{
+    if ((deive_data.sensor.buttons_hold == true) || (hit_detect_state != 0) ||
+        (esp_timer_get_time() - motion_us < IMU_ACTIVE_HOLD_US))
+        return IMU_POLL_MS;
+    return IMU_IDLE_POLL_MS;
+}
+/***********************************************************************************************************************
+* Function Name: imu_standby_prepare
+* Description  : standby_enter() hook, hands the sensor over to the IMU task and waits until it is armed so that no
+*                I2C transfer is cut by the power down
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_standby_prepare(void)
+{
+    standby_request = true;
+    task_registry_notify(TASK_ID_IMU);
+    for (uint16_t waited = 0; (standby_armed == false) && (waited < IMU_STANDBY_ARM_MS); waited += 10)
         vTaskDelay(10 / portTICK_PERIOD_MS);
+    if (standby_armed == false)
+        APP_LOGE("imu standby arm timeout");
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_standby_arm
+* Description  : gyroscope off, FIFO off, accelerometer at IMU_WAKE_ODR_HZ with wake-up detection on INT1, which is
+*                the ext0 wake source of standby
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_standby_arm(void)
+{
+    LSM6DSLSensor_Disable_FIFO();
+    LSM6DSLSensor_Disable_G();
+    if ((LSM6DSLSensor_Enable_Wake_Up_Detection(LSM6DSL_INT1_PIN) != LSM6DSL_STATUS_OK) ||
+        (LSM6DSLSensor_Set_Wake_Up_Threshold(IMU_WAKE_THS) != LSM6DSL_STATUS_OK) ||
+        (LSM6DSLSensor_Set_X_ODR(IMU_WAKE_ODR_HZ) != LSM6DSL_STATUS_OK))
+        APP_LOGE("LSM6DSL wake-up config err");
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_orientation_update
+* Description  : one Mahony step per FIFO sample, the orientation is re-anchored whenever the hammer is held still
+* Arguments    : sample
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_orientation_update(const imu_sample_t *sample)
+{
+    int32_t rate2;
+    int32_t rate;
+
+    dsp_mahony_update(&orientation,
+                      sample->gyro[0] * IMU_MDPS_TO_RAD, sample->gyro[1] * IMU_MDPS_TO_RAD, sample->gyro[2] * IMU_MDPS_TO_RAD,
+                      sample->acc[0] / 1000.0f, sample->acc[1] / 1000.0f, sample->acc[2] / 1000.0f);
+
+    // dps resolution is enough here, keeps the square within int32
+    rate2 = (sample->gyro[0] / 1000) * (sample->gyro[0] / 1000) + (sample->gyro[1] / 1000) * (sample->gyro[1] / 1000) +
+            (sample->gyro[2] / 1000) * (sample->gyro[2] / 1000);
+    if (rate2 < IMU_SWING_REST_DPS * IMU_SWING_REST_DPS)
+    {
+        swing_rest = orientation.q;
+        swing_rate_peak = 0;
+    }
+    else
+    {
+        rate = (int32_t)sqrtf((float)rate2);
+        if (rate > swing_rate_peak)
+            swing_rate_peak = rate;
     }
 }
 /***********************************************************************************************************************
-* Function Name:
-* Description  :
+* Function Name: imu_freefall_track
+* Description  : length of the last low-g run and the samples since it ended, a dropped hammer falls before it lands
+* Arguments    : acc_mg - calibrated x, y, z
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_freefall_track(const int32_t *acc_mg)
+{
+    int32_t mag2 = acc_mg[0] * acc_mg[0] + acc_mg[1] * acc_mg[1] + acc_mg[2] * acc_mg[2];
+
+    if (mag2 < IMU_FREEFALL_MG * IMU_FREEFALL_MG)
+    {
+        if (freefall_gap != 0)
+        {
+            freefall_run = 0;
+            freefall_gap = 0;
+        }
+        if (freefall_run < UINT16_MAX)
+            freefall_run++;
+    }
+    else if (freefall_gap <= IMU_FREEFALL_GAP_SAMPLES)
+    {
+        freefall_gap++;
+    }
+}
+/***********************************************************************************************************************
+* Function Name: imu_strike_start
+* Description  : latch the free fall before the trigger and reset the post-trigger features
 * Arguments    : none
 * Return Value : none
 ***********************************************************************************************************************/
-uint32_t hit_detect_time = 0;
-uint8_t hit_detect_state = 0;
-static bool hammer_hit_detection(int32_t acc_z)
+static void imu_strike_start(void)
+{
+    strike_freefall = (freefall_gap <= IMU_FREEFALL_GAP_SAMPLES) ? freefall_run : 0;
+    deive_data.sensor.swing_angle_deg = (int16_t)(dsp_quat_angle_deg(&swing_rest, &orientation.q) + 0.5f);
+    deive_data.sensor.impact_rate_dps = (int16_t)swing_rate_peak;
+    strike_peak = 0;
+    strike_ringdown = 0;
+}
+/***********************************************************************************************************************
+* Function Name: imu_strike_feed
+* Description  : envelope peak and ring-down while the detector is in its hit window
+* Arguments    : envelope - [mg]
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_strike_feed(int32_t envelope)
+{
+    if (hit_detect_state != 1)
+        return;
+    if (envelope > strike_peak)
+        strike_peak = envelope;
+    if (envelope > strike_peak / 2)
+        strike_ringdown++;
+}
+/***********************************************************************************************************************
+* Function Name: imu_strike_classify
+* Description  : feature vector of the finished strike -> label
+* Arguments    : none
+* Return Value : label
+***********************************************************************************************************************/
+static strike_label_t imu_strike_classify(void)
+{
+    int16_t features[STRIKE_FEATURE_COUNT];
+    uint8_t i;
+
+    features[STRIKE_FEAT_PEAK_MG] = (strike_peak > INT16_MAX) ? INT16_MAX : strike_peak;
+    features[STRIKE_FEAT_RINGDOWN_MS] = strike_ringdown * 1000 / IMU_SAMPLE_RATE_HZ;
+    features[STRIKE_FEAT_FREEFALL_MS] = strike_freefall * 1000 / IMU_SAMPLE_RATE_HZ;
+    features[STRIKE_FEAT_SWING_DEG] = deive_data.sensor.swing_angle_deg;
+    features[STRIKE_FEAT_RATE_DPS] = deive_data.sensor.impact_rate_dps;
+    features[STRIKE_FEAT_PEAK_HZ] = deive_data.sensor.hit_peak_hz;
+    features[STRIKE_FEAT_ENERGY_DB] = deive_data.sensor.hit_energy_db;
+    for (i = 0; i < SENSOR_HIT_BANDS; i++)
+        features[STRIKE_FEAT_BAND0_PCT + i] = deive_data.sensor.hit_band_pct[i];
+    return strike_model_classify(features);
+}
+#ifdef CONFIG_DSP_SPECTRUM_ENABLE
+/***********************************************************************************************************************
+* Function Name: imu_spectrum_start
+* Description  : arm the post-trigger capture, the previous hit features are dropped
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_spectrum_start(void)
+{
+    spectrum_fill = 0;
+    deive_data.sensor.hit_peak_hz = 0;
+    memset(deive_data.sensor.hit_band_pct, 0x00, sizeof(deive_data.sensor.hit_band_pct));
+    deive_data.sensor.hit_energy_db = 0;
+}
+/***********************************************************************************************************************
+* Function Name: imu_spectrum_feed
+* Description  : collect the high-passed Z axis, the FFT runs once on the sample that completes the window
+* Arguments    : z - [mg]
+* Return Value : none
+***********************************************************************************************************************/
+static void imu_spectrum_feed(int32_t z)
+{
+    uint32_t start;
+    uint8_t i;
+
+    if (spectrum_fill >= DSP_FFT_N)
+        return;
+    spectrum_window[spectrum_fill++] = z;
+    if (spectrum_fill < DSP_FFT_N)
+        return;
+
+    start = esp_cpu_get_ccount();
+    dsp_fft_real_power(spectrum_window, spectrum_power);
+    dsp_spectrum_features(spectrum_power, IMU_SAMPLE_RATE_HZ, &hit_spectrum);
+    APP_LOGD("spectrum %d cycles, peak %d Hz", esp_cpu_get_ccount() - start, (int)hit_spectrum.peak_hz);
+
+    if (hit_spectrum.total_energy <= 0.0f)
+        return;
+    for (i = 0; i < DSP_FFT_BANDS; i++)
+        deive_data.sensor.hit_band_pct[i] = (uint8_t)(hit_spectrum.band_energy[i] * 100.0f / hit_spectrum.total_energy + 0.5f);
+    deive_data.sensor.hit_energy_db = (int16_t)(10.0f * log10f(hit_spectrum.total_energy));
+    deive_data.sensor.hit_peak_hz = (uint16_t)(hit_spectrum.peak_hz + 0.5f);
+}
+#endif
+/***********************************************************************************************************************
+* Function Name: hammer_hit_detection
+* Description  : one sample through the detector, the hit window is counted in samples so it does not depend on when
+*                the FIFO batch was read
+* Arguments    : envelope, threshold - [mg]
+* Return Value : true on the sample that ends a hit window
+***********************************************************************************************************************/
+static bool hammer_hit_detection(int32_t envelope, int32_t threshold)
 {
     bool status = false;
     switch (hit_detect_state)
     {
     case 0:
-        if (abs(acc_z) > (GYRO_THRESS_HIT_DETECT * 1000))
+        if (envelope > threshold)
         {
             hit_detect_state = 1;
-            hit_detect_time = usertimer_gettick();
+            hit_detect_samples = 0;
         }
         break;
     case 1:
-        if (usertimer_gettick() - hit_detect_time > 200)
+        if (++hit_detect_samples >= IMU_HIT_WINDOW_SAMPLES)
         {
             hit_detect_state = 0;
             status = true;
@@ -12,16 +12,26 @@ extern "C" {
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
-
+#define IMU_SAMPLE_RATE_HZ (416)
+#define IMU_BATCH_MAX_SAMPLES (64)
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
+typedef struct
+{
+	int32_t acc[3];  // temperature compensated acceleration [mg]
+	int32_t gyro[3]; // angular rate [mdps]
+} imu_sample_t;
 
 /****************************************************************************/
 /***         Exported global functions                                     ***/
 /****************************************************************************/
 void imu_read_task(void);
 
+void imu_set_hit_threshold(uint16_t min_mg, uint8_t ratio);
+
+void imu_get_hit_threshold(uint16_t *min_mg, uint8_t *ratio);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,403 @@
+/*
+ * job_task.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+ * Pragma directive
+ ***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_MQTT
+/***********************************************************************************************************************
+ * Includes <System Includes>
+ ***********************************************************************************************************************/
+#include "job_task.h"
+#include "../../Common.h"
+#include "../../components/json_parser/json_parser.h"
+#include "../../components/json_parser/shadow.h"
+#include "../../components/json_parser/cJson_lib/cJSON.h"
+#include "../user_driver/imu_calibration.h"
+#include "../system/task_registry.h"
+#include "../system/mem_pool.h"
+#include "../system/outbox.h"
+#include "../system/trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "esp_system.h"
+#include "nvs.h"
+/***********************************************************************************************************************
+ * Macro definitions
+ ***********************************************************************************************************************/
+#define JOB_NVS_NAMESPACE "jobs"
+#define JOB_NVS_RESTART_KEY "restart" // id of a restart job, reported as succeeded by the next boot
+#define JOB_POOL_WAIT_MS (100)
+#define JOB_POLL_MS (100)
+#define JOB_RESTART_FLUSH_MS (3000)   // longest wait for the in-progress status to reach the broker
+#define JOB_CALIBRATE_TIMEOUT_MS (5000)
+#define JOB_CAPTURE_TIMEOUT_MS (10000)
+/***********************************************************************************************************************
+ * Typedef definitions
+ ***********************************************************************************************************************/
+typedef struct
+{
+    char id[JOB_ID_LEN]; /* "" for a local job, no idempotency and no status */
+    uint32_t accepted_ms;
+    uint16_t len;
+    char data[JOB_PAYLOAD_LEN];
+} job_t;
+
+typedef struct
+{
+    char id[JOB_ID_LEN];
+    uint8_t state;
+} job_recent_t;
+
+/* runs in job_task and may block, reason is set when it fails */
+typedef bool (*job_handler_t)(const job_t *job, const cJSON *root, const char **reason);
+/***********************************************************************************************************************
+ * Private global variables and functions
+ ***********************************************************************************************************************/
+MEM_POOL_DEFINE(job_pool, sizeof(job_t), JOB_QUEUE_LEN);
+static uint8_t job_queue_storage[JOB_QUEUE_LEN * sizeof(job_t *)];
+static StaticQueue_t job_queue_buffer;
+static QueueHandle_t job_queue = NULL;
+static job_recent_t recent[JOB_RECENT];
+static uint8_t recent_next;
+static portMUX_TYPE recent_lock = portMUX_INITIALIZER_UNLOCKED;
+static char restarted_id[JOB_ID_LEN];
+
+static const char *const job_state_names[JOB_STATE_COUNT] = {
+    [JOB_ACCEPTED] = "accepted",
+    [JOB_IN_PROGRESS] = "in_progress",
+    [JOB_SUCCEEDED] = "succeeded",
+    [JOB_FAILED] = "failed",
+};
+
+static void job_task(void *pvParameters);
+static void job_run(job_t *job);
+static void job_status(const char *id, job_state_t state, uint32_t queued_ms, uint32_t run_ms, const char *reason);
+static bool job_recent_find(const char *id, job_state_t *state);
+static void job_recent_set(const char *id, job_state_t state);
+static void job_restart_check(void);
+static bool job_restart(const job_t *job, const cJSON *root, const char **reason);
+static bool job_config(const job_t *job, const cJSON *root, const char **reason);
+static bool job_calibrate(const job_t *job, const cJSON *root, const char **reason);
+static bool job_capture(const job_t *job, const cJSON *root, const char **reason);
+
+static const struct
+{
+    const char *operation;
+    job_handler_t run;
+} job_handlers[] = {
+    {"restart", job_restart},
+    {"config", job_config},
+    {"calibrate", job_calibrate},
+    {"capture", job_capture},
+};
+/***********************************************************************************************************************
+ * Exported global variables and functions (to be accessed by other files)
+ ***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Imported global variables and functions (from other files)
+ ***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+ * Function Name: job_task_start
+ * Description  : called with mqtt_task_start() on every connection, only the first call starts the task
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+void job_task_start(void)
+{
+    if (job_queue == NULL)
+    {
+        mem_pool_init(&job_pool);
+        job_queue = xQueueCreateStatic(JOB_QUEUE_LEN, sizeof(job_t *), job_queue_storage, &job_queue_buffer);
+        job_restart_check();
+    }
+    task_registry_start(TASK_ID_JOB, job_task, NULL, NULL);
+}
+
+/***********************************************************************************************************************
+ * Function Name: job_submit
+ * Description  : queue a job for job_task and report it accepted. Called from the mqtt event task, returns at once.
+ *                A job id seen before is not run again, its current status is reported instead.
+ {
+   "operation": "restart" | "config" | "calibrate" | "capture", ...
+ }
+ * Arguments    : id - idempotency key, NULL for a local job, id_len, data, len
+ * Return Value : false when the job was rejected
+ ***********************************************************************************************************************/
+bool job_submit(const char *id, uint16_t id_len, const char *data, uint16_t len)
+{
+    char key[JOB_ID_LEN] = "";
+    job_state_t state;
+    job_t *job;
+
+    if ((job_queue == NULL) || (id_len >= JOB_ID_LEN))
+        return false;
+    if (id != NULL)
+        memcpy(key, id, id_len);
+    if (len >= JOB_PAYLOAD_LEN)
+    {
+        job_status(key, JOB_FAILED, 0, 0, "too long");
+        return false;
+    }
+    if ((key[0] != '\0') && job_recent_find(key, &state))
+    {
+        APP_LOGW("job %s again, still %s", key, job_state_names[state]);
+        job_status(key, state, 0, 0, "duplicate");
+        return true;
+    }
+    job = (job_t *)mem_pool_take(&job_pool, 0);
+    if (job == NULL)
+    {
+        job_status(key, JOB_FAILED, 0, 0, "busy");
+        return false;
+    }
+    strcpy(job->id, key);
+    job->accepted_ms = usertimer_gettick();
+    job->len = len;
+    memcpy(job->data, data, len);
+    job_recent_set(key, JOB_ACCEPTED);
+    job_status(key, JOB_ACCEPTED, 0, 0, NULL);
+    xQueueSend(job_queue, &job, 0); // as deep as the pool, never full
+    return true;
+}
+/***********************************************************************************************************************
+ * Static Functions
+ ***********************************************************************************************************************/
+static void job_task(void *pvParameters)
+{
+    job_t *job;
+
+    if (restarted_id[0] != '\0')
+        job_status(restarted_id, JOB_SUCCEEDED, 0, 0, NULL);
+    while (1)
+    {
+        xQueueReceive(job_queue, &job, portMAX_DELAY);
+        task_registry_wake(TASK_ID_JOB);
+        job_run(job);
+        mem_pool_give(&job_pool, job);
+    }
+}
+
+/***********************************************************************************************************************
+ * Function Name: job_run
+ * Description  : in progress, the handler, then succeeded or failed, each status with its timing
+ * Arguments    : job
+ * Return Value : none
+ ***********************************************************************************************************************/
+static void job_run(job_t *job)
+{
+    uint32_t started_ms = usertimer_gettick();
+    uint32_t queued_ms = started_ms - job->accepted_ms;
+    cJSON *root = cJSON_ParseWithLength(job->data, job->len);
+    cJSON *jOperation = cJSON_GetObjectItem(root, "operation");
+    const char *reason = "unknown operation";
+    job_state_t state = JOB_FAILED;
+
+    job_recent_set(job->id, JOB_IN_PROGRESS);
+    job_status(job->id, JOB_IN_PROGRESS, queued_ms, 0, NULL);
+    for (uint8_t i = 0; cJSON_IsString(jOperation) && (i < sizeof(job_handlers) / sizeof(job_handlers[0])); i++)
+    {
+        if (strcmp(jOperation->valuestring, job_handlers[i].operation) == 0)
+        {
+            reason = NULL;
+            state = job_handlers[i].run(job, root, &reason) ? JOB_SUCCEEDED : JOB_FAILED;
+            break;
+        }
+    }
+    cJSON_Delete(root);
+    job_recent_set(job->id, state);
+    job_status(job->id, state, queued_ms, usertimer_gettick() - started_ms, reason);
+    APP_LOGI("job %s %s after %u ms", job->id, job_state_names[state], usertimer_gettick() - job->accepted_ms);
+}
+
+/* QoS1 on mqtt_topic_jobpub, local jobs report nothing */
+static void job_status(const char *id, job_state_t state, uint32_t queued_ms, uint32_t run_ms, const char *reason)
+{
+    char *message_packet;
+
+    if (id[0] == '\0')
+        return;
+    message_packet = (char *)mem_pool_take(&json_msg_pool, JOB_POOL_WAIT_MS / portTICK_PERIOD_MS);
+    if (message_packet == NULL)
+        return;
+    json_packet_job_status(message_packet, id, job_state_names[state], queued_ms, run_ms, reason);
+    outbox_put(mqtt_config.mqtt_topic_jobpub, message_packet, strlen(message_packet), 1, OUTBOX_PRIO_NORMAL,
+               TRACE_ID_NONE);
+    mem_pool_give(&json_msg_pool, message_packet);
+    task_registry_notify(TASK_ID_MQTT_SEND);
+}
+
+static bool job_recent_find(const char *id, job_state_t *state)
+{
+    bool found = false;
+
+    portENTER_CRITICAL(&recent_lock);
+    for (uint8_t i = 0; (i < JOB_RECENT) && (found == false); i++)
+    {
+        if (strcmp(recent[i].id, id) == 0)
+        {
+            *state = recent[i].state;
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&recent_lock);
+    return found;
+}
+
+/* the oldest id is forgotten first */
+static void job_recent_set(const char *id, job_state_t state)
+{
+    uint8_t i;
+
+    if (id[0] == '\0')
+        return;
+    portENTER_CRITICAL(&recent_lock);
+    for (i = 0; (i < JOB_RECENT) && (strcmp(recent[i].id, id) != 0); i++)
+        ;
+    if (i == JOB_RECENT)
+    {
+        i = recent_next;
+        recent_next = (recent_next + 1) % JOB_RECENT;
+        strcpy(recent[i].id, id);
+    }
+    recent[i].state = state;
+    portEXIT_CRITICAL(&recent_lock);
+}
+
+/* a restart job that brought this boot: remember it against redelivery and report it done */
+static void job_restart_check(void)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(restarted_id);
+
+    if (nvs_open(JOB_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+        return;
+    if (nvs_get_str(handle, JOB_NVS_RESTART_KEY, restarted_id, &size) == ESP_OK)
+    {
+        job_recent_set(restarted_id, JOB_SUCCEEDED);
+        nvs_erase_key(handle, JOB_NVS_RESTART_KEY);
+        nvs_commit(handle);
+    }
+    else
+        restarted_id[0] = '\0';
+    nvs_close(handle);
+}
+
+/***********************************************************************************************************************
+ * Function Name: job_restart
+ * Description  : {"operation": "restart"}, the id survives in nvs and the next boot reports the job succeeded
+ * Arguments    : job, root, reason
+ * Return Value : false when the id could not be kept, the device does not restart then
+ ***********************************************************************************************************************/
+static bool job_restart(const job_t *job, const cJSON *root, const char **reason)
+{
+    nvs_handle_t handle;
+    esp_err_t err = ESP_OK;
+
+    if (job->id[0] != '\0')
+    {
+        err = nvs_open(JOB_NVS_NAMESPACE, NVS_READWRITE, &handle);
+        if (err == ESP_OK)
+        {
+            err = nvs_set_str(handle, JOB_NVS_RESTART_KEY, job->id);
+            if (err == ESP_OK)
+                err = nvs_commit(handle);
+            nvs_close(handle);
+        }
+    }
+    if (err != ESP_OK)
+    {
+        *reason = "nvs";
+        return false;
+    }
+    for (uint32_t waited = 0; (outbox_empty() == false) && (waited < JOB_RESTART_FLUSH_MS); waited += JOB_POLL_MS)
+        vTaskDelay(JOB_POLL_MS / portTICK_PERIOD_MS);
+    APP_LOGI("restart by job %s", job->id);
+    esp_restart();
+    return true;
+}
+
+/* {"operation": "config", "state": {"vibration": 70, ...}}, the shadow desired state as a merge patch */
+static bool job_config(const job_t *job, const cJSON *root, const char **reason)
+{
+    if (!cJSON_IsObject(cJSON_GetObjectItem(root, "state")))
+    {
+        *reason = "no state";
+        return false;
+    }
+    return shadow_apply_desired(job->data, job->len);
+}
+
+/* {"operation": "calibrate"}, one thermal bias point, the hammer lies still and flat */
+static bool job_calibrate(const job_t *job, const cJSON *root, const char **reason)
+{
+    bool stored = false;
+    uint32_t waited = 0;
+
+    imu_calib_request_capture();
+    while ((imu_calib_capture_result(&stored) == false) && (waited < JOB_CALIBRATE_TIMEOUT_MS))
+    {
+        vTaskDelay(JOB_POLL_MS / portTICK_PERIOD_MS);
+        waited += JOB_POLL_MS;
+    }
+    if (waited >= JOB_CALIBRATE_TIMEOUT_MS)
+        *reason = "timeout";
+    else if (stored == false)
+        *reason = "point rejected";
+    return (*reason == NULL);
+}
+
+/***********************************************************************************************************************
+ * Function Name: job_capture
+ * Description  : {"operation": "capture", "what": ["diagnostics", "profile", "trace", "strikes"]}, the first three
+ *                without "what".
+ *                Succeeds once mqtt_send_task has published every report.
+ * Arguments    : job, root, reason
+ * Return Value : true when published
+ ***********************************************************************************************************************/
+static bool job_capture(const job_t *job, const cJSON *root, const char **reason)
+{
+    const cJSON *jWhat = cJSON_GetObjectItem(root, "what");
+    const cJSON *item;
+    uint32_t waited = 0;
+
+    if (deive_data.mqtt_status == false)
+    {
+        *reason = "offline";
+        return false;
+    }
+    if (!cJSON_IsArray(jWhat))
+        deive_data.diag_request = deive_data.profile_request = deive_data.trace_request = true;
+    cJSON_ArrayForEach(item, jWhat)
+    {
+        if (!cJSON_IsString(item))
+            continue;
+        if (strcmp(item->valuestring, "diagnostics") == 0)
+            deive_data.diag_request = true;
+        else if (strcmp(item->valuestring, "profile") == 0)
+            deive_data.profile_request = true;
+        else if (strcmp(item->valuestring, "trace") == 0)
+            deive_data.trace_request = true;
+        else if (strcmp(item->valuestring, "strikes") == 0)
+            deive_data.strikes_request = true;
+    }
+    task_registry_notify(TASK_ID_MQTT_SEND);
+    while ((deive_data.diag_request || deive_data.profile_request || deive_data.trace_request ||
+            deive_data.strikes_request) &&
+           (waited < JOB_CAPTURE_TIMEOUT_MS))
+    {
+        vTaskDelay(JOB_POLL_MS / portTICK_PERIOD_MS);
+        waited += JOB_POLL_MS;
+    }
+    if (waited >= JOB_CAPTURE_TIMEOUT_MS)
+        *reason = "timeout";
+    return (*reason == NULL);
+}
+/***********************************************************************************************************************
+ * End of file
+ ***********************************************************************************************************************/
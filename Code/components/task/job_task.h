@@ -0,0 +1,41 @@
+/*
+ * job_task.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef MAIN_TASK_JOB_TASK_H_
+#define MAIN_TASK_JOB_TASK_H_
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define JOB_ID_LEN (40)
+#define JOB_PAYLOAD_LEN (512)
+#define JOB_QUEUE_LEN (4)
+#define JOB_RECENT (16) // job ids remembered against redelivery
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+    JOB_ACCEPTED,
+    JOB_IN_PROGRESS,
+    JOB_SUCCEEDED,
+    JOB_FAILED,
+    JOB_STATE_COUNT
+} job_state_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void job_task_start(void);
+
+bool job_submit(const char *id, uint16_t id_len, const char *data, uint16_t len);
+#endif /* MAIN_TASK_JOB_TASK_H_ */
@@ -7,17 +7,30 @@
 /***********************************************************************************************************************
  * Pragma directive
  ***********************************************************************************************************************/
-
+#define APP_LOG_MODULE LOG_MODULE_MQTT
 /***********************************************************************************************************************
  * Includes <System Includes>
  ***********************************************************************************************************************/
 #include "mqtt_task.h"
 #include "../../components/json_parser/json_parser.h"
+#include "../../components/json_parser/shadow.h"
+#include "job_task.h"
 #include "../../Common.h"
 #include "../../main.h"
+#include "../user_driver/user_leds.h"
+#include "../system/task_registry.h"
+#include "../system/trace.h"
+#include "../system/power.h"
+#include "../system/standby.h"
+#include "../system/prov_store.h"
+#include "../system/outbox.h"
+#include "../system/topic_router.h"
+#include "../system/metrics.h"
+#include "../esp32_wifi_manager/src/wifi_manager.h"
 
 #include "esp_wifi.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 
 #include "esp_event.h"
 #include "esp_netif.h"
@@ -28,6 +41,8 @@
 #include "lwip/netdb.h"
 #include "esp_tls.h"
 #include "esp_crt_bundle.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ecp.h"
 
 #include "esp_http_client.h"
 
@@ -40,6 +55,13 @@ static const char *TAG = "MQTTS_EXAMPLE";
  ***********************************************************************************************************************/
 #define MAX_HTTP_RECV_BUFFER 512
 #define MAX_HTTP_OUTPUT_BUFFER 2048
+#define MQTT_POOL_WAIT_MS 100
+#define MQTT_SEND_IDLE_MS 1000 // requests notify the task, this only bounds a missed notification
+#define MQTT_KEEPALIVE_S 120   // one ping per 2 min, the modem sleeps in between
+#define MQTT_RX_BUFFER_BYTES 2048 // a shadow/get document with its metadata, the default 1024 fragments it
+#define MQTT_BUILTIN_URI "mqtts://am25aqsnybb6p-ats.iot.sa-east-1.amazonaws.com:8883"
+#define MQTT_BUILTIN_CLIENT_ID "sdk-nodejs-e07c7d1a-1def-45b2-a492-f6874c5dd09e"
+#define MQTT_TOPIC_ROOT "hammer" // per-device topics are hammer/<client id>/...
 /***********************************************************************************************************************
  * Private global variables and functions
  ***********************************************************************************************************************/
@@ -114,6 +136,19 @@ const char *server_cert_pem_start = "-----BEGIN CERTIFICATE-----\n"
                                     "-----END CERTIFICATE-----\n";
 
 static esp_mqtt_client_handle_t client;
+/* DER credentials, in place in the prov partition or decoded once from the built-in PEM. esp-tls skips the PEM scan
+ * and base64 on every connect. */
+static prov_blob_t mqtt_creds[PROV_ITEM_COUNT];
+static int64_t handshake_start_us = 0;
+static bool tls_power_locked = false; // POWER_LOCK_NET held from BEFORE_CONNECT until the connect outcome
+static char topic_shadow_update[100];
+static char topic_shadow_delta[100];
+static char topic_shadow_get[100];
+static char topic_shadow_get_accepted[100];
+static volatile bool shadow_get_pending = false; // read the cloud's shadow back once connected
+static char topic_job_start[100];
+static char topic_metrics[100];
+static char topic_strikes[100];
 
 static void mqtt_app_start(void);
 static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event);
@@ -126,17 +161,44 @@ static void mqtt_send_task(void *pvParameters);
  * Imported global variables and functions (from other files)
  ***********************************************************************************************************************/
 static void error_message_send(void);
-static char *wifi_get_mac(void);
+static void wifi_get_mac(char *mac_add);
+static void mqtt_tls_power_unlock(void);
+static void mqtt_connect_timing_update(void);
+static void mqtt_credentials_load(void);
+static void mqtt_builtin_der(prov_item_t item, const char *pem);
+static void mqtt_credentials_log(void);
+static bool mqtt_standby_hold(void);
+static int mqtt_outbox_send(const char *topic, const char *data, uint16_t len, uint8_t qos);
+static int mqtt_subscribe(const char *filter, uint8_t qos);
+static void mqtt_command_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len);
+static void mqtt_shadow_delta_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len);
+static void mqtt_shadow_get_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len);
+static void mqtt_job_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len);
 /***********************************************************************************************************************
- * Function Name:
- * Description  :
+ * Function Name: mqtt_task_init
+ * Description  : boot time, the outbox takes messages before the first connection and holds standby while it has any,
+ *                its high priority messages are kept over standby
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+void mqtt_task_init(void)
+{
+    outbox_init(mqtt_outbox_send);
+    standby_register_hold(mqtt_standby_hold);
+    standby_register_prepare(outbox_retain); // hit reports and strike summaries a forced standby would lose
+}
+
+/***********************************************************************************************************************
+ * Function Name: mqtt_task_start
+ * Description  : called on every got-IP
  * Arguments    : none
  * Return Value : none
  ***********************************************************************************************************************/
 void mqtt_task_start(void)
 {
     mqtt_app_start(); // init mqtt connect to AWS
-    xTaskCreatePinnedToCore(mqtt_send_task, "mqtt_send_task", 3 * 1024, NULL, 6 | portPRIVILEGE_BIT, NULL, 1);
+    task_registry_start(TASK_ID_MQTT_SEND, mqtt_send_task, NULL, NULL);
+    job_task_start();
 }
 /***********************************************************************************************************************
  * Static Functions
@@ -150,17 +212,30 @@ void mqtt_task_start(void)
 
 static void mqtt_app_start(void)
 {
+    // one client for the life of the app, a new IP only cuts its reconnect delay short
+    if (client != NULL)
+    {
+        if (deive_data.mqtt_status == false)
+            esp_mqtt_client_reconnect(client);
+        return;
+    }
     // mqtt_get_cer();
-    char client_id[50] = "sdk-nodejs-e07c7d1a-1def-45b2-a492-f6874c5dd09e";
-    sprintf(deive_data.mac_add, "%s", wifi_get_mac());
+    wifi_get_mac(deive_data.mac_add);
+    mqtt_credentials_load();
+    const char *client_id = (const char *)mqtt_creds[PROV_ITEM_CLIENT_ID].data;
     APP_LOGI("Client id: %s", client_id);
     const esp_mqtt_client_config_t mqtt_cfg = {
-        .uri = "mqtts://am25aqsnybb6p-ats.iot.sa-east-1.amazonaws.com:8883",
+        .uri = (const char *)mqtt_creds[PROV_ITEM_URI].data,
         .event_handle = mqtt_event_handler,
-        .client_cert_pem = (const char *)client_cert_pem_start,
-        .client_key_pem = (const char *)client_key_pem_start,
-        .cert_pem = (const char *)server_cert_pem_start,
+        .client_cert_pem = (const char *)mqtt_creds[PROV_ITEM_CERT].data,
+        .client_cert_len = mqtt_creds[PROV_ITEM_CERT].len,
+        .client_key_pem = (const char *)mqtt_creds[PROV_ITEM_KEY].data,
+        .client_key_len = mqtt_creds[PROV_ITEM_KEY].len,
+        .cert_pem = (const char *)mqtt_creds[PROV_ITEM_CA].data,
+        .cert_len = mqtt_creds[PROV_ITEM_CA].len,
         .client_id = client_id,
+        .keepalive = MQTT_KEEPALIVE_S,
+        .buffer_size = MQTT_RX_BUFFER_BYTES,
         // .use_global_ca_store = true,
     };
 
@@ -182,18 +257,34 @@ static void mqtt_app_start(void)
 
     sprintf(mqtt_config.mqtt_topic_pub, "%s", "topic_1");
     // sprintf(mqtt_config.mqtt_topic_pub_err, "stag/dt/ard-smartstop/%s/error", client_id);
-    sprintf(mqtt_config.mqtt_topic_jobsub, "topic_2");
-    // sprintf(mqtt_config.mqtt_topic_jobpub, "stag/job/ard-smartstop/%s/status", client_id);
+    // commands only for this device, the broker no longer fans them out to every hammer
+    snprintf(mqtt_config.mqtt_topic_jobsub, sizeof(mqtt_config.mqtt_topic_jobsub), "%s/%s/cmd/#", MQTT_TOPIC_ROOT,
+             client_id);
+    topic_router_add(mqtt_config.mqtt_topic_jobsub, 1, mqtt_command_handler);
+    snprintf(topic_shadow_update, sizeof(topic_shadow_update), "%s/%s/shadow/update", MQTT_TOPIC_ROOT, client_id);
+    snprintf(topic_shadow_delta, sizeof(topic_shadow_delta), "%s/%s/shadow/update/delta", MQTT_TOPIC_ROOT, client_id);
+    topic_router_add(topic_shadow_delta, 1, mqtt_shadow_delta_handler);
+    snprintf(topic_shadow_get, sizeof(topic_shadow_get), "%s/%s/shadow/get", MQTT_TOPIC_ROOT, client_id);
+    snprintf(topic_shadow_get_accepted, sizeof(topic_shadow_get_accepted), "%s/%s/shadow/get/accepted",
+             MQTT_TOPIC_ROOT, client_id);
+    topic_router_add(topic_shadow_get_accepted, 1, mqtt_shadow_get_handler);
+    // jobs/<job id>/start, status of every job on jobs/status
+    snprintf(topic_job_start, sizeof(topic_job_start), "%s/%s/jobs/+/start", MQTT_TOPIC_ROOT, client_id);
+    topic_router_add(topic_job_start, 1, mqtt_job_handler);
+    snprintf(mqtt_config.mqtt_topic_jobpub, sizeof(mqtt_config.mqtt_topic_jobpub), "%s/%s/jobs/status",
+             MQTT_TOPIC_ROOT, client_id);
+    snprintf(topic_metrics, sizeof(topic_metrics), "%s/%s/metrics", MQTT_TOPIC_ROOT, client_id);
+    snprintf(topic_strikes, sizeof(topic_strikes), "%s/%s/strikes", MQTT_TOPIC_ROOT, client_id);
 
     // sprintf((char *)mqtt_cfg.client_id, "ard-smartstop-%s", wifi_get_mac());
     APP_LOGI("mqtt_topic_pub = %s", mqtt_config.mqtt_topic_pub);
     // APP_LOGI("mqtt_topic_pub_err = %s", mqtt_config.mqtt_topic_pub_err);
     APP_LOGI("mqtt_topic_jobsub = %s", mqtt_config.mqtt_topic_jobsub);
-    // APP_LOGI("mqtt_topic_jobpub = %s", mqtt_config.mqtt_topic_jobpub);
+    APP_LOGI("mqtt_topic_jobpub = %s", mqtt_config.mqtt_topic_jobpub);
     // APP_LOGI("mqtt_cfg.client_id = %s", mqtt_cfg.client_id);
 
     ESP_LOGI(TAG, "[APP] Free memory: %d bytes", esp_get_free_heap_size());
-    esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
+    client = esp_mqtt_client_init(&mqtt_cfg);
     esp_mqtt_client_start(client);
 }
 /***********************************************************************************************************************
@@ -206,19 +297,34 @@ static void mqtt_app_start(void)
 static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
 {
     client = event->client;
-    int msg_id;
     // your_context_t *context = event->context;
     switch (event->event_id)
     {
+    case MQTT_EVENT_BEFORE_CONNECT:
+        // the TLS handshake runs at full clock, released on the outcome
+        handshake_start_us = esp_timer_get_time();
+        if (tls_power_locked == false)
+        {
+            tls_power_locked = true;
+            power_lock(POWER_LOCK_NET);
+        }
+        break;
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
+        mqtt_tls_power_unlock();
+        mqtt_connect_timing_update();
         deive_data.mqtt_status = true;
-        msg_id = esp_mqtt_client_subscribe(client, mqtt_config.mqtt_topic_jobsub, 0);
-        ESP_LOGI(TAG, "sent subscribe successful, msg_id=%d", msg_id);
+        leds_show_status();
+        topic_router_subscribe(mqtt_subscribe);
+        shadow_get_pending = true; // desired changes made while offline come back in the document
+        task_registry_notify(TASK_ID_MQTT_SEND); // publish what queued up while offline
         break;
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+        metrics_add(METRIC_MQTT_DISCONNECTS, 1);
+        mqtt_tls_power_unlock();
         deive_data.mqtt_status = false;
+        leds_show_status();
         break;
 
     case MQTT_EVENT_SUBSCRIBED:
@@ -228,17 +334,33 @@ static esp_err_t mqtt_event_handler(esp_mqtt_event_handle_t event)
         ESP_LOGI(TAG, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
         break;
     case MQTT_EVENT_PUBLISHED:
-        ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        // PUBACK, a window place is free
+        APP_LOGD("MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        outbox_acked(event->msg_id);
+        task_registry_notify(TASK_ID_MQTT_SEND);
         break;
+#ifdef CONFIG_MQTT_REPORT_DELETED_MESSAGES
+    case MQTT_EVENT_DELETED:
+        // the client's own outbox expired a QoS1 message, ours publishes it again
+        APP_LOGW("MQTT_EVENT_DELETED, msg_id=%d", event->msg_id);
+        outbox_expired(event->msg_id);
+        task_registry_notify(TASK_ID_MQTT_SEND);
+        break;
+#endif
     case MQTT_EVENT_DATA:
-        ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-        printf("TOPIC=%.*s\r\n", event->topic_len, event->topic);
-        printf("DATA=%.*s\r\n", event->data_len, event->data);
-        bool status = json_parser_job((const char *)event->data, event->data_len);
-        APP_LOGI("status = %d", status);
+        APP_LOGD("TOPIC=%.*s", event->topic_len, event->topic);
+        APP_LOGD("DATA=%.*s", event->data_len, event->data);
+        standby_activity();
+        // a message over the client buffer arrives in pieces, only the first one carries the topic
+        if ((event->topic_len == 0) || (event->data_len != event->total_data_len))
+            APP_LOGW("fragmented message dropped, %d B", event->total_data_len);
+        else
+            topic_router_dispatch(event->topic, event->topic_len, event->data, event->data_len);
         break;
     case MQTT_EVENT_ERROR:
         ESP_LOGI(TAG, "MQTT_EVENT_ERROR");
+        metrics_add(METRIC_MQTT_ERRORS, 1);
+        mqtt_tls_power_unlock();
         break;
     default:
         ESP_LOGI(TAG, "Other event id:%d", event->event_id);
@@ -261,46 +383,249 @@ static void mqtt_send_task(void *pvParameters)
     int msg_id = -1;
     while (1)
     {
-        if (deive_data.mqtt_status == true)
+        task_registry_wake(TASK_ID_MQTT_SEND);
+        // hit reports queue while offline too, QoS1 keeps them until the broker has them
+        if (deive_data.sensor.hammer_detect == 1)
         {
-            if (deive_data.sensor.hammer_detect == 1)
+            APP_LOGI("-----user send data to the cloud");
+            uint16_t trace_id = deive_data.sensor.trace_id;
+            trace_point(trace_id, TRACE_MQTT_PICKUP);
+            char *message_packet = (char *)mem_pool_take(&json_msg_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+            if (message_packet != NULL)
             {
-                APP_LOGI("-----user send data to the cloud");
-                char *message_packet = (char *)malloc(200 * sizeof(char));
-                memset(message_packet, 0x00, 200 * sizeof(char));
                 json_packet_message_sensor(message_packet);
+                trace_point(trace_id, TRACE_MQTT_SERIALIZED);
                 APP_LOGI("send : = %s", message_packet);
-                msg_id = esp_mqtt_client_publish(client, mqtt_config.mqtt_topic_pub, message_packet, 0, 0, 0);
-                memset(message_packet, 0x00, 200 * sizeof(char));
-                free(message_packet);
-                APP_LOGI("sent publish successful, msg_id=%d", msg_id);
-                deive_data.sensor.hammer_detect = 0; // clean hammer detection
+                outbox_put(mqtt_config.mqtt_topic_pub, message_packet, strlen(message_packet), 1, OUTBOX_PRIO_HIGH,
+                           trace_id);
+                mem_pool_give(&json_msg_pool, message_packet);
+            }
+            deive_data.sensor.hammer_detect = 0; // clean hammer detection
+        }
+        // strike summaries queue while offline like hit reports, an idle window sends nothing
+        strike_window_t window;
+        if (strike_stats_close(&window) == true)
+        {
+            char *message_packet = (char *)mem_pool_take(&json_msg_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+            if ((message_packet != NULL) && json_packet_strikes(message_packet, JSON_MESSAGE_LEN, &window))
+                outbox_put(topic_strikes, message_packet, strlen(message_packet), 1, OUTBOX_PRIO_HIGH, TRACE_ID_NONE);
+            mem_pool_give(&json_msg_pool, message_packet);
+        }
+        bool work = deive_data.diag_request || deive_data.profile_request || deive_data.trace_request ||
+                    deive_data.strikes_request || shadow_get_pending || shadow_due() || metrics_due() ||
+                    (outbox_empty() == false);
+        if ((deive_data.mqtt_status == true) && (work == true))
+        {
+            power_lock(POWER_LOCK_NET);
+            if (deive_data.diag_request == true)
+            {
+                deive_data.diag_request = false;
+                char *message_packet = (char *)mem_pool_take(&json_msg_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+                if ((message_packet != NULL) && json_packet_diagnostics(message_packet, JSON_MESSAGE_LEN))
+                    outbox_put(mqtt_config.mqtt_topic_pub, message_packet, strlen(message_packet), 0, OUTBOX_PRIO_LOW,
+                               TRACE_ID_NONE);
+                mem_pool_give(&json_msg_pool, message_packet);
+            }
+            if (shadow_get_pending == true)
+            {
+                shadow_get_pending = false;
+                outbox_put(topic_shadow_get, "{}", 2, 0, OUTBOX_PRIO_NORMAL, TRACE_ID_NONE);
             }
+            if (shadow_due() == true)
+            {
+                char *message_packet = (char *)mem_pool_take(&json_msg_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+                // a report the outbox did not take is not the cloud's state, the next one is full
+                if ((message_packet != NULL) && shadow_report(message_packet, JSON_MESSAGE_LEN) &&
+                    (outbox_put(topic_shadow_update, message_packet, strlen(message_packet), 1, OUTBOX_PRIO_NORMAL,
+                                TRACE_ID_NONE) == false))
+                    shadow_resync();
+                mem_pool_give(&json_msg_pool, message_packet);
+            }
+            if (metrics_due() == true)
+            {
+                metrics_rearm();
+                char *message_packet = (char *)mem_pool_take(&json_msg_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+                if ((message_packet != NULL) && json_packet_metrics(message_packet, JSON_MESSAGE_LEN))
+                    outbox_put(topic_metrics, message_packet, strlen(message_packet), 0, OUTBOX_PRIO_LOW,
+                               TRACE_ID_NONE);
+                mem_pool_give(&json_msg_pool, message_packet);
+            }
+            outbox_pump();
+            if (deive_data.profile_request == true)
+            {
+                deive_data.profile_request = false;
+                char *message_packet = (char *)mem_pool_take(&json_report_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+                if ((message_packet != NULL) && json_packet_profile(message_packet, JSON_PROFILE_MESSAGE_LEN))
+                {
+                    msg_id = esp_mqtt_client_publish(client, mqtt_config.mqtt_topic_pub, message_packet, 0, 0, 0);
+                    APP_LOGI("profile published, msg_id=%d", msg_id);
+                }
+                mem_pool_give(&json_report_pool, message_packet);
+            }
+            if (deive_data.trace_request == true)
+            {
+                deive_data.trace_request = false;
+                uint32_t cursor = trace_oldest();
+                char *message_packet = (char *)mem_pool_take(&json_report_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+                while ((message_packet != NULL) && json_packet_trace(message_packet, JSON_PROFILE_MESSAGE_LEN, &cursor))
+                {
+                    msg_id = esp_mqtt_client_publish(client, mqtt_config.mqtt_topic_pub, message_packet, 0, 0, 0);
+                }
+                mem_pool_give(&json_report_pool, message_packet);
+                APP_LOGI("trace published");
+            }
+            if (deive_data.strikes_request == true)
+            {
+                deive_data.strikes_request = false;
+                uint32_t cursor = strike_stats_oldest();
+                char *message_packet = (char *)mem_pool_take(&json_report_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+                while ((message_packet != NULL) &&
+                       json_packet_strikes_raw(message_packet, JSON_PROFILE_MESSAGE_LEN, &cursor))
+                {
+                    msg_id = esp_mqtt_client_publish(client, topic_strikes, message_packet, 0, 0, 0);
+                }
+                mem_pool_give(&json_report_pool, message_packet);
+                APP_LOGI("raw strikes published");
+            }
+            power_unlock(POWER_LOCK_NET);
         }
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        ulTaskNotifyTake(pdTRUE, MQTT_SEND_IDLE_MS / portTICK_PERIOD_MS);
     }
 }
 
-void mqtt_send_message(char *event_id)
+void mqtt_send_message(char *event_id, uint16_t trace_id)
 {
-    int msg_id = -1;
     APP_LOGD("-----user send data to the cloud");
-    char *message_packet = (char *)malloc(200 * sizeof(char));
-    memset(message_packet, 0x00, 200 * sizeof(char));
+    char *message_packet = (char *)mem_pool_take(&json_msg_pool, MQTT_POOL_WAIT_MS / portTICK_PERIOD_MS);
+    if (message_packet == NULL)
+        return;
     json_packet_event_buttons(message_packet, event_id);
+    trace_point(trace_id, TRACE_MQTT_SERIALIZED);
     APP_LOGD("send : = %s", message_packet);
-    msg_id = esp_mqtt_client_publish(client, mqtt_config.mqtt_topic_pub, message_packet, 0, 0, 0);
-    memset(message_packet, 0x00, 200 * sizeof(char));
-    free(message_packet);
-    APP_LOGD("sent publish successful, msg_id=%d", msg_id);
+    // mqtt_send_task publishes it, QoS1 after a hit report already queued
+    outbox_put(mqtt_config.mqtt_topic_pub, message_packet, strlen(message_packet), 1, OUTBOX_PRIO_NORMAL, trace_id);
+    mem_pool_give(&json_msg_pool, message_packet);
+    task_registry_notify(TASK_ID_MQTT_SEND);
+}
+
+/* topic_subscribe_t */
+static int mqtt_subscribe(const char *filter, uint8_t qos)
+{
+    return esp_mqtt_client_subscribe(client, filter, qos);
+}
+
+/* hammer/<client id>/cmd/#, the operation set of json_parser_job() */
+static void mqtt_command_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len)
+{
+    bool status = json_parser_job(data, len);
+    APP_LOGI("%.*s status = %d", topic_len, topic, status);
+}
+
+/* hammer/<client id>/shadow/update/delta, desired settings that differ from the reported ones */
+static void mqtt_shadow_delta_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len)
+{
+    if (shadow_apply_desired(data, len) == false)
+        APP_LOGW("shadow delta is not an object");
+    task_registry_notify(TASK_ID_MQTT_SEND);
+}
+
+/* hammer/<client id>/shadow/get/accepted, the whole shadow document after the shadow/get of a (re)connect */
+static void mqtt_shadow_get_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len)
+{
+    if (shadow_apply_document(data, len) == false)
+        APP_LOGW("shadow document is not an object");
+    task_registry_notify(TASK_ID_MQTT_SEND);
+}
+
+/* hammer/<client id>/jobs/<job id>/start, the job id is the level before start */
+static void mqtt_job_handler(const char *topic, uint16_t topic_len, const char *data, uint16_t len)
+{
+    uint16_t end = topic_len - (sizeof("/start") - 1);
+    uint16_t start = end;
+
+    while ((start > 0) && (topic[start - 1] != '/'))
+        start--;
+    if (job_submit(&topic[start], end - start, data, len) == false)
+        APP_LOGW("job %.*s rejected", end - start, &topic[start]);
+}
+
+/* outbox_send_t, runs in mqtt_send_task */
+static int mqtt_outbox_send(const char *topic, const char *data, uint16_t len, uint8_t qos)
+{
+    int msg_id = esp_mqtt_client_publish(client, topic, data, len, qos, 0);
+
+    if (msg_id >= 0)
+        standby_first_publish();
+    APP_LOGD("sent publish qos %u, msg_id=%d", qos, msg_id);
+    return msg_id;
+}
+/***********************************************************************************************************************
+ * Function Name: mqtt_credentials_load
+ * Description  : endpoint and identity from the prov partition, zero-copy, or the built-in ones of the development
+ *                build. Runs once.
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+static void mqtt_credentials_load(void)
+{
+    if (mqtt_creds[PROV_ITEM_URI].data != NULL)
+        return;
+    if (prov_store_provisioned() == true)
+    {
+        for (uint8_t i = 0; i < PROV_ITEM_COUNT; i++)
+            prov_store_get(i, &mqtt_creds[i]);
+    }
+    else
+    {
+        mqtt_creds[PROV_ITEM_URI] = (prov_blob_t){(const uint8_t *)MQTT_BUILTIN_URI, sizeof(MQTT_BUILTIN_URI)};
+        mqtt_creds[PROV_ITEM_CLIENT_ID] =
+            (prov_blob_t){(const uint8_t *)MQTT_BUILTIN_CLIENT_ID, sizeof(MQTT_BUILTIN_CLIENT_ID)};
+        mqtt_builtin_der(PROV_ITEM_CA, server_cert_pem_start);
+        mqtt_builtin_der(PROV_ITEM_CERT, client_cert_pem_start);
+        mqtt_builtin_der(PROV_ITEM_KEY, client_key_pem_start);
+    }
+    mqtt_credentials_log();
+}
+
+static void mqtt_builtin_der(prov_item_t item, const char *pem)
+{
+    size_t size = strlen(pem) * 3 / 4;
+    uint8_t *der = malloc(size);
+
+    if (der == NULL)
+        return;
+    mqtt_creds[item].data = der;
+    mqtt_creds[item].len = prov_pem_to_der(pem, der, size);
+    if (mqtt_creds[item].len == 0)
+        APP_LOGE("built-in %s pem decode failed", prov_item_name(item));
+}
+
+/***********************************************************************************************************************
+ * Function Name: mqtt_credentials_log
+ * Description  : parse the device key once at boot to report its type, esp-tls parses it again per connect
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+static void mqtt_credentials_log(void)
+{
+    mbedtls_pk_context pk;
+
+    mbedtls_pk_init(&pk);
+    if (mbedtls_pk_parse_key(&pk, mqtt_creds[PROV_ITEM_KEY].data, mqtt_creds[PROV_ITEM_KEY].len, NULL, 0) != 0)
+        APP_LOGE("device key unreadable");
+    else if (mbedtls_pk_get_type(&pk) == MBEDTLS_PK_ECKEY)
+        APP_LOGI("device key ecdsa %s, cert %u B",
+                 (mbedtls_pk_ec(pk)->grp.id == MBEDTLS_ECP_DP_SECP256R1) ? "p-256" : "other curve",
+                 mqtt_creds[PROV_ITEM_CERT].len);
+    else
+        APP_LOGI("device key rsa-%u, cert %u B", mbedtls_pk_get_bitlen(&pk), mqtt_creds[PROV_ITEM_CERT].len);
+    mbedtls_pk_free(&pk);
 }
 /***********************************************************************************************************************
  * End of file
  ***********************************************************************************************************************/
-static char *wifi_get_mac(void)
+static void wifi_get_mac(char *mac_add)
 {
-    char *mac_add;
-    mac_add = (char *)malloc(18 + 1);
     // Get the derived MAC address for each network interface
     uint8_t derived_mac_addr[6] = {0};
     // Get MAC address for WiFi Station interface
@@ -308,5 +633,55 @@ static char *wifi_get_mac(void)
     sprintf(mac_add, "%x:%x:%x:%x:%x:%x", derived_mac_addr[0], derived_mac_addr[1], derived_mac_addr[2], derived_mac_addr[3],
             derived_mac_addr[4], derived_mac_addr[5]);
     APP_LOGD("wifi_get_mac end = %s", mac_add);
-    return mac_add;
-}
\ No newline at end of file
+}
+
+/* standby waits for the outbox, a QoS1 message still unacked would be lost in deep sleep */
+static bool mqtt_standby_hold(void)
+{
+    return outbox_empty() == false;
+}
+
+static void mqtt_tls_power_unlock(void)
+{
+    if (tls_power_locked == true)
+    {
+        tls_power_locked = false;
+        power_unlock(POWER_LOCK_NET);
+    }
+}
+
+/***********************************************************************************************************************
+ * Function Name: mqtt_connect_timing_update
+ * Description  : on CONNACK, time the broker connect and split the time since the Wi-Fi connect into phases. A broker
+ *                reconnect on the same IP address only updates the handshake time.
+ * Arguments    : none
+ * Return Value : none
+ ***********************************************************************************************************************/
+static void mqtt_connect_timing_update(void)
+{
+    static int64_t reported_got_ip_us = 0;
+    wifi_manager_connect_timing_t timing;
+    int64_t now = esp_timer_get_time();
+    connect_timing_t *connect = &deive_data.connect;
+
+    if (handshake_start_us != 0)
+    {
+        connect->handshake_ms = (now - handshake_start_us) / 1000;
+        connect->handshakes++;
+        handshake_start_us = 0;
+        APP_LOGI("broker connect #%u, tcp + tls + connack %u ms", connect->handshakes, connect->handshake_ms);
+    }
+    wifi_manager_get_connect_timing(&timing);
+    if ((timing.connected_us == 0) || (timing.got_ip_us == 0) || (timing.got_ip_us == reported_got_ip_us))
+        return;
+    reported_got_ip_us = timing.got_ip_us;
+    connect->assoc_ms = (timing.connected_us - timing.connect_us) / 1000;
+    connect->dhcp_ms = (timing.got_ip_us - timing.connected_us) / 1000;
+    connect->connack_ms = (now - timing.got_ip_us) / 1000;
+    connect->total_ms = (now - timing.connect_us) / 1000;
+    connect->fast = timing.fast;
+    connect->static_ip = timing.static_ip;
+    metrics_observe(METRIC_CONNECT_MS, connect->total_ms);
+    APP_LOGI("connect %u ms: assoc %u, %s %u, connack %u, fast %d", connect->total_ms, connect->assoc_ms,
+             connect->static_ip ? "static ip" : "dhcp", connect->dhcp_ms, connect->connack_ms, connect->fast);
+}
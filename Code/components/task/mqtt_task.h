@@ -23,7 +23,9 @@
 /****************************************************************************/
 /***         Exported global functions                                     ***/
 /****************************************************************************/
+void mqtt_task_init(void);
+
 void mqtt_task_start(void);
 
-void mqtt_send_message(char *event_id);
+void mqtt_send_message(char *event_id, uint16_t trace_id);
 #endif /* MAIN_TASK_MQTT_TASK_H_ */
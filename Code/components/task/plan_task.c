@@ -7,7 +7,7 @@
 /***********************************************************************************************************************
  * Pragma directive
  ***********************************************************************************************************************/
-
+#define APP_LOG_MODULE LOG_MODULE_BUTTON
 /***********************************************************************************************************************
  * Includes <System Includes>
  ***********************************************************************************************************************/
@@ -16,8 +16,13 @@
 #include "../../Common.h"
 #include "driver/gpio.h"
 #include "../user_driver/user_buttons.h"
-#include "../user_driver/user_vibration_motor.h"
+#include "../user_driver/haptic.h"
 #include "../user_driver/user_leds.h"
+#include "../user_driver/button_gestures.h"
+#include "../system/task_registry.h"
+#include "../system/trace.h"
+#include "../system/standby.h"
+#include "../system/prov_store.h"
 /***********************************************************************************************************************
  * Macro definitions
  ***********************************************************************************************************************/
@@ -27,6 +32,21 @@
 			{0, 1, 1, GPIO_USER_BOOT_BUTTON}, /* Boot button */   \
 		{0, 1, 1, GPIO_USER_BUTTON},		  /* User button */   \
 	}
+#define BTN_BOOT (0)
+#define BTN_USER (1)
+#define PLANT_POLL_MS (10)  /* debounce, hold and gesture timing while a button is in use */
+#define PLANT_IDLE_MS (100) /* nothing pending, edges notify the task and an edge lost in light sleep is caught here */
+#define BOARD_BTN_COMBOS                                                                    \
+	{                                                                                       \
+		/* Type   Steps   Step list   Mask   Window   Hold */                               \
+		{E_BUTTON_COMBO_CHORD, 0, {0}, (1 << BTN_BOOT) | (1 << BTN_USER), 300, BUTTON_HOLD_TIME_2}, \
+		{E_BUTTON_COMBO_SEQUENCE, 3, {BTN_BOOT, BTN_USER, BTN_BOOT}, 0, 800, 0},              \
+	}
+enum
+{
+	COMBO_FACTORY_RESET, /* boot + user held together for 3 s */
+	COMBO_SERVICE,       /* boot, user, boot */
+};
 /***********************************************************************************************************************
  * Typedef definitions
  ***********************************************************************************************************************/
@@ -40,10 +60,10 @@ static void user_buttons_setup(void);
 static void vsm_btn_event_press(int btn_idx, int event, void *p);
 static void vsm_btn_event_release(int btn_idx, int event, void *p);
 static void vsm_btn_event_hold(int btn_idx, int event, void *p);
-static void vsm_btn_reverse_click(void);
-static void vsm_button_server_access(void);
-static void vibration_run_process(void);
+static void vsm_btn_event_combo(int combo_idx, int event, void *p);
+static void vsm_button_gesture_dispatch(button_gesture_t gesture);
 static tsButtonConfig btnParams[] = BOARD_BTN_CONFIG;
+static const tsButtonCombo btnCombos[] = BOARD_BTN_COMBOS;
 /***********************************************************************************************************************
  * Exported global variables and functions (to be accessed by other files)
  ***********************************************************************************************************************/
@@ -60,7 +80,7 @@ extern void flash_erase_all_partions(void);
  ***********************************************************************************************************************/
 void plan_task(void)
 {
-	xTaskCreatePinnedToCore(PlantControl_Task, "plant_task", 6 * 1024, NULL, 2 | portPRIVILEGE_BIT, NULL, 1);
+	task_registry_start(TASK_ID_PLANT, PlantControl_Task, NULL, NULL);
 }
 
 bool mqtt_start_first_time = false;
@@ -69,62 +89,28 @@ bool mqtt_start_first_time = false;
  ***********************************************************************************************************************/
 static void PlantControl_Task(void *pvParameters)
 {
-	uint8_t _old_vibration_level = deive_data.sensor.vibration_level;
 	// buttons_set_callback(user_buttons_callback);
+	uint32_t wait_ms;
+
+	button_gestures_init();
 	user_buttons_setup();
-	led_green(true);
+	buttons_set_edge_notify(xTaskGetCurrentTaskHandle());
+	leds_show_status();
 
 	while (1)
 	{
+		task_registry_wake(TASK_ID_PLANT);
 		buttons_process(NULL);
-		vsm_btn_reverse_click();
+		vsm_button_gesture_dispatch(button_gestures_poll(usertimer_gettick()));
 		if ((mqtt_start_first_time == false) && (deive_data.wifi_status == true))
 		{
 			mqtt_start_first_time = true;
 		}
-		vsm_button_server_access();
-		// process vibration message json mqtt
-		if (deive_data.sensor.vibration_level != _old_vibration_level)
-		{
-			_old_vibration_level = deive_data.sensor.vibration_level;
-			// vibration_set_duty(deive_data.sensor.vibration_level);
-		}
-
-		// vibration run
-		vibration_run_process();
 		// check button here
-		vTaskDelay(10 / portTICK_PERIOD_MS);
-	}
-}
-/***********************************************************************************************************************
- * Function Name: vsm_btn_event_release
- * Description  :
- * Arguments    : none
- * Return Value : none
- ***********************************************************************************************************************/
-uint32_t time_vibration_run = 0;
-bool vibration_state = 0;
-static void vibration_run_process(void)
-{
-	switch (vibration_state)
-	{
-	case 0:
-		if (deive_data.sensor.vibration_active == true)
-		{
-			deive_data.sensor.vibration_active = false;
-			vibration_state = 1;
-			time_vibration_run = usertimer_gettick();
-			vibration_set_duty(deive_data.sensor.vibration_level);
-		}
-		break;
-	case 1:
-		if (usertimer_gettick() - time_vibration_run > 300)
-		{
-			vibration_set_duty(0);
-			vibration_state = 0;
-		}
-	default:
-		break;
+		wait_ms = (bHardButtonIsIdle() && button_gestures_idle()) ? PLANT_IDLE_MS : PLANT_POLL_MS;
+		if ((wait_ms == PLANT_IDLE_MS) && standby_due())
+			standby_enter();
+		ulTaskNotifyTake(pdTRUE, wait_ms / portTICK_PERIOD_MS);
 	}
 }
 /***********************************************************************************************************************
@@ -140,132 +126,52 @@ static void user_buttons_setup(void)
 	vHardButtonSetCallback(E_EVENT_HARD_BUTTON_PRESS, vsm_btn_event_press, NULL);
 	vHardButtonSetCallback(E_EVENT_HARD_BUTTON_RELEASE, vsm_btn_event_release, NULL);
 	vHardButtonSetCallback(E_EVENT_HARD_BUTTON_HOLD, vsm_btn_event_hold, NULL);
+	vHardButtonSetCombos(btnCombos, sizeof(btnCombos) / sizeof(btnCombos[0]));
+	vHardButtonSetCallback(E_EVENT_HARD_BUTTON_CHORD, vsm_btn_event_combo, NULL);
+	vHardButtonSetCallback(E_EVENT_HARD_BUTTON_SEQUENCE, vsm_btn_event_combo, NULL);
 	// vHardButtonSetCallback(E_EVENT_HARD_BUTTON_DOUBLE_CLICK, vsm_btn_multi_click, NULL);
 	// vHardButtonSetCallback(E_EVENT_HARD_BUTTON_ON_HOLD, vsm_btn_event_onhold, NULL);
 }
 
-uint32_t _time_check_reverse_click = 0;
-uint8_t _check_state_reverse_click = 0;
-uint8_t _buttons_press_release_old_state;
-typedef struct
-{
-	bool _press_release;
-	bool _hold;
-	bool _hold_3s;
-	bool _hold_1s;
-	bool _click;
-	bool _reverse;
-} user_button_check_t;
 /***********************************************************************************************************************
- * Function Name: vsm_btn_event_release
- * Description  :
- * Arguments    : none
+ * Function Name: vsm_button_gesture_dispatch
+ * Description  : act on a gesture completed by the user button grammar. buttons_hold follows the hold from
+ *                buttonDown until the grammar is back in its idle state.
+ * Arguments    : gesture
  * Return Value : none
  ***********************************************************************************************************************/
-user_button_check_t user_button_check;
-bool checking_reverse_state = false;
-static void vsm_btn_reverse_click(void)
+static void vsm_button_gesture_dispatch(button_gesture_t gesture)
 {
-	if ((user_button_check._hold == true) && (_check_state_reverse_click == 0))
-	{
-		_time_check_reverse_click = usertimer_gettick();
-		_check_state_reverse_click = 1;
-	}
-
-	if ((_buttons_press_release_old_state != user_button_check._press_release) &&
-		(user_button_check._press_release == false) &&
-		(_check_state_reverse_click == 0))
-	{
-		user_button_check._click = true;
-	}
-	else if ((user_button_check._press_release == false) && (_check_state_reverse_click == 1))
-	{
-		user_button_check._hold_1s = true;
-		APP_LOGD("check 1 = %d", usertimer_gettick());
-		checking_reverse_state = false;
-		_check_state_reverse_click = 0;
-	}
-	else if ((usertimer_gettick() - _time_check_reverse_click > 500) && (_check_state_reverse_click == 1))
-	{
-		user_button_check._hold_3s = true;
-		_check_state_reverse_click = 2;
-	}
-
-	if ((user_button_check._hold_3s == true) && (user_button_check._press_release == false)) /// hold buttons in 3s
-	{
-		user_button_check._hold_3s = false;
-		_check_state_reverse_click = 3;
-		_time_check_reverse_click = usertimer_gettick();
-	}
+	uint16_t trace_id;
 
-	if (_check_state_reverse_click == 3)
+	if (button_gestures_idle() == true)
+		deive_data.sensor.buttons_hold = false;
+	if (gesture == BUTTON_GESTURE_NONE)
+		return;
+	trace_id = trace_begin(TRACE_BUTTON_GESTURE);
+	switch (gesture)
 	{
-		// if (usertimer_gettick() - _time_check_reverse_click > 500)
-		// {
-		// 	_check_state_reverse_click = 0;
-		// 	if ((user_button_check._press_release == false))
-		// 	{
-		// 		user_button_check._hold_1s = true;
-		// 		APP_LOGD("check 2 = %d", usertimer_gettick());
-		// 		checking_reverse_state = false;
-		// 	}
-		// }
-		// else
-		if( user_button_check._press_release == true ) 
-		{
-			_time_check_reverse_click = usertimer_gettick();
-		}
-		else if( (usertimer_gettick() - _time_check_reverse_click > 500) && (user_button_check._press_release == false))
-		{
-			user_button_check._hold_1s = true;
-			_check_state_reverse_click = 0;
-			checking_reverse_state = false;
-			APP_LOGD("check 2 = %d", usertimer_gettick());
-		}
-		
-		if ((user_button_check._press_release != _buttons_press_release_old_state) && (user_button_check._press_release == true))
-		{
-			_time_check_reverse_click = usertimer_gettick();
-			user_button_check._reverse = true;
-			checking_reverse_state = true;
-			// user_button_check._hold_1s = false;
-		}
-	}
-	_buttons_press_release_old_state = user_button_check._press_release;
-}
-/***********************************************************************************************************************
- * Function Name: vsm_btn_event_release
- * Description  :
- * Arguments    : none
- * Return Value : none
- ***********************************************************************************************************************/
-static void vsm_button_server_access(void)
-{
-	if (user_button_check._reverse == true)
-	{
-		user_button_check._reverse = false;
+	case BUTTON_GESTURE_REVERSE:
 		APP_LOGI("send reverse to sever = %d", usertimer_gettick());
-		mqtt_send_message("send reverse to sever");
-	}
-	else if (user_button_check._hold_1s == true)
-	{
-		user_button_check._hold_1s = false;
-		user_button_check._hold = false;
+		haptic_play_event(HAPTIC_EVENT_BUTTON);
+		mqtt_send_message("send reverse to sever", trace_id);
+		break;
+	case BUTTON_GESTURE_UP:
+		deive_data.sensor.buttons_hold = false;
 		APP_LOGI("buttonUp true = %d", usertimer_gettick());
-		mqtt_send_message("buttonUp true");
-		// deive_data.sensor.vibration_active = true;
-	}
-	else if (user_button_check._click)
-	{
-		user_button_check._click = false;
+		mqtt_send_message("buttonUp true", trace_id);
+		break;
+	case BUTTON_GESTURE_CLICK:
 		APP_LOGI("click false = %d", usertimer_gettick());
-		mqtt_send_message("click false");
-	}
-	else if((user_button_check._hold) && (checking_reverse_state == false))
-	{
-		user_button_check._hold = false;
+		mqtt_send_message("click false", trace_id);
+		break;
+	case BUTTON_GESTURE_DOWN:
+		deive_data.sensor.buttons_hold = true;
 		APP_LOGI("buttonDown false = %d", usertimer_gettick());
-		mqtt_send_message("buttonDown false");
+		mqtt_send_message("buttonDown false", trace_id);
+		break;
+	default:
+		break;
 	}
 }
 
@@ -277,12 +183,17 @@ static void vsm_button_server_access(void)
  ***********************************************************************************************************************/
 static void vsm_btn_event_press(int btn_idx, int event, void *p)
 {
+	standby_activity();
+	// chord and sequence members are not user button gestures, a press already fed is taken back
+	if (bHardButtonIsComboMember(BTN_USER) == true)
+		button_gestures_cancel();
 	switch (btn_idx)
 	{
-	case 0:
+	case BTN_BOOT:
 		break;
-	case 1:
-		user_button_check._press_release = true;
+	case BTN_USER:
+		if (bHardButtonIsComboMember(BTN_USER) == false)
+			vsm_button_gesture_dispatch(button_gestures_feed_edge(true, usertimer_gettick()));
 		break;
 	default:
 		break;
@@ -293,10 +204,11 @@ static void vsm_btn_event_release(int btn_idx, int event, void *p)
 {
 	switch (btn_idx)
 	{
-	case 0:
+	case BTN_BOOT:
 		break;
-	case 1:
-		user_button_check._press_release = false;
+	case BTN_USER:
+		if (bHardButtonIsComboMember(BTN_USER) == false)
+			vsm_button_gesture_dispatch(button_gestures_feed_edge(false, usertimer_gettick()));
 		break;
 	default:
 		break;
@@ -307,16 +219,34 @@ static void vsm_btn_event_hold(int btn_idx, int event, void *p)
 {
 	switch (btn_idx)
 	{
-	case 0:
+	case BTN_BOOT:
+		/* a lone boot hold no longer wipes the flash, see the boot + user chord */
+		break;
+	case BTN_USER:
+		/* timed by the gesture grammar */
+		break;
+	default:
+		break;
+	}
+}
+
+static void vsm_btn_event_combo(int combo_idx, int event, void *p)
+{
+	switch (combo_idx)
+	{
+	case COMBO_FACTORY_RESET:
 		APP_LOGI("factory reset after 2s");
+		leds_set_pattern(LED_RED, LED_PATTERN_ON);
 		flash_erase_all_partions();
-		vTaskDelay(2000);
+		vTaskDelay(2000 / portTICK_PERIOD_MS);
 		esp_restart();
 		break;
-	case 1:
-		user_button_check._hold = true;
-		_time_check_reverse_click = usertimer_gettick();
-		deive_data.sensor.buttons_hold = true;
+	case COMBO_SERVICE:
+		APP_LOGI("service mode, publishing diagnostics, POST /prov open");
+		leds_flash(LED_BLUE);
+		prov_store_unlock(PROV_UNLOCK_S);
+		deive_data.diag_request = true;
+		task_registry_notify(TASK_ID_MQTT_SEND);
 		break;
 	default:
 		break;
@@ -48,6 +48,7 @@
 #define I2C_SCL_PIN 22
 #define I2C_SDA_PIN 21
 #define I2C_FREQ_100K 100000
+#define I2C_FREQ_400K 400000
 
 /* Private functions ---------------------------------------------------------*/
 static LSM6DSLStatusTypeDef Set_X_ODR_When_Enabled(float odr);
@@ -69,7 +70,7 @@ LSM6DSLStatusTypeDef LSM6DSLSensor_begin()
     X_isEnabled = 0;
     G_isEnabled = 0;
 
-    int ret = i2c_master_init(I2C_MASTER_NUM, I2C_SDA_PIN, I2C_SCL_PIN, I2C_FREQ_100K);
+    int ret = i2c_master_init(I2C_MASTER_NUM, I2C_SDA_PIN, I2C_SCL_PIN, I2C_FREQ_400K);
     if (ret == ESP_OK)
         APP_LOGI("LSM6DSL_ACC_GYRO_Init = %d", ret);
     else
@@ -1478,6 +1479,74 @@ LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Single_Tap_Detection(LSM6DSL_Interrupt
     return LSM6DSL_STATUS_OK;
 }
 
+/**
+ * @brief Route single tap events to an interrupt pin as an impact trigger, unlike
+ *        LSM6DSLSensor_Enable_Single_Tap_Detection the running ODR and full scale are kept
+ * @param int_pin the interrupt pin to be used
+ * @param thr tap threshold, 1 LSB = full scale / 32
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Impact_Detection(LSM6DSL_Interrupt_Pin_t int_pin, uint8_t thr)
+{
+    if (LSM6DSL_ACC_GYRO_W_TAP_X_EN(NULL, LSM6DSL_ACC_GYRO_TAP_X_EN_ENABLED) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_TAP_Y_EN(NULL, LSM6DSL_ACC_GYRO_TAP_Y_EN_ENABLED) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_TAP_Z_EN(NULL, LSM6DSL_ACC_GYRO_TAP_Z_EN_ENABLED) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSLSensor_Set_Tap_Threshold(thr) == LSM6DSL_STATUS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    /* Shortest shock and quiet windows, the first edge is what matters. */
+    if (LSM6DSLSensor_Set_Tap_Shock_Time(LSM6DSL_TAP_SHOCK_TIME_LOW) == LSM6DSL_STATUS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSLSensor_Set_Tap_Quiet_Time(LSM6DSL_TAP_QUIET_TIME_LOW) == LSM6DSL_STATUS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_BASIC_INT(NULL, LSM6DSL_ACC_GYRO_BASIC_INT_ENABLED) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    switch (int_pin)
+    {
+    case LSM6DSL_INT1_PIN:
+        if (LSM6DSL_ACC_GYRO_W_SingleTapOnInt1(NULL, LSM6DSL_ACC_GYRO_INT1_SINGLE_TAP_ENABLED) == MEMS_ERROR)
+        {
+            return LSM6DSL_STATUS_ERROR;
+        }
+        break;
+
+    case LSM6DSL_INT2_PIN:
+        if (LSM6DSL_ACC_GYRO_W_SingleTapOnInt2(NULL, LSM6DSL_ACC_GYRO_INT2_SINGLE_TAP_ENABLED) == MEMS_ERROR)
+        {
+            return LSM6DSL_STATUS_ERROR;
+        }
+        break;
+
+    default:
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    return LSM6DSL_STATUS_OK;
+}
+
 /**
  * @brief Disable the single tap detection for LSM6DSL accelerometer sensor
  * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
@@ -2202,21 +2271,198 @@ LSM6DSLStatusTypeDef LSM6DSLSensor_WriteReg( uint8_t reg, uint8_t data )
 }
 
 
-LSM6DSLStatusTypeDef LSM6DSLSensor_GetTemp(uint16_t *temp)
+/**
+ * @brief Read the raw temperature output
+ * @param temp the pointer where the signed raw temperature is stored [LSB]
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_GetTemp(int16_t *temp)
+{
+    uint8_t regValue[2] = {0, 0};
+
+    /* Read OUT_TEMP_L and OUT_TEMP_H in one burst so BDU keeps both bytes coherent. */
+    if (LSM6DSL_ACC_GYRO_ReadReg(NULL, LSM6DSL_ACC_GYRO_OUT_TEMP_L, regValue, 2) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    *temp = (int16_t)((((uint16_t)regValue[1]) << 8) | regValue[0]);
+    return LSM6DSL_STATUS_OK;
+}
+
+/**
+ * @brief Read the temperature
+ * @param centi_deg the pointer where the temperature is stored [0.01 degC]
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Get_Temperature(int16_t *centi_deg)
+{
+    int16_t raw = 0;
+
+    if (LSM6DSLSensor_GetTemp(&raw) == LSM6DSL_STATUS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    *centi_deg = LSM6DSL_TEMP_RAW_TO_CENTI_C(raw);
+    return LSM6DSL_STATUS_OK;
+}
+
+/**
+ * @brief Configure the FIFO in continuous mode
+ * @param odr the FIFO output data rate, must not exceed the sensors ODR
+ * @param gyro_en batch the gyroscope in the 1st data set when not zero
+ * @param temp_en batch the temperature in the 4th data set when not zero
+ * @note  The accelerometer is always batched without decimation. The temperature
+ *        is decimated by LSM6DSL_FIFO_TEMP_DECIMATION, so a pattern is
+ *        LSM6DSL_FIFO_TEMP_DECIMATION ticks of [G] XL plus one temperature triplet.
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_FIFO_Stream(float odr, uint8_t gyro_en, uint8_t temp_en)
+{
+    LSM6DSL_ACC_GYRO_ODR_FIFO_t new_odr;
+
+    new_odr = (odr <= 10.0f)     ? LSM6DSL_ACC_GYRO_ODR_FIFO_10Hz
+              : (odr <= 26.0f)   ? LSM6DSL_ACC_GYRO_ODR_FIFO_25Hz
+              : (odr <= 52.0f)   ? LSM6DSL_ACC_GYRO_ODR_FIFO_50Hz
+              : (odr <= 104.0f)  ? LSM6DSL_ACC_GYRO_ODR_FIFO_100Hz
+              : (odr <= 208.0f)  ? LSM6DSL_ACC_GYRO_ODR_FIFO_200Hz
+              : (odr <= 416.0f)  ? LSM6DSL_ACC_GYRO_ODR_FIFO_400Hz
+              : (odr <= 833.0f)  ? LSM6DSL_ACC_GYRO_ODR_FIFO_800Hz
+              : (odr <= 1660.0f) ? LSM6DSL_ACC_GYRO_ODR_FIFO_1600Hz
+              : (odr <= 3330.0f) ? LSM6DSL_ACC_GYRO_ODR_FIFO_3300Hz
+                                 : LSM6DSL_ACC_GYRO_ODR_FIFO_6600Hz;
+
+    /* Flush whatever is left in the FIFO by going through bypass. */
+    if (LSM6DSL_ACC_GYRO_W_FIFO_MODE(NULL, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_DEC_FIFO_XL(NULL, LSM6DSL_ACC_GYRO_DEC_FIFO_XL_NO_DECIMATION) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_DEC_FIFO_G(NULL, gyro_en ? LSM6DSL_ACC_GYRO_DEC_FIFO_G_NO_DECIMATION
+                                                    : LSM6DSL_ACC_GYRO_DEC_FIFO_G_DATA_NOT_IN_FIFO) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_FIFO_TEMP(NULL, temp_en ? LSM6DSL_ACC_GYRO_FIFO_TEMP_ENABLE
+                                                   : LSM6DSL_ACC_GYRO_FIFO_TEMP_DISABLE) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_DEC_FIFO_DS4(NULL, temp_en ? LSM6DSL_ACC_GYRO_DEC_FIFO_DS4_DECIMATION_BY_32
+                                                      : LSM6DSL_ACC_GYRO_DEC_FIFO_DS4_DATA_NOT_IN_FIFO) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_ODR_FIFO(NULL, new_odr) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    if (LSM6DSL_ACC_GYRO_W_FIFO_MODE(NULL, LSM6DSL_ACC_GYRO_FIFO_MODE_STREAM) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    return LSM6DSL_STATUS_OK;
+}
+
+/**
+ * @brief Put the FIFO back in bypass mode
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Disable_FIFO(void)
+{
+    if (LSM6DSL_ACC_GYRO_W_FIFO_MODE(NULL, LSM6DSL_ACC_GYRO_FIFO_MODE_BYPASS) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    return LSM6DSL_STATUS_OK;
+}
+
+/**
+ * @brief Read the number of unread words in the FIFO
+ * @param num the pointer where the number of words is stored
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Num_Of_Entries(uint16_t *num)
+{
+    if (LSM6DSL_ACC_GYRO_R_FIFONumOfEntries(NULL, num) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    return LSM6DSL_STATUS_OK;
+}
+
+/**
+ * @brief Read the pattern position of the next FIFO word
+ * @param pattern the pointer where the pattern position is stored
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Pattern(uint16_t *pattern)
 {
-    uint8_t temp_low;
-    uint8_t temp_high;
+    if (LSM6DSL_ACC_GYRO_R_FIFOPattern(NULL, pattern) == MEMS_ERROR)
+    {
+        return LSM6DSL_STATUS_ERROR;
+    }
+
+    return LSM6DSL_STATUS_OK;
+}
 
-    if (LSM6DSLSensor_ReadReg(LSM6DSL_ACC_GYRO_OUT_TEMP_L, &temp_low) == LSM6DSL_STATUS_ERROR)
+/**
+ * @brief Read the FIFO overrun flag
+ * @param overrun the pointer where the flag is stored, 1 if samples were lost
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Overrun(uint8_t *overrun)
+{
+    LSM6DSL_ACC_GYRO_OVERRUN_t value;
+
+    if (LSM6DSL_ACC_GYRO_R_OVERRUN(NULL, &value) == MEMS_ERROR)
     {
         return LSM6DSL_STATUS_ERROR;
     }
 
-    if (LSM6DSLSensor_ReadReg(LSM6DSL_ACC_GYRO_OUT_TEMP_L, &temp_high) == LSM6DSL_STATUS_ERROR)
+    *overrun = (value == LSM6DSL_ACC_GYRO_OVERRUN_OVERRUN) ? 1 : 0;
+    return LSM6DSL_STATUS_OK;
+}
+
+/**
+ * @brief Read a batch of words from the FIFO in a single burst
+ * @param pData the pointer where the signed words are stored
+ * @param count the number of words to read
+ * @retval LSM6DSL_STATUS_OK in case of success, an error code otherwise
+ */
+LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Words(int16_t *pData, uint16_t count)
+{
+    uint8_t *raw = (uint8_t *)pData;
+    uint16_t i;
+
+    if (count == 0)
+    {
+        return LSM6DSL_STATUS_OK;
+    }
+
+    if (LSM6DSL_ACC_GYRO_ReadReg(NULL, LSM6DSL_ACC_GYRO_FIFO_DATA_OUT_L, raw, count * 2) == MEMS_ERROR)
     {
         return LSM6DSL_STATUS_ERROR;
     }
 
-    *temp = (temp_high << 8) | temp_low;
+    /* The FIFO is little endian, rebuild in place so the code does not depend on host order. */
+    for (i = 0; i < count; i++)
+    {
+        pData[i] = (int16_t)((((uint16_t)raw[2 * i + 1]) << 8) | raw[2 * i]);
+    }
+
     return LSM6DSL_STATUS_OK;
-}
\ No newline at end of file
+}
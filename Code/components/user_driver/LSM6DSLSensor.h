@@ -61,6 +61,14 @@ extern "C"
 #define LSM6DSL_GYRO_SENSITIVITY_FOR_FS_1000DPS 35.000 /**< Sensitivity value for 1000 dps full scale [mdps/LSB] */
 #define LSM6DSL_GYRO_SENSITIVITY_FOR_FS_2000DPS 70.000 /**< Sensitivity value for 2000 dps full scale [mdps/LSB] */
 
+#define LSM6DSL_TEMP_SENSITIVITY 256 /**< Temperature sensitivity [LSB/degC] */
+#define LSM6DSL_TEMP_OFFSET_C 25     /**< Temperature at 0 LSB [degC] */
+#define LSM6DSL_TEMP_RAW_TO_CENTI_C(raw) ((int16_t)(LSM6DSL_TEMP_OFFSET_C * 100 + ((int32_t)(raw)*100) / LSM6DSL_TEMP_SENSITIVITY))
+
+#define LSM6DSL_FIFO_MAX_WORDS 2048        /**< FIFO depth in 16-bit words (4 kbyte) */
+#define LSM6DSL_FIFO_TEMP_DECIMATION 32    /**< Temperature is batched once every 32 FIFO ticks */
+#define LSM6DSL_FIFO_TEMP_WORD 1           /**< Word of the 4th data set that holds the temperature */
+
 #define LSM6DSL_PEDOMETER_THRESHOLD_LOW 0x00 /**< Lowest  value of pedometer threshold */
 #define LSM6DSL_PEDOMETER_THRESHOLD_MID_LOW 0x07
 #define LSM6DSL_PEDOMETER_THRESHOLD_MID 0x0F
@@ -167,6 +175,7 @@ extern "C"
     LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Single_Tap_Detection_Int1_PIN(void);
     LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Single_Tap_Detection(LSM6DSL_Interrupt_Pin_t int_pin);
     LSM6DSLStatusTypeDef LSM6DSLSensor_Disable_Single_Tap_Detection(void);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Impact_Detection(LSM6DSL_Interrupt_Pin_t int_pin, uint8_t thr);
     LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Double_Tap_Detection_Int1_Pin(void);
     LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_Double_Tap_Detection(LSM6DSL_Interrupt_Pin_t int_pin);
     LSM6DSLStatusTypeDef LSM6DSLSensor_Disable_Double_Tap_Detection(void);
@@ -186,7 +195,14 @@ extern "C"
     LSM6DSLStatusTypeDef LSM6DSLSensor_Get_Event_Status(LSM6DSL_Event_Status_t *status);
     LSM6DSLStatusTypeDef LSM6DSLSensor_ReadReg(uint8_t reg, uint8_t *data);
     LSM6DSLStatusTypeDef LSM6DSLSensor_WriteReg(uint8_t reg, uint8_t data);
-    LSM6DSLStatusTypeDef LSM6DSLSensor_GetTemp(uint16_t *temp);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_GetTemp(int16_t *temp);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Get_Temperature(int16_t *centi_deg);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Enable_FIFO_Stream(float odr, uint8_t gyro_en, uint8_t temp_en);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Disable_FIFO(void);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Num_Of_Entries(uint16_t *num);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Pattern(uint16_t *pattern);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Overrun(uint8_t *overrun);
+    LSM6DSLStatusTypeDef LSM6DSLSensor_Get_FIFO_Words(int16_t *pData, uint16_t count);
 
 #ifdef __cplusplus
 }
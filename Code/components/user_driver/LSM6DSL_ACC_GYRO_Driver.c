@@ -39,6 +39,7 @@
 #include "LSM6DSL_ACC_GYRO_Driver.h"
 #include "../peripheral/user_i2c.h"
 #include "../../Common.h"
+#include "../system/metrics.h"
 /* Imported function prototypes ----------------------------------------------*/
 uint8_t LSM6DSL_IO_Write(void *handle, uint8_t WriteAddr, uint8_t *pBuffer, uint16_t nBytesToWrite);
 uint8_t LSM6DSL_IO_Read(void *handle, uint8_t ReadAddr, uint8_t *pBuffer, uint16_t nBytesToRead);
@@ -54,18 +55,20 @@ uint8_t LSM6DSL_IO_Read(void *handle, uint8_t ReadAddr, uint8_t *pBuffer, uint16
 /* Private functions ---------------------------------------------------------*/
 uint8_t LSM6DSL_IO_Read(void *handle, uint8_t ReadAddr, uint8_t *pBuffer, uint16_t nBytesToRead)
 {
-	uint8_t _data = 0x00;
 	// APP_LOGD("user_i2c_slave_read call");
-	// esp_err_t ret = i2c_read_bytes(I2C_MASTER_NUM, LSM6DSL_ACC_GYRO_I2C_ADDRESS_HIGH, LSM6DSL_ACC_GYRO_WHO_AM_I_REG, &_data, nBytesToRead);
-	int ret = i2c_read_byte(0, LSM6DSL_ACC_GYRO_I2C_ADDRESS_HIGH, ReadAddr, &_data);
-	// APP_LOGD("user_i2c_slave_read call end = %x", _data);
-	*pBuffer = _data;
+	/* multi-byte reads rely on IF_INC (set in LSM6DSLSensor_begin); FIFO_DATA_OUT wraps back to 0x3E by itself */
+	int ret = i2c_read_bytes(0, LSM6DSL_ACC_GYRO_I2C_ADDRESS_HIGH, ReadAddr, pBuffer, nBytesToRead);
+	if (ret != ESP_OK)
+		metrics_add(METRIC_I2C_ERRORS, 1);
+	// APP_LOGD("user_i2c_slave_read call end = %x", *pBuffer);
 	return ret;
 }
 
 uint8_t LSM6DSL_IO_Write(void *handle, uint8_t WriteAddr, uint8_t *pBuffer, uint16_t nBytesToWrite)
 {
 	int ret = i2c_write_bytes(0, LSM6DSL_ACC_GYRO_I2C_ADDRESS_HIGH, WriteAddr, pBuffer, nBytesToWrite);
+	if (ret != ESP_OK)
+		metrics_add(METRIC_I2C_ERRORS, 1);
 	return ret;
 }
 
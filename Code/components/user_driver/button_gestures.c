@@ -0,0 +1,108 @@
+/*
+ * button_gestures.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_BUTTON
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <string.h>
+#include "button_gestures.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static gesture_engine_t engine;
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: button_gestures_init
+* Description  : load the user button grammar, button_grammar.h
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void button_gestures_init(void)
+{
+	gesture_init(&engine, &button_grammar);
+}
+
+/***********************************************************************************************************************
+* Function Name: button_gestures_feed_edge
+* Description  : feed a debounced user button edge
+* Arguments    : pressed - new level, now_ms - edge tick
+* Return Value : completed gesture or BUTTON_GESTURE_NONE
+***********************************************************************************************************************/
+button_gesture_t button_gestures_feed_edge(bool pressed, uint32_t now_ms)
+{
+	return (button_gesture_t)gesture_feed(&engine, pressed ? GESTURE_INPUT_PRESS : GESTURE_INPUT_RELEASE, now_ms);
+}
+
+/***********************************************************************************************************************
+* Function Name: button_gestures_poll
+* Description  : expire the hold/long/reverse windows, call from the button loop
+* Arguments    : now_ms
+* Return Value : completed gesture or BUTTON_GESTURE_NONE
+***********************************************************************************************************************/
+button_gesture_t button_gestures_poll(uint32_t now_ms)
+{
+	return (button_gesture_t)gesture_poll(&engine, now_ms);
+}
+
+/* no window is running, polling can wait for the next edge */
+bool button_gestures_idle(void)
+{
+	return (engine.state == BUTTON_ST_IDLE);
+}
+
+/* drop a press that turned out to start a chord, only before it became a buttonDown */
+void button_gestures_cancel(void)
+{
+	if (engine.state == BUTTON_ST_PRESSED)
+		engine.state = BUTTON_ST_IDLE;
+}
+
+/***********************************************************************************************************************
+* Function Name: button_gestures_set_window
+* Description  : retune a window by name ("hold", "long", "reverse")
+* Arguments    : name, ms
+* Return Value : false for an unknown name
+***********************************************************************************************************************/
+bool button_gestures_set_window(const char *name, uint16_t ms)
+{
+	if (name == NULL)
+		return false;
+	for (uint8_t i = 0; i < BUTTON_WINDOW_COUNT; i++)
+	{
+		if (strcmp(name, button_window_names[i]) == 0)
+		{
+			APP_LOGI("gesture window %s = %d ms", name, ms);
+			return gesture_set_window(&engine, i, ms);
+		}
+	}
+	return false;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,38 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+#include "button_grammar.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void button_gestures_init(void);
+
+button_gesture_t button_gestures_feed_edge(bool pressed, uint32_t now_ms);
+
+button_gesture_t button_gestures_poll(uint32_t now_ms);
+
+bool button_gestures_idle(void);
+
+void button_gestures_cancel(void);
+
+bool button_gestures_set_window(const char *name, uint16_t ms);
+
+#ifdef __cplusplus
+}
+#endif
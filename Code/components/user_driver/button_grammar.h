@@ -0,0 +1,104 @@
+/*
+ * button_grammar.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+
+#ifndef COMPONENTS_USER_DRIVER_BUTTON_GRAMMAR_H_
+#define COMPONENTS_USER_DRIVER_BUTTON_GRAMMAR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+/* the user button grammar, no esp/freertos dependency so tools/gesture_replay.c runs it on the host */
+#include "../gesture/gesture.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define BUTTON_GESTURE_HOLD_MS (500)    /* press -> buttonDown */
+#define BUTTON_GESTURE_LONG_MS (500)    /* further hold that opens the reverse gap */
+#define BUTTON_GESTURE_REVERSE_MS (500) /* gap in which a re-press counts as reverse */
+
+/* one input that always goes the same way */
+#define BUTTON_GO(next, emit) {GESTURE_WINDOW_NONE, GESTURE_STAY, GESTURE_NONE, (next), (emit)}
+#define BUTTON_IGNORE BUTTON_GO(GESTURE_STAY, GESTURE_NONE)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+	BUTTON_GESTURE_NONE = GESTURE_NONE,
+	BUTTON_GESTURE_CLICK,
+	BUTTON_GESTURE_DOWN,
+	BUTTON_GESTURE_UP,
+	BUTTON_GESTURE_REVERSE,
+	BUTTON_GESTURE_COUNT
+} button_gesture_t;
+
+enum
+{
+	BUTTON_WINDOW_HOLD,
+	BUTTON_WINDOW_LONG,
+	BUTTON_WINDOW_REVERSE,
+	BUTTON_WINDOW_COUNT
+};
+
+enum
+{
+	BUTTON_ST_IDLE,
+	BUTTON_ST_PRESSED, /* down, not yet a hold */
+	BUTTON_ST_HELD,    /* buttonDown sent, release now is a plain buttonUp */
+	BUTTON_ST_LONG,    /* held past the long window, release opens the reverse gap */
+	BUTTON_ST_GAP,     /* released after a long hold, waiting for a re-press */
+	BUTTON_ST_REVERSE, /* re-pressed inside the gap */
+	BUTTON_ST_COUNT
+};
+
+/****************************************************************************/
+/***        Grammar tables                                                ***/
+/****************************************************************************/
+static const char *const button_window_names[BUTTON_WINDOW_COUNT] = {"hold", "long", "reverse"};
+
+static const uint16_t button_default_window_ms[BUTTON_WINDOW_COUNT] = {
+	BUTTON_GESTURE_HOLD_MS,
+	BUTTON_GESTURE_LONG_MS,
+	BUTTON_GESTURE_REVERSE_MS,
+};
+
+static const uint8_t button_state_timeout[BUTTON_ST_COUNT] = {
+	[BUTTON_ST_IDLE] = GESTURE_WINDOW_NONE,
+	[BUTTON_ST_PRESSED] = BUTTON_WINDOW_HOLD,
+	[BUTTON_ST_HELD] = BUTTON_WINDOW_LONG,
+	[BUTTON_ST_LONG] = GESTURE_WINDOW_NONE,
+	[BUTTON_ST_GAP] = BUTTON_WINDOW_REVERSE,
+	[BUTTON_ST_REVERSE] = GESTURE_WINDOW_NONE,
+};
+
+static const gesture_cell_t button_cells[BUTTON_ST_COUNT][GESTURE_INPUT_COUNT] = {
+	/*                      PRESS                                              RELEASE                                           TIMEOUT */
+	[BUTTON_ST_IDLE] =    {BUTTON_GO(BUTTON_ST_PRESSED, GESTURE_NONE),          BUTTON_IGNORE,                                    BUTTON_IGNORE},
+	[BUTTON_ST_PRESSED] = {BUTTON_IGNORE,                                       BUTTON_GO(BUTTON_ST_IDLE, BUTTON_GESTURE_CLICK),  BUTTON_GO(BUTTON_ST_HELD, BUTTON_GESTURE_DOWN)},
+	[BUTTON_ST_HELD] =    {BUTTON_IGNORE,                                       BUTTON_GO(BUTTON_ST_IDLE, BUTTON_GESTURE_UP),     BUTTON_GO(BUTTON_ST_LONG, GESTURE_NONE)},
+	[BUTTON_ST_LONG] =    {BUTTON_IGNORE,                                       BUTTON_GO(BUTTON_ST_GAP, GESTURE_NONE),           BUTTON_IGNORE},
+	[BUTTON_ST_GAP] =     {BUTTON_GO(BUTTON_ST_REVERSE, BUTTON_GESTURE_REVERSE), BUTTON_IGNORE,                                    BUTTON_GO(BUTTON_ST_IDLE, BUTTON_GESTURE_UP)},
+	[BUTTON_ST_REVERSE] = {BUTTON_IGNORE,                                       BUTTON_GO(BUTTON_ST_GAP, GESTURE_NONE),           BUTTON_IGNORE},
+};
+
+static const gesture_grammar_t button_grammar = {
+	.cells = button_cells,
+	.timeout = button_state_timeout,
+	.state_count = BUTTON_ST_COUNT,
+	.default_window_ms = button_default_window_ms,
+	.window_count = BUTTON_WINDOW_COUNT,
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COMPONENTS_USER_DRIVER_BUTTON_GRAMMAR_H_ */
@@ -0,0 +1,368 @@
+/*
+ * haptic.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "haptic.h"
+#include "user_vibration_motor.h"
+#include "../peripheral/user_pwm.h"
+#include "../system/task_registry.h"
+#include "../system/power.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define HAPTIC_NOTIFY_PLAY (1 << 0)
+#define HAPTIC_NOTIFY_FADE_DONE (1 << 1)
+#define HAPTIC_NOTIFY_HOLD_DONE (1 << 2)
+#define HAPTIC_NOTIFY_PLAY_TIMED (1 << 3) // PLAY with an impact timestamp, the edge is measured
+
+#define HAPTIC_REPEAT_IDLE (0xFF)
+
+#define HAPTIC_HOLD(level, ms) {HAPTIC_SEG_HOLD, (level), (ms)}
+#define HAPTIC_RAMP(level, ms) {HAPTIC_SEG_RAMP, (level), (ms)}
+#define HAPTIC_KICK(ms) {HAPTIC_SEG_KICK, 100, (ms)}
+#define HAPTIC_BRAKE(ms) {HAPTIC_SEG_HOLD, 0, (ms)} // the driver is single ended, braking = no drive
+#define HAPTIC_REPEAT(times, to) {HAPTIC_SEG_REPEAT, (times), (to)}
+#define HAPTIC_END {HAPTIC_SEG_END, 0, 0}
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static const haptic_segment_t haptic_patterns[HAPTIC_PATTERN_COUNT][HAPTIC_MAX_SEGMENTS] = {
+    [HAPTIC_PATTERN_NONE] = {HAPTIC_END},
+    // same 300 ms as the old fixed pulse, with a kick so it is felt from the first ms
+    [HAPTIC_PATTERN_HIT] = {HAPTIC_KICK(15), HAPTIC_HOLD(100, 265), HAPTIC_RAMP(0, 20), HAPTIC_END},
+    [HAPTIC_PATTERN_CLICK] = {HAPTIC_KICK(12), HAPTIC_HOLD(60, 25), HAPTIC_BRAKE(15), HAPTIC_END},
+    [HAPTIC_PATTERN_DOUBLE] = {HAPTIC_KICK(12), HAPTIC_HOLD(80, 60), HAPTIC_BRAKE(60), HAPTIC_REPEAT(1, 0), HAPTIC_END},
+    [HAPTIC_PATTERN_SWELL] = {HAPTIC_RAMP(100, 250), HAPTIC_HOLD(100, 100), HAPTIC_RAMP(0, 250), HAPTIC_END},
+    [HAPTIC_PATTERN_ALERT] = {HAPTIC_HOLD(100, 80), HAPTIC_BRAKE(80), HAPTIC_REPEAT(2, 0), HAPTIC_END},
+};
+
+static const char *const haptic_pattern_names[HAPTIC_PATTERN_COUNT] = {
+    "none",
+    "hit",
+    "click",
+    "double",
+    "swell",
+    "alert",
+};
+
+static const char *const haptic_event_names[HAPTIC_EVENT_COUNT] = {
+    "hit",
+    "button",
+    "alert",
+};
+
+static uint8_t event_pattern[HAPTIC_EVENT_COUNT] = {
+    [HAPTIC_EVENT_HIT] = HAPTIC_PATTERN_HIT,
+    [HAPTIC_EVENT_BUTTON] = HAPTIC_PATTERN_CLICK,
+    [HAPTIC_EVENT_ALERT] = HAPTIC_PATTERN_ALERT,
+};
+
+static TaskHandle_t haptic_handle = NULL;
+static esp_timer_handle_t hold_timer = NULL;
+static volatile uint8_t pending_pattern = HAPTIC_PATTERN_NONE;
+static uint8_t active_pattern = HAPTIC_PATTERN_NONE;
+static uint8_t segment_index = 0;
+static uint8_t repeat_left = HAPTIC_REPEAT_IDLE;
+static uint32_t waiting_for = 0; // notification that ends the current segment
+static bool power_locked = false; // POWER_LOCK_HAPTIC from the first segment until the pattern ends
+static volatile int64_t pending_impact_us = 0;
+static const uint32_t latency_edges[HAPTIC_LATENCY_BINS - 1] = HAPTIC_LATENCY_BIN_EDGES_US;
+static haptic_latency_t latency;
+
+static void haptic_task(void *pvParameters);
+static void haptic_next_segment(void);
+static uint32_t haptic_duty(const haptic_segment_t *segment);
+static bool haptic_fade_done_isr(void);
+static void haptic_hold_done(void *arg);
+static void haptic_latency_add(int64_t impact_us, int64_t edge_us);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: haptic_init
+* Description  : motor PWM, hold timer and the sequencer task. Segments are timed by the LEDC fade unit and esp_timer,
+*                the task only runs at segment boundaries.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void haptic_init(void)
+{
+    esp_timer_create_args_t timer_args = {
+        .callback = haptic_hold_done,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "haptic_hold",
+    };
+
+    vibration_init();
+    user_pwm_set_fade_callback(haptic_fade_done_isr);
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &hold_timer));
+    task_registry_start(TASK_ID_HAPTIC, haptic_task, NULL, &haptic_handle);
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_play
+* Description  : start a pattern, a running one is cut off. Any task context.
+* Arguments    : pattern
+* Return Value : none
+***********************************************************************************************************************/
+void haptic_play(haptic_pattern_t pattern)
+{
+    if ((haptic_handle == NULL) || (pattern >= HAPTIC_PATTERN_COUNT))
+        return;
+    pending_pattern = pattern;
+    xTaskNotify(haptic_handle, HAPTIC_NOTIFY_PLAY, eSetBits);
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_play_event
+* Description  : play the pattern mapped to an event
+* Arguments    : event
+* Return Value : none
+***********************************************************************************************************************/
+void haptic_play_event(haptic_event_t event)
+{
+    if (event < HAPTIC_EVENT_COUNT)
+        haptic_play((haptic_pattern_t)event_pattern[event]);
+    if (event == HAPTIC_EVENT_HIT)
+        latency.task_path++;
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_play_event_from_isr
+* Description  : ISR side trigger, the sequencer task is strictly above every other application task on its core
+*                (task_registry) so the motor starts as soon as the interrupt returns, even during a publish
+* Arguments    : event, impact_us - esp_timer time of the impact, the PWM edge is measured against it
+* Return Value : true when a yield is needed, pass it to portYIELD_FROM_ISR
+***********************************************************************************************************************/
+bool IRAM_ATTR haptic_play_event_from_isr(haptic_event_t event, int64_t impact_us)
+{
+    BaseType_t woken = pdFALSE;
+
+    if ((haptic_handle == NULL) || (event >= HAPTIC_EVENT_COUNT))
+        return false;
+    pending_pattern = event_pattern[event];
+    pending_impact_us = impact_us;
+    xTaskNotifyFromISR(haptic_handle, HAPTIC_NOTIFY_PLAY | HAPTIC_NOTIFY_PLAY_TIMED, eSetBits, &woken);
+    return woken == pdTRUE;
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_get_latency
+* Description  : copy of the latency histogram
+* Arguments    : out
+* Return Value : none
+***********************************************************************************************************************/
+void haptic_get_latency(haptic_latency_t *out)
+{
+    memcpy(out, &latency, sizeof(haptic_latency_t));
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_set_event_pattern
+* Description  : remap an event, HAPTIC_PATTERN_NONE silences it
+* Arguments    : event, pattern
+* Return Value : none
+***********************************************************************************************************************/
+void haptic_set_event_pattern(haptic_event_t event, haptic_pattern_t pattern)
+{
+    if ((event < HAPTIC_EVENT_COUNT) && (pattern < HAPTIC_PATTERN_COUNT))
+        event_pattern[event] = pattern;
+}
+
+haptic_pattern_t haptic_get_event_pattern(haptic_event_t event)
+{
+    return (event < HAPTIC_EVENT_COUNT) ? (haptic_pattern_t)event_pattern[event] : HAPTIC_PATTERN_NONE;
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_pattern_name
+* Description  : name used over mqtt, the inverse of haptic_pattern_from_name() and haptic_event_from_name()
+* Arguments    : pattern or event
+* Return Value : name, "" when out of range
+***********************************************************************************************************************/
+const char *haptic_pattern_name(haptic_pattern_t pattern)
+{
+    return (pattern < HAPTIC_PATTERN_COUNT) ? haptic_pattern_names[pattern] : "";
+}
+
+const char *haptic_event_name(haptic_event_t event)
+{
+    return (event < HAPTIC_EVENT_COUNT) ? haptic_event_names[event] : "";
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_pattern_from_name
+* Description  : pattern by the name used over mqtt
+* Arguments    : name
+* Return Value : pattern, HAPTIC_PATTERN_COUNT when unknown
+***********************************************************************************************************************/
+haptic_pattern_t haptic_pattern_from_name(const char *name)
+{
+    uint8_t i;
+
+    for (i = 0; (name != NULL) && (i < HAPTIC_PATTERN_COUNT); i++)
+    {
+        if (strcmp(name, haptic_pattern_names[i]) == 0)
+            return (haptic_pattern_t)i;
+    }
+    return HAPTIC_PATTERN_COUNT;
+}
+
+/***********************************************************************************************************************
+* Function Name: haptic_event_from_name
+* Description  : event by the name used over mqtt
+* Arguments    : name
+* Return Value : event, HAPTIC_EVENT_COUNT when unknown
+***********************************************************************************************************************/
+haptic_event_t haptic_event_from_name(const char *name)
+{
+    uint8_t i;
+
+    for (i = 0; (name != NULL) && (i < HAPTIC_EVENT_COUNT); i++)
+    {
+        if (strcmp(name, haptic_event_names[i]) == 0)
+            return (haptic_event_t)i;
+    }
+    return HAPTIC_EVENT_COUNT;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+static void haptic_task(void *pvParameters)
+{
+    uint32_t notified;
+
+    while (1)
+    {
+        xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+        task_registry_wake(TASK_ID_HAPTIC);
+        if (notified & HAPTIC_NOTIFY_PLAY)
+        {
+            esp_timer_stop(hold_timer);
+            active_pattern = pending_pattern;
+            segment_index = 0;
+            repeat_left = HAPTIC_REPEAT_IDLE;
+            if (power_locked == false)
+            {
+                power_locked = true;
+                power_lock(POWER_LOCK_HAPTIC);
+            }
+            haptic_next_segment();
+            // the duty register is latched, the output follows on the next PWM period (200 us at 5 kHz)
+            if (notified & HAPTIC_NOTIFY_PLAY_TIMED)
+                haptic_latency_add(pending_impact_us, esp_timer_get_time());
+        }
+        // a fade end posted before a newer ramp cut in belongs to the superseded fade, the running one reports again
+        else if ((notified & waiting_for) &&
+                 ((waiting_for != HAPTIC_NOTIFY_FADE_DONE) || (user_pwm_fade_running() == false)))
+        {
+            haptic_next_segment();
+        }
+    }
+}
+
+static void haptic_next_segment(void)
+{
+    const haptic_segment_t *segment;
+
+    while (segment_index < HAPTIC_MAX_SEGMENTS)
+    {
+        segment = &haptic_patterns[active_pattern][segment_index++];
+        switch (segment->type)
+        {
+        case HAPTIC_SEG_HOLD:
+        case HAPTIC_SEG_KICK:
+            user_pwm_set_duty_raw(haptic_duty(segment));
+            waiting_for = HAPTIC_NOTIFY_HOLD_DONE;
+            esp_timer_start_once(hold_timer, segment->time_ms * 1000);
+            return;
+        case HAPTIC_SEG_RAMP:
+            waiting_for = HAPTIC_NOTIFY_FADE_DONE;
+            user_pwm_fade(haptic_duty(segment), segment->time_ms);
+            return;
+        case HAPTIC_SEG_REPEAT:
+            if (repeat_left == HAPTIC_REPEAT_IDLE)
+                repeat_left = segment->level;
+            if (repeat_left > 0)
+            {
+                repeat_left--;
+                segment_index = segment->time_ms;
+            }
+            else
+            {
+                repeat_left = HAPTIC_REPEAT_IDLE;
+            }
+            break;
+        case HAPTIC_SEG_END:
+        default:
+            segment_index = HAPTIC_MAX_SEGMENTS;
+            break;
+        }
+    }
+    user_pwm_set_duty_raw(0);
+    waiting_for = 0;
+    if (power_locked == true)
+    {
+        power_locked = false;
+        power_unlock(POWER_LOCK_HAPTIC);
+    }
+}
+
+static uint32_t haptic_duty(const haptic_segment_t *segment)
+{
+    if (segment->type == HAPTIC_SEG_KICK)
+        return USER_PWM_DUTY_MAX;
+    return (uint32_t)USER_PWM_DUTY_MAX * segment->level * deive_data.sensor.vibration_level / (100 * 100);
+}
+
+static bool IRAM_ATTR haptic_fade_done_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+
+    xTaskNotifyFromISR(haptic_handle, HAPTIC_NOTIFY_FADE_DONE, eSetBits, &woken);
+    return woken == pdTRUE;
+}
+
+static void haptic_hold_done(void *arg)
+{
+    xTaskNotify(haptic_handle, HAPTIC_NOTIFY_HOLD_DONE, eSetBits);
+}
+
+static void haptic_latency_add(int64_t impact_us, int64_t edge_us)
+{
+    uint32_t us = (uint32_t)(edge_us - impact_us);
+    uint8_t bin = 0;
+
+    while ((bin < HAPTIC_LATENCY_BINS - 1) && (us >= latency_edges[bin]))
+        bin++;
+    latency.bins[bin]++;
+    latency.count++;
+    latency.last_us = us;
+    if (us > latency.max_us)
+        latency.max_us = us;
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
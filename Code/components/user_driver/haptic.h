@@ -0,0 +1,95 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define HAPTIC_MAX_SEGMENTS (6)
+#define HAPTIC_LATENCY_BINS (8)
+#define HAPTIC_LATENCY_BIN_EDGES_US {100, 200, 500, 1000, 2000, 5000, 10000} /* last bin is >= 10 ms */
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef enum
+{
+	HAPTIC_SEG_END,
+	HAPTIC_SEG_HOLD,   /* jump to level, keep it for time_ms */
+	HAPTIC_SEG_RAMP,   /* hardware fade to level over time_ms */
+	HAPTIC_SEG_KICK,   /* full drive regardless of the user level, spins the motor up */
+	HAPTIC_SEG_REPEAT, /* jump back to segment time_ms, level more times, not nestable */
+} haptic_seg_type_t;
+
+typedef struct
+{
+	uint8_t type;
+	uint8_t level; /* % of vibration_level, repeat count for HAPTIC_SEG_REPEAT */
+	uint16_t time_ms;
+} haptic_segment_t;
+
+typedef enum
+{
+	HAPTIC_PATTERN_NONE,
+	HAPTIC_PATTERN_HIT,
+	HAPTIC_PATTERN_CLICK,
+	HAPTIC_PATTERN_DOUBLE,
+	HAPTIC_PATTERN_SWELL,
+	HAPTIC_PATTERN_ALERT,
+	HAPTIC_PATTERN_COUNT
+} haptic_pattern_t;
+
+typedef enum
+{
+	HAPTIC_EVENT_HIT,
+	HAPTIC_EVENT_BUTTON,
+	HAPTIC_EVENT_ALERT,
+	HAPTIC_EVENT_COUNT
+} haptic_event_t;
+
+/**
+ * Impact (sensor interrupt) to PWM edge latency of the ISR trigger path.
+ */
+typedef struct
+{
+	uint32_t bins[HAPTIC_LATENCY_BINS];
+	uint32_t count;
+	uint32_t max_us;
+	uint32_t last_us;
+	uint32_t task_path; /* hits that only the FIFO detector caught */
+} haptic_latency_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void haptic_init(void);
+
+void haptic_play(haptic_pattern_t pattern);
+
+void haptic_play_event(haptic_event_t event);
+
+bool haptic_play_event_from_isr(haptic_event_t event, int64_t impact_us);
+
+void haptic_get_latency(haptic_latency_t *out);
+
+void haptic_set_event_pattern(haptic_event_t event, haptic_pattern_t pattern);
+
+haptic_pattern_t haptic_get_event_pattern(haptic_event_t event);
+
+const char *haptic_pattern_name(haptic_pattern_t pattern);
+
+const char *haptic_event_name(haptic_event_t event);
+
+haptic_pattern_t haptic_pattern_from_name(const char *name);
+
+haptic_event_t haptic_event_from_name(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
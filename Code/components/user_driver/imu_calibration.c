@@ -0,0 +1,291 @@
+/*
+ * imu_calibration.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_IMU
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "imu_calibration.h"
+#include "../system/standby.h"
+#include "esp_attr.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define IMU_CALIB_NVS_NAMESPACE "imu_calib"
+#define IMU_CALIB_NVS_KEY "tcomp"
+
+#define IMU_CALIB_FLAT_TOLERANCE_MG (150) // capture is refused unless the device lies flat, Z up
+#define IMU_CALIB_ONE_G_MG (1000)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static RTC_DATA_ATTR imu_calib_point_t calib_table[IMU_CALIB_TEMP_BINS]; // kept over standby, no nvs read on wake
+static int32_t active_bias[3] = {0};
+static volatile bool capture_pending = false;
+static volatile bool capture_stored = false;
+static bool capture_save = false; // point accepted, the NVS write waits for imu_calib_flush()
+static int32_t capture_sum[3] = {0};
+static uint16_t capture_count = 0;
+static int16_t last_temperature = 0;
+
+static int bin_of_temperature(int16_t centi_deg);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_init
+* Description  : load the per-device thermal bias table from nvs, a wake from standby still has it in RTC memory
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_init(void)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(calib_table);
+
+    if (standby_warm_boot() == true)
+        return;
+    memset(calib_table, 0x00, sizeof(calib_table));
+    if (nvs_open(IMU_CALIB_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        APP_LOGI("no thermal calibration stored");
+        return;
+    }
+    if ((nvs_get_blob(handle, IMU_CALIB_NVS_KEY, calib_table, &size) != ESP_OK) || (size != sizeof(calib_table)))
+    {
+        APP_LOGE("thermal calibration table invalid, ignored");
+        memset(calib_table, 0x00, sizeof(calib_table));
+    }
+    nvs_close(handle);
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_set_temperature
+* Description  : update the active bias by interpolating the thermal table, called on every FIFO temperature sample
+* Arguments    : centi_deg - die temperature [0.01 degC]
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_set_temperature(int16_t centi_deg)
+{
+    int lo, hi, i;
+    int32_t t_lo, t_hi;
+
+    last_temperature = centi_deg;
+    lo = bin_of_temperature(centi_deg);
+    hi = lo + 1;
+    // nearest valid point at or below, and above the current temperature
+    while ((lo >= 0) && (calib_table[lo].valid == 0))
+        lo--;
+    while ((hi < IMU_CALIB_TEMP_BINS) && (calib_table[hi].valid == 0))
+        hi++;
+
+    if ((lo < 0) && (hi >= IMU_CALIB_TEMP_BINS))
+    {
+        memset(active_bias, 0x00, sizeof(active_bias));
+        return;
+    }
+    if (lo < 0)
+        lo = hi;
+    if (hi >= IMU_CALIB_TEMP_BINS)
+        hi = lo;
+
+    t_lo = (IMU_CALIB_TEMP_MIN_C + lo * IMU_CALIB_TEMP_STEP_C) * 100;
+    t_hi = (IMU_CALIB_TEMP_MIN_C + hi * IMU_CALIB_TEMP_STEP_C) * 100;
+    for (i = 0; i < 3; i++)
+    {
+        if ((hi == lo) || (centi_deg <= t_lo))
+            active_bias[i] = calib_table[lo].bias[i];
+        else if (centi_deg >= t_hi)
+            active_bias[i] = calib_table[hi].bias[i];
+        else
+            active_bias[i] = calib_table[lo].bias[i] +
+                             ((calib_table[hi].bias[i] - calib_table[lo].bias[i]) * (centi_deg - t_lo)) / (t_hi - t_lo);
+    }
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_apply
+* Description  : remove the temperature dependent bias from one accelerometer sample
+* Arguments    : acc_mg - x, y, z [mg], corrected in place
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_apply(int32_t *acc_mg)
+{
+    acc_mg[0] -= active_bias[0];
+    acc_mg[1] -= active_bias[1];
+    acc_mg[2] -= active_bias[2];
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_request_capture
+* Description  : average the next IMU_CALIB_CAPTURE_SAMPLES raw samples into the bin of the current temperature.
+*                The device must lie still and flat (Z up) during the capture.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_request_capture(void)
+{
+    capture_sum[0] = capture_sum[1] = capture_sum[2] = 0;
+    capture_count = 0;
+    capture_stored = false;
+    capture_save = false;
+    capture_pending = true;
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_capture_result
+* Description  : outcome of the last imu_calib_request_capture()
+* Arguments    : stored - out, the point was accepted and saved
+* Return Value : false while the capture is still running
+***********************************************************************************************************************/
+bool imu_calib_capture_result(bool *stored)
+{
+    *stored = capture_stored;
+    return capture_pending == false;
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_feed_capture
+* Description  : accumulate one uncompensated sample while a capture is pending, runs per sample so an accepted point
+*                is only marked here and saved by imu_calib_flush()
+* Arguments    : acc_mg - x, y, z [mg]
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_feed_capture(const int32_t *acc_mg)
+{
+    int32_t bias[3];
+
+    if ((capture_pending == false) || (capture_save == true))
+        return;
+
+    capture_sum[0] += acc_mg[0];
+    capture_sum[1] += acc_mg[1];
+    capture_sum[2] += acc_mg[2];
+    if (++capture_count < IMU_CALIB_CAPTURE_SAMPLES)
+        return;
+
+    bias[0] = capture_sum[0] / capture_count;
+    bias[1] = capture_sum[1] / capture_count;
+    bias[2] = capture_sum[2] / capture_count - IMU_CALIB_ONE_G_MG;
+    if (imu_calib_store_point(bias, last_temperature))
+    {
+        imu_calib_set_temperature(last_temperature);
+        capture_save = true;
+        return;
+    }
+    capture_pending = false;
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_flush
+* Description  : save a point accepted by imu_calib_feed_capture(), called once after the sample batch
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_flush(void)
+{
+    if (capture_save == false)
+        return;
+
+    capture_save = false;
+    capture_stored = (imu_calib_save() == ESP_OK);
+    capture_pending = false;
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_store_point
+* Description  : store one bias point in the thermal table
+* Arguments    : bias_mg - x, y, z bias [mg], centi_deg - temperature of the point [0.01 degC]
+* Return Value : true if the point was accepted
+***********************************************************************************************************************/
+bool imu_calib_store_point(const int32_t *bias_mg, int16_t centi_deg)
+{
+    int bin = bin_of_temperature(centi_deg);
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (abs(bias_mg[i]) > IMU_CALIB_FLAT_TOLERANCE_MG)
+        {
+            APP_LOGE("calibration refused, axis %d off by %d mg", i, bias_mg[i]);
+            return false;
+        }
+    }
+    for (i = 0; i < 3; i++)
+        calib_table[bin].bias[i] = (int16_t)bias_mg[i];
+    calib_table[bin].valid = 1;
+    APP_LOGI("thermal bin %d (%d C): %d %d %d mg", bin, IMU_CALIB_TEMP_MIN_C + bin * IMU_CALIB_TEMP_STEP_C,
+             bias_mg[0], bias_mg[1], bias_mg[2]);
+    return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_save
+* Description  : persist the thermal table
+* Arguments    : none
+* Return Value : esp_err_t
+***********************************************************************************************************************/
+esp_err_t imu_calib_save(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(IMU_CALIB_NVS_NAMESPACE, NVS_READWRITE, &handle);
+
+    if (err != ESP_OK)
+    {
+        APP_LOGE("nvs open err = %d", err);
+        return err;
+    }
+    err = nvs_set_blob(handle, IMU_CALIB_NVS_KEY, calib_table, sizeof(calib_table));
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    if (err != ESP_OK)
+        APP_LOGE("thermal calibration save err = %d", err);
+    return err;
+}
+
+/***********************************************************************************************************************
+* Function Name: imu_calib_clear
+* Description  : forget every bias point
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void imu_calib_clear(void)
+{
+    memset(calib_table, 0x00, sizeof(calib_table));
+    memset(active_bias, 0x00, sizeof(active_bias));
+    imu_calib_save();
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+static int bin_of_temperature(int16_t centi_deg)
+{
+    int bin = (centi_deg - IMU_CALIB_TEMP_MIN_C * 100) / (IMU_CALIB_TEMP_STEP_C * 100);
+
+    if (bin < 0)
+        bin = 0;
+    if (bin >= IMU_CALIB_TEMP_BINS)
+        bin = IMU_CALIB_TEMP_BINS - 1;
+    return bin;
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
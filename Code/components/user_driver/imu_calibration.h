@@ -0,0 +1,54 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define IMU_CALIB_TEMP_MIN_C (-20) /* first bin of the thermal table [degC] */
+#define IMU_CALIB_TEMP_STEP_C (5)  /* bin width [degC] */
+#define IMU_CALIB_TEMP_BINS (19)   /* -20 .. 70 degC */
+
+#define IMU_CALIB_CAPTURE_SAMPLES (416) /* ~1 s at the FIFO rate */
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+typedef struct
+{
+	int16_t bias[3]; // accelerometer bias at this temperature [mg]
+	uint8_t valid;
+} imu_calib_point_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void imu_calib_init(void);
+
+void imu_calib_set_temperature(int16_t centi_deg);
+
+void imu_calib_apply(int32_t *acc_mg);
+
+void imu_calib_request_capture(void);
+
+bool imu_calib_capture_result(bool *stored);
+
+void imu_calib_feed_capture(const int32_t *acc_mg);
+
+void imu_calib_flush(void);
+
+bool imu_calib_store_point(const int32_t *bias_mg, int16_t centi_deg);
+
+esp_err_t imu_calib_save(void);
+
+void imu_calib_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
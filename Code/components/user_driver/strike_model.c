@@ -0,0 +1,153 @@
+/*
+ * strike_model.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_IMU
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "strike_model.h"
+#include "esp_timer.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define STRIKE_NODE(feat, thr, l, r) {.threshold = (thr), .feature = (feat), .left = (l), .right = (r)}
+#define STRIKE_LEAF(label) {.threshold = 0, .feature = STRIKE_NODE_LEAF, .left = (label), .right = 0}
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+/* built-in tree, stays in flash. Hand-tuned, tools/strike_model_export.py replaces it with a trained tree */
+/* strike_model_export.py begin, from tools/strike_model_builtin.json */
+static const strike_node_t default_nodes[] = {
+    /* 0 */ STRIKE_NODE(STRIKE_FEAT_FREEFALL_MS, 80, 1, 2),
+    /* 1 */ STRIKE_NODE(STRIKE_FEAT_PEAK_MG, 6000, 3, 4),
+    /* 2 */ STRIKE_LEAF(STRIKE_LABEL_DROP),
+    /* 3 */ STRIKE_NODE(STRIKE_FEAT_BAND0_PCT, 60, 5, 6),
+    /* 4 */ STRIKE_NODE(STRIKE_FEAT_RINGDOWN_MS, 12, 7, 8),
+    /* 5 */ STRIKE_LEAF(STRIKE_LABEL_GLANCING),
+    /* 6 */ STRIKE_LEAF(STRIKE_LABEL_MISS),
+    /* 7 */ STRIKE_LEAF(STRIKE_LABEL_GLANCING),
+    /* 8 */ STRIKE_LEAF(STRIKE_LABEL_SOLID),
+};
+
+/* reference vectors: peak, ringdown, freefall, peak Hz, dB, band % x4, swing, rate -> label */
+static const strike_vector_t default_vectors[] = {
+    {{14500, 38, 0, 142, 92, 6, 11, 48, 35, 85, 640}, STRIKE_LABEL_SOLID},
+    {{9200, 25, 0, 96, 87, 9, 18, 55, 18, 70, 520}, STRIKE_LABEL_SOLID},
+    {{7800, 9, 0, 58, 83, 21, 44, 27, 8, 40, 310}, STRIKE_LABEL_GLANCING},
+    {{4300, 17, 0, 32, 78, 35, 40, 19, 6, 55, 380}, STRIKE_LABEL_GLANCING},
+    {{3600, 6, 0, 13, 71, 78, 15, 5, 2, 90, 600}, STRIKE_LABEL_MISS},
+    {{3100, 4, 0, 6, 68, 88, 9, 2, 1, 75, 480}, STRIKE_LABEL_MISS},
+    {{11000, 30, 240, 120, 90, 12, 20, 40, 28, 120, 260}, STRIKE_LABEL_DROP},
+    {{5200, 14, 150, 45, 80, 30, 35, 25, 10, 95, 180}, STRIKE_LABEL_DROP},
+};
+/* strike_model_export.py end */
+
+static const strike_model_t default_model = {
+    .nodes = default_nodes,
+    .node_count = sizeof(default_nodes) / sizeof(default_nodes[0]),
+    .vectors = default_vectors,
+    .vector_count = sizeof(default_vectors) / sizeof(default_vectors[0]),
+};
+
+static uint32_t model_blob[STRIKE_MODEL_MAX_BYTES / sizeof(uint32_t)]; // word aligned for the node table
+static strike_model_t active_model;
+
+static bool strike_model_read_file(strike_model_t *model);
+static void strike_model_self_test(const strike_model_t *model, const char *name);
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: strike_model_load
+* Description  : use the model blob from spiffs when it parses and reproduces its reference labels, else the built-in
+*                tree. Call before the first strike_model_classify, spiffs must be mounted.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void strike_model_load(void)
+{
+    strike_model_t model;
+
+    if (strike_model_read_file(&model) == true)
+    {
+        if (strike_model_verify(&model) == 0)
+        {
+            active_model = model;
+            strike_model_self_test(&active_model, STRIKE_MODEL_PATH);
+            return;
+        }
+        APP_LOGE("%s does not reproduce its reference labels, using the built-in model", STRIKE_MODEL_PATH);
+    }
+    active_model = default_model;
+    strike_model_self_test(&active_model, "built-in");
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_model_classify
+* Description  : label one strike with the active model
+* Arguments    : features - STRIKE_FEATURE_COUNT values
+* Return Value : label
+***********************************************************************************************************************/
+strike_label_t strike_model_classify(const int16_t *features)
+{
+    int64_t start = esp_timer_get_time();
+    strike_label_t label = strike_classify(&active_model, features);
+
+    APP_LOGD("strike %s in %d us", strike_label_name(label), (int)(esp_timer_get_time() - start));
+    return label;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+static bool strike_model_read_file(strike_model_t *model)
+{
+    FILE *file;
+    size_t len;
+
+    file = fopen(STRIKE_MODEL_PATH, "rb");
+    if (file == NULL)
+        return false;
+    len = fread(model_blob, 1, sizeof(model_blob), file);
+    // a blob that fills the buffer is either exactly the max size or truncated, refuse both
+    if ((len == sizeof(model_blob)) || (strike_model_parse((const uint8_t *)model_blob, len, model) == false))
+    {
+        APP_LOGE("%s invalid, using the built-in model", STRIKE_MODEL_PATH);
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+static void strike_model_self_test(const strike_model_t *model, const char *name)
+{
+    int64_t start = esp_timer_get_time();
+    uint16_t mismatch = strike_model_verify(model);
+
+    if (model->vector_count == 0)
+    {
+        APP_LOGI("strike model %s: %d nodes, no reference vectors", name, model->node_count);
+        return;
+    }
+    APP_LOGI("strike model %s: %d nodes, %d/%d reference labels match, %d us/strike", name, model->node_count,
+             model->vector_count - mismatch, model->vector_count,
+             (int)((esp_timer_get_time() - start) / model->vector_count));
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,31 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+#include "../dsp/strike_classifier.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#define STRIKE_MODEL_PATH "/spiffs/strike.mdl" /* replaces the built-in tree when valid */
+#define STRIKE_MODEL_MAX_BYTES (4096)
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void strike_model_load(void);
+
+strike_label_t strike_model_classify(const int16_t *features);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,179 @@
+/*
+ * strike_stats.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ */
+/***********************************************************************************************************************
+* Pragma directive
+***********************************************************************************************************************/
+#define APP_LOG_MODULE LOG_MODULE_IMU
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include "strike_stats.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static const uint16_t bin_edges[STRIKE_STATS_BINS - 1] = STRIKE_STATS_BIN_EDGES_MG;
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static RTC_DATA_ATTR strike_window_t window; // the open window goes on after standby, any other reset clears it
+static uint32_t window_ms = STRIKE_WINDOW_S * 1000;
+static uint32_t window_start_ms = 0; /* a multiple of the window since boot while the length is unchanged */
+static uint32_t last_strike_ms;
+static strike_event_t raw_ring[STRIKE_RAW_EVENTS];
+static uint32_t raw_head;
+static volatile uint32_t live_until_ms;
+/***********************************************************************************************************************
+* Exported global variables and functions (to be accessed by other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Imported global variables and functions (from other files)
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* Function Name: strike_stats_record
+* Description  : add a finished strike to the open window and to the raw ring, called by imu_task. The gap to the
+*                previous strike counts as active time when it is under STRIKE_ACTIVE_GAP_MS, a gap across a window
+*                boundary goes to the later window.
+* Arguments    : peak_mg - envelope peak, label, swing_deg, rate_dps
+* Return Value : none
+***********************************************************************************************************************/
+void strike_stats_record(uint16_t peak_mg, strike_label_t label, int16_t swing_deg, int16_t rate_dps)
+{
+	uint32_t now = usertimer_gettick();
+	uint8_t bin = 0;
+
+	while ((bin < STRIKE_STATS_BINS - 1) && (peak_mg > bin_edges[bin]))
+		bin++;
+	portENTER_CRITICAL(&stats_lock);
+	if ((window.count == 0) || (peak_mg < window.peak_min_mg))
+		window.peak_min_mg = peak_mg;
+	if (peak_mg > window.peak_max_mg)
+		window.peak_max_mg = peak_mg;
+	window.count++;
+	window.peak_sum_mg += peak_mg;
+	window.bins[bin]++;
+	if (label < STRIKE_LABEL_COUNT)
+		window.labels[label]++;
+	if ((raw_head != 0) && (now - last_strike_ms < STRIKE_ACTIVE_GAP_MS))
+		window.active_ms += now - last_strike_ms;
+	last_strike_ms = now;
+	raw_ring[raw_head & (STRIKE_RAW_EVENTS - 1)] = (strike_event_t){
+		.at_ms = now,
+		.peak_mg = peak_mg,
+		.label = label,
+		.swing_deg = swing_deg,
+		.rate_dps = rate_dps,
+	};
+	raw_head++;
+	portEXIT_CRITICAL(&stats_lock);
+}
+
+/* the open window reached its boundary, polled by mqtt_send_task online or not */
+bool strike_stats_due(void)
+{
+	return (int32_t)(usertimer_gettick() - (window_start_ms + window_ms)) >= 0;
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_stats_close
+* Description  : end the open window on the last boundary passed and start the next one there
+* Arguments    : out - the closed window
+* Return Value : true when it holds strikes and is worth a summary, an idle window is not reported
+***********************************************************************************************************************/
+bool strike_stats_close(strike_window_t *out)
+{
+	uint32_t now = usertimer_gettick();
+	uint32_t start_ms;
+
+	if (strike_stats_due() == false)
+		return false;
+	portENTER_CRITICAL(&stats_lock);
+	start_ms = window_start_ms;
+	window_start_ms += ((now - window_start_ms) / window_ms) * window_ms;
+	*out = window;
+	memset(&window, 0, sizeof(window));
+	portEXIT_CRITICAL(&stats_lock);
+	out->start_s = start_ms / 1000;
+	out->length_s = (window_start_ms - start_ms) / 1000;
+	APP_LOGD("strike window %u s: %u strikes, active %u ms", out->length_s, out->count, out->active_ms);
+	return out->count > 0;
+}
+
+/* takes effect from the open window's start */
+bool strike_stats_set_window(uint32_t window_s)
+{
+	if ((window_s < STRIKE_WINDOW_MIN_S) || (window_s > STRIKE_WINDOW_MAX_S))
+		return false;
+	portENTER_CRITICAL(&stats_lock);
+	window_ms = window_s * 1000;
+	portEXIT_CRITICAL(&stats_lock);
+	APP_LOGI("strike window %u s", window_s);
+	return true;
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_stats_set_live
+* Description  : also report every strike as it happens for live_s seconds, e.g. while installing a hammer.
+*                0 goes back to summaries only.
+* Arguments    : live_s
+* Return Value : none
+***********************************************************************************************************************/
+void strike_stats_set_live(uint32_t live_s)
+{
+	live_until_ms = usertimer_gettick() + live_s * 1000;
+}
+
+bool strike_stats_live(void)
+{
+	return (int32_t)(live_until_ms - usertimer_gettick()) > 0;
+}
+
+/***********************************************************************************************************************
+* Function Name: strike_stats_read
+* Description  : copy raw strikes out of the ring, oldest first. A cursor the writer lapped skips to the oldest
+*                strike still held.
+* Arguments    : cursor - start at strike_stats_oldest(), advanced past the strikes copied; events, max
+* Return Value : number copied, 0 once the cursor caught up
+***********************************************************************************************************************/
+uint16_t strike_stats_read(uint32_t *cursor, strike_event_t *events, uint16_t max)
+{
+	uint16_t count = 0;
+
+	portENTER_CRITICAL(&stats_lock);
+	if (raw_head - *cursor > STRIKE_RAW_EVENTS)
+		*cursor = raw_head - STRIKE_RAW_EVENTS;
+	while ((count < max) && (*cursor != raw_head))
+	{
+		events[count++] = raw_ring[*cursor & (STRIKE_RAW_EVENTS - 1)];
+		(*cursor)++;
+	}
+	portEXIT_CRITICAL(&stats_lock);
+	return count;
+}
+
+uint32_t strike_stats_oldest(void)
+{
+	uint32_t head = raw_head;
+
+	return (head > STRIKE_RAW_EVENTS) ? (head - STRIKE_RAW_EVENTS) : 0;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
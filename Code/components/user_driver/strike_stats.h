@@ -0,0 +1,75 @@
+#pragma once
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****************************************************************************/
+/***        Include files                                                 ***/
+/****************************************************************************/
+#include "../../Common.h"
+#include "../dsp/strike_classifier.h"
+/****************************************************************************/
+/***        Macro Definitions                                             ***/
+/****************************************************************************/
+#ifdef CONFIG_STRIKE_WINDOW_S
+#define STRIKE_WINDOW_S CONFIG_STRIKE_WINDOW_S
+#else
+#define STRIKE_WINDOW_S (60)
+#endif
+
+#define STRIKE_WINDOW_MIN_S (10)
+#define STRIKE_WINDOW_MAX_S (3600)
+#define STRIKE_ACTIVE_GAP_MS (10000) /* strikes closer than this are one stretch of active use */
+#define STRIKE_STATS_BINS (6)
+#define STRIKE_STATS_BIN_EDGES_MG {2000, 4000, 6000, 8000, 12000} /* peak upper edges, the last bin to 16 g */
+#define STRIKE_RAW_EVENTS (32) /* power of two */
+/****************************************************************************/
+/***        Type Definitions                                              ***/
+/****************************************************************************/
+/* one interval of strikes */
+typedef struct
+{
+	uint32_t start_s;  /* uptime at the window start */
+	uint32_t length_s; /* longer than the window when boundaries passed without a poll */
+	uint16_t count;
+	uint16_t peak_min_mg;
+	uint16_t peak_max_mg;
+	uint32_t peak_sum_mg;
+	uint16_t bins[STRIKE_STATS_BINS];
+	uint16_t labels[STRIKE_LABEL_COUNT];
+	uint32_t active_ms;
+} strike_window_t;
+
+typedef struct
+{
+	uint32_t at_ms; /* uptime */
+	uint16_t peak_mg;
+	uint8_t label;
+	int16_t swing_deg;
+	int16_t rate_dps;
+} strike_event_t;
+
+/****************************************************************************/
+/***         Exported global functions                                     ***/
+/****************************************************************************/
+void strike_stats_record(uint16_t peak_mg, strike_label_t label, int16_t swing_deg, int16_t rate_dps);
+
+bool strike_stats_due(void);
+
+bool strike_stats_close(strike_window_t *out);
+
+bool strike_stats_set_window(uint32_t window_s);
+
+void strike_stats_set_live(uint32_t live_s);
+
+bool strike_stats_live(void);
+
+uint16_t strike_stats_read(uint32_t *cursor, strike_event_t *events, uint16_t max);
+
+uint32_t strike_stats_oldest(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,12 +7,16 @@
 /***********************************************************************************************************************
 * Pragma directive
 ***********************************************************************************************************************/
-
+#define APP_LOG_MODULE LOG_MODULE_BUTTON
 /***********************************************************************************************************************
 * Includes <System Includes>
 ***********************************************************************************************************************/
 #include "user_buttons.h"
 #include "../../Common.h"
+#include <string.h>
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "../system/power.h"
 /***********************************************************************************************************************
 * Macro definitions
 ***********************************************************************************************************************/
@@ -42,6 +46,21 @@ static void *pvCustomData[E_EVENT_HARD_MAX] = {0};
 static uint32_t (*gettick)(void);
 
 static uint32_t u32ButtonHasHoldEvent = 0;
+
+static uint32_t u32ButtonDownMask = 0;
+static const tsButtonCombo *tsCombos;
+static uint8_t u8ComboCount;
+static uint8_t pu8ComboStep[BUTTON_COMBO_MAX] = {0};        /* sequence progress */
+static uint32_t pu32ComboTime[BUTTON_COMBO_MAX] = {0};      /* last step / chord complete tick */
+static uint32_t u32ChordArmed = 0;                          /* chord complete, waiting for its hold time */
+static uint32_t u32ComboMembers = 0;                        /* buttons pressed as part of a combo, until released */
+static TaskHandle_t edgeNotifyTask = NULL;                   /* woken on any button edge */
+
+static void vHardButtonComboPress(uint8_t u8Btn, uint32_t u32Now);
+static void vHardButtonComboRelease(uint8_t u8Btn);
+static void vHardButtonComboHold(uint32_t u32Now);
+static void vHardButtonComboFire(uint8_t u8Combo, uint32_t u32Event);
+static void buttons_edge_isr(void *arg);
 /***********************************************************************************************************************
 * Exported global variables and functions (to be accessed by other files)
 ***********************************************************************************************************************/
@@ -60,8 +79,9 @@ void buttons_gpio_init(void)
 {
     gpio_config_t io_conf;
 
-    //interrupt of rising edge
-    io_conf.intr_type = GPIO_PIN_INTR_DISABLE;
+    //interrupt on both edges, wakes the polling task instead of a fixed 10 ms poll. Levels, re-armed in the ISR,
+    //so a press also wakes the chip from light sleep (power_init)
+    io_conf.intr_type = GPIO_INTR_LOW_LEVEL;
     //bit mask of the pins, use GPIO0 here
     io_conf.pin_bit_mask = GPIO_INPUT_PIN_SEL;
     //set as input mode
@@ -74,6 +94,24 @@ void buttons_gpio_init(void)
     {
         APP_LOGE("error configuring inputs\n");
     }
+    error = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if ((error != ESP_OK) && (error != ESP_ERR_INVALID_STATE)) // already installed by someone else is fine
+    {
+        APP_LOGE("gpio isr service err %d", error);
+    }
+    gpio_isr_handler_add(GPIO_USER_BOOT_BUTTON, buttons_edge_isr, (void *)GPIO_USER_BOOT_BUTTON);
+    gpio_isr_handler_add(GPIO_USER_BUTTON, buttons_edge_isr, (void *)GPIO_USER_BUTTON);
+}
+
+/***********************************************************************************************************************
+* Function Name: buttons_set_edge_notify
+* Description  : the task to notify on every button edge, it can block in ulTaskNotifyTake while bHardButtonIsIdle()
+* Arguments    : task - NULL to stop notifying
+* Return Value : none
+***********************************************************************************************************************/
+void buttons_set_edge_notify(TaskHandle_t task)
+{
+    edgeNotifyTask = task;
 }
 /***********************************************************************************************************************
 * Static Functions
@@ -118,6 +156,45 @@ void vHardButtonSetGetTickCallback(uint32_t (*gettickCb)(void))
     gettick = gettickCb;
 }
 
+void vHardButtonSetCombos(const tsButtonCombo *combos, uint8_t u8Count)
+{
+    if (BUTTON_COMBO_MAX < u8Count)
+    {
+        APP_LOGE("Not support %d combos", u8Count);
+        return;
+    }
+    tsCombos = combos;
+    u8ComboCount = u8Count;
+    u32ChordArmed = 0;
+    u32ComboMembers = 0;
+    memset(pu8ComboStep, 0x00, sizeof(pu8ComboStep));
+}
+
+/***********************************************************************************************************************
+* Function Name: bHardButtonIsIdle
+* Description  : nothing is pressed or timing, the next event can only start with an edge
+* Arguments    : none
+* Return Value : true when buttons_process() has nothing to poll for
+***********************************************************************************************************************/
+bool bHardButtonIsIdle(void)
+{
+    return (u32ButtonDownMask == 0) && (u32ChordArmed == 0) && (u32ButtonPressEvent == 0) &&
+           (u32ButtonReleaseEvent == 0);
+}
+
+/***********************************************************************************************************************
+* Function Name: bHardButtonIsComboMember
+* Description  : the button is down as part of an armed chord, or its press advanced a sequence past the first step.
+*                Stays set through the release callback, so a press and its release are both combo edges. The first
+*                step of a sequence cannot be told from a plain press yet.
+* Arguments    : u8Btn
+* Return Value : true when the press / release callbacks of this button should not count as single button input
+***********************************************************************************************************************/
+bool bHardButtonIsComboMember(uint8_t u8Btn)
+{
+    return (u32ComboMembers >> u8Btn) & 0x1;
+}
+
 void buttons_process(void *params)
 {
     uint8_t i = 0;
@@ -148,10 +225,14 @@ void buttons_process(void *params)
                 {
                     u32ButtonPressEvent |= 1 << i;
                     pu32ButtonHoldTimeCount[i] = gettick();
+                    u32ButtonDownMask |= 1 << i;
+                    vHardButtonComboPress(i, pu32ButtonHoldTimeCount[i]);
                 }
                 else
                 {
                     u32ButtonReleaseEvent |= 1 << i;
+                    u32ButtonDownMask &= ~(1 << i);
+                    vHardButtonComboRelease(i);
                     pu32ButtonHoldTimeCount[i] = 0;
                     pu32ButtonOnHoldTimeCount[i] = 0;
                 }
@@ -160,6 +241,11 @@ void buttons_process(void *params)
         }
     }
 
+    if (u32ChordArmed)
+    {
+        vHardButtonComboHold(gettick());
+    }
+
     for (i = 0; i < u8ButtonCount; i++)
     {
         if (u32ButtonData[i] != hwParams[i].u32IdleLevel)
@@ -237,6 +323,7 @@ void buttons_process(void *params)
                 tsCallbackTable[E_EVENT_HARD_BUTTON_RELEASE](i, E_EVENT_HARD_BUTTON_RELEASE, (void *)u32ButtonHasHoldEvent);
             }
             u32ButtonReleaseEvent &= ~(1 << i);
+            u32ComboMembers &= ~(1 << i);
             u32ButtonHoldEvent &= ~(1 << i); // clear
             uint8_t buffer_value = 0;
             buffer_value = (1 << i);
@@ -276,6 +363,136 @@ void vHardButtonSetCallback(eHardButtonEventType event, pHardButtonEventHandler
     }
 }
 
+static void IRAM_ATTR buttons_edge_isr(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    power_wake_rearm_isr((uint8_t)(uintptr_t)arg);
+    if (edgeNotifyTask != NULL)
+    {
+        vTaskNotifyGiveFromISR(edgeNotifyTask, &woken);
+    }
+    if (woken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/***********************************************************************************************************************
+* Function Name: vHardButtonComboPress
+* Description  : advance chords and sequences on a press edge, O(combos) and only on edges
+* Arguments    : u8Btn - pressed button, u32Now - edge tick
+* Return Value : none
+***********************************************************************************************************************/
+static void vHardButtonComboPress(uint8_t u8Btn, uint32_t u32Now)
+{
+    uint8_t c, j;
+
+    for (c = 0; c < u8ComboCount; c++)
+    {
+        const tsButtonCombo *combo = &tsCombos[c];
+
+        if (combo->u8Type == E_BUTTON_COMBO_CHORD)
+        {
+            if (!((combo->u32Mask >> u8Btn) & 0x1) || ((u32ButtonDownMask & combo->u32Mask) != combo->u32Mask))
+            {
+                continue;
+            }
+            /* every member must have gone down inside the window */
+            for (j = 0; j < u8ButtonCount; j++)
+            {
+                if (((combo->u32Mask >> j) & 0x1) && (u32Now - pu32ButtonHoldTimeCount[j] > combo->u16WindowMs))
+                {
+                    break;
+                }
+            }
+            if (j == u8ButtonCount)
+            {
+                pu32ComboTime[c] = u32Now;
+                u32ChordArmed |= (1 << c);
+                u32ComboMembers |= combo->u32Mask;
+                if (combo->u16HoldMs == 0)
+                {
+                    vHardButtonComboHold(u32Now);
+                }
+            }
+        }
+        else
+        {
+            if ((pu8ComboStep[c] != 0) && (u32Now - pu32ComboTime[c] > combo->u16WindowMs))
+            {
+                pu8ComboStep[c] = 0;
+            }
+            if (combo->pu8Steps[pu8ComboStep[c]] == u8Btn)
+            {
+                pu8ComboStep[c]++;
+                if (pu8ComboStep[c] > 1)
+                {
+                    u32ComboMembers |= (1 << u8Btn);
+                }
+            }
+            else
+            {
+                /* a wrong press may still be the start of a new attempt */
+                pu8ComboStep[c] = (combo->pu8Steps[0] == u8Btn) ? 1 : 0;
+            }
+            pu32ComboTime[c] = u32Now;
+            if (pu8ComboStep[c] >= combo->u8StepCount)
+            {
+                pu8ComboStep[c] = 0;
+                vHardButtonComboFire(c, E_EVENT_HARD_BUTTON_SEQUENCE);
+            }
+        }
+    }
+}
+
+/***********************************************************************************************************************
+* Function Name: vHardButtonComboRelease
+* Description  : releasing any member cancels a chord that has not fired yet
+* Arguments    : u8Btn - released button
+* Return Value : none
+***********************************************************************************************************************/
+static void vHardButtonComboRelease(uint8_t u8Btn)
+{
+    uint8_t c;
+
+    for (c = 0; c < u8ComboCount; c++)
+    {
+        if ((tsCombos[c].u8Type == E_BUTTON_COMBO_CHORD) && ((tsCombos[c].u32Mask >> u8Btn) & 0x1))
+        {
+            u32ChordArmed &= ~(1 << c);
+        }
+    }
+}
+
+/***********************************************************************************************************************
+* Function Name: vHardButtonComboHold
+* Description  : fire armed chords whose hold time has passed, only called while a chord is armed
+* Arguments    : u32Now
+* Return Value : none
+***********************************************************************************************************************/
+static void vHardButtonComboHold(uint32_t u32Now)
+{
+    uint8_t c;
+
+    for (c = 0; c < u8ComboCount; c++)
+    {
+        if (((u32ChordArmed >> c) & 0x1) && (u32Now - pu32ComboTime[c] >= tsCombos[c].u16HoldMs))
+        {
+            u32ChordArmed &= ~(1 << c);
+            vHardButtonComboFire(c, E_EVENT_HARD_BUTTON_CHORD);
+        }
+    }
+}
+
+static void vHardButtonComboFire(uint8_t u8Combo, uint32_t u32Event)
+{
+    if (NULL != tsCallbackTable[u32Event])
+    {
+        tsCallbackTable[u32Event](u8Combo, u32Event, pvCustomData[u32Event]);
+    }
+}
+
 /***********************************************************************************************************************
 * End of file
 ***********************************************************************************************************************/
@@ -9,6 +9,8 @@ extern "C"
 /***        Include files                                                 ***/
 /****************************************************************************/
 #include "../../Common.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 /****************************************************************************/
 /***        Macro Definitions                                             ***/
 /****************************************************************************/
@@ -21,6 +23,8 @@ extern "C"
 #define IDLE_TIME_COUNT_IN_MS (30000)
 #define BUTTON_DOUBLE_CLICK_TIME (500)
 #define BUTTON_PRESS_DEBOUND_TIME (50)
+#define BUTTON_COMBO_MAX (4u)
+#define BUTTON_COMBO_MAX_STEPS (4u)
 	/****************************************************************************/
 	/***        Type Definitions                                              ***/
 	/****************************************************************************/
@@ -37,6 +41,8 @@ extern "C"
 		E_EVENT_HARD_BUTTON_TRIPLE_CLICK,
 		E_EVENT_HARD_ILDE,
 		E_EVENT_HARD_ILDE_BREAK,
+		E_EVENT_HARD_BUTTON_CHORD,	  /* button idx = combo idx */
+		E_EVENT_HARD_BUTTON_SEQUENCE, /* button idx = combo idx */
 		E_EVENT_HARD_MAX
 	} eHardButtonEventType;
 
@@ -50,6 +56,26 @@ extern "C"
 		uint8_t button_pin;	 // Debound enable;
 	} tsButtonConfig;
 
+	typedef enum
+	{
+		E_BUTTON_COMBO_CHORD = 0, /* all buttons down together */
+		E_BUTTON_COMBO_SEQUENCE,  /* presses in the given order */
+	} eButtonComboType;
+
+	/**
+ * Chord: u32Mask buttons pressed within u16WindowMs of each other and kept down for u16HoldMs.
+ * Sequence: pu8Steps pressed in order with at most u16WindowMs between presses.
+ */
+	typedef struct
+	{
+		uint8_t u8Type;
+		uint8_t u8StepCount;
+		uint8_t pu8Steps[BUTTON_COMBO_MAX_STEPS];
+		uint32_t u32Mask;
+		uint16_t u16WindowMs;
+		uint16_t u16HoldMs;
+	} tsButtonCombo;
+
 	/**
  * Event callback function type
  * button idx, event type, custom data
@@ -62,6 +88,12 @@ extern "C"
 
 	void vHardButtonSetGetTickCallback(uint32_t (*gettickCb)(void));
 
+	void vHardButtonSetCombos(const tsButtonCombo *combos, uint8_t u8ComboCount);
+
+	bool bHardButtonIsIdle(void);
+
+	bool bHardButtonIsComboMember(uint8_t u8Btn);
+
 	/**
  * Event callback function type
  * button idx, event type, custom data
@@ -76,6 +108,8 @@ extern "C"
 	void buttons_process(void *params);
 
 	void buttons_gpio_init(void);
+
+	void buttons_set_edge_notify(TaskHandle_t task);
 #ifdef __cplusplus
 }
 #endif
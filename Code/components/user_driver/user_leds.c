@@ -12,18 +12,73 @@
 * Includes <System Includes>
 ***********************************************************************************************************************/
 #include "user_leds.h"
+#include "driver/ledc.h"
+#include "esp_timer.h"
+#include "../peripheral/user_pwm.h"
+#include "../system/power.h"
 /***********************************************************************************************************************
 * Macro definitions
 ***********************************************************************************************************************/
+#define LEDS_TIMER LEDC_TIMER_1 // timer 0 drives the motor
+#define LEDS_MODE LEDC_LOW_SPEED_MODE
+#define LEDS_DUTY_RES LEDC_TIMER_13_BIT
+#define LEDS_DUTY_MAX ((1 << 13) - 1)
+#define LEDS_FREQUENCY (5000)
 
+#define LED_PATTERN(steps, repeat) {(steps), sizeof(steps) / sizeof(steps[0]), (repeat)}
 /***********************************************************************************************************************
 * Typedef definitions
 ***********************************************************************************************************************/
+typedef struct
+{
+	const led_step_t *steps;
+	uint8_t count;
+	bool loop;
+} led_pattern_def_t;
 
+typedef struct
+{
+	ledc_channel_t channel;
+	uint8_t gpio;
+	esp_timer_handle_t timer;
+	volatile uint8_t requested; // written by any task, applied in the timer callback
+	uint8_t active;
+	uint8_t base; // pattern a one shot returns to
+	uint8_t step;
+	volatile uint32_t fade_end_ms; // a request waits for the running fade, the LEDC driver would block on it
+} led_state_t;
 /***********************************************************************************************************************
 * Private global variables and functions
 ***********************************************************************************************************************/
+static const led_step_t steps_off[] = {{0, 0, 0}};
+static const led_step_t steps_on[] = {{100, 0, 0}};
+static const led_step_t steps_breathe[] = {{100, 1200, 100}, {0, 1200, 400}};
+static const led_step_t steps_blink_1[] = {{100, 0, 150}, {0, 0, 1500}};
+static const led_step_t steps_blink_2[] = {{100, 0, 150}, {0, 0, 250}, {100, 0, 150}, {0, 0, 1500}};
+static const led_step_t steps_blink_3[] = {{100, 0, 150}, {0, 0, 250}, {100, 0, 150}, {0, 0, 250}, {100, 0, 150}, {0, 0, 1500}};
+static const led_step_t steps_flash[] = {{100, 0, 60}, {0, 80, 80}};
+
+static const led_pattern_def_t led_patterns[LED_PATTERN_COUNT] = {
+    [LED_PATTERN_OFF] = LED_PATTERN(steps_off, false),
+    [LED_PATTERN_ON] = LED_PATTERN(steps_on, false),
+    [LED_PATTERN_BREATHE] = LED_PATTERN(steps_breathe, true),
+    [LED_PATTERN_BLINK_1] = LED_PATTERN(steps_blink_1, true),
+    [LED_PATTERN_BLINK_2] = LED_PATTERN(steps_blink_2, true),
+    [LED_PATTERN_BLINK_3] = LED_PATTERN(steps_blink_3, true),
+    [LED_PATTERN_FLASH] = LED_PATTERN(steps_flash, false),
+};
+
+static led_state_t leds[LED_COUNT] = {
+    [LED_RED] = {.channel = LEDC_CHANNEL_1, .gpio = GPIO_USER_LED_RED},
+    [LED_GREEN] = {.channel = LEDC_CHANNEL_2, .gpio = GPIO_USER_LED_GREEN},
+    [LED_BLUE] = {.channel = LEDC_CHANNEL_3, .gpio = GPIO_USER_LED_BLUE},
+};
 
+static uint8_t leds_lit = 0; // one bit per LED not on LED_PATTERN_OFF, POWER_LOCK_LEDS is held while any is set
+
+static void leds_kick(led_state_t *led);
+static void leds_step(void *arg);
+static void leds_power(const led_state_t *led);
 /***********************************************************************************************************************
 * Exported global variables and functions (to be accessed by other files)
 ***********************************************************************************************************************/
@@ -33,57 +88,183 @@
 ***********************************************************************************************************************/
 
 /***********************************************************************************************************************
-* Function Name: 
-* Description  :
+* Function Name: leds_gpio_init
+* Description  : the three LEDs on LEDC channels, one esp_timer per LED steps its pattern. Between steps nothing
+*                runs, fades are done by the LEDC hardware.
 * Arguments    : none
 * Return Value : none
 ***********************************************************************************************************************/
 void leds_gpio_init(void)
-{    
-    //zero-initialize the config structure.
-    gpio_config_t io_conf = {};
-    //disable interrupt
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    //set as output mode
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    //bit mask of the pins that you want to set,e.g.GPIO18/19
-    io_conf.pin_bit_mask = GPIO_OUTPUT_PIN_SEL;
-    //disable pull-down mode
-    io_conf.pull_down_en = 0;
-    //disable pull-up mode
-    io_conf.pull_up_en = 0;
-    esp_err_t error = gpio_config(&io_conf); //configure GPIO with the given settings
-    if (error != ESP_OK)
+{
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDS_MODE,
+        .timer_num = LEDS_TIMER,
+        .duty_resolution = LEDS_DUTY_RES,
+        .freq_hz = LEDS_FREQUENCY,
+        .clk_cfg = LEDC_AUTO_CLK};
+    esp_timer_create_args_t timer_args = {
+        .callback = leds_step,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "leds",
+    };
+    uint8_t i;
+
+    ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
+    for (i = 0; i < LED_COUNT; i++)
+    {
+        ledc_channel_config_t ledc_channel = {
+            .speed_mode = LEDS_MODE,
+            .channel = leds[i].channel,
+            .timer_sel = LEDS_TIMER,
+            .intr_type = LEDC_INTR_DISABLE,
+            .gpio_num = leds[i].gpio,
+            .duty = 0,
+            .hpoint = 0};
+        ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+        timer_args.arg = &leds[i];
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &leds[i].timer));
+    }
+    user_pwm_fade_service_install();
+}
+
+/***********************************************************************************************************************
+* Function Name: leds_set_pattern
+* Description  : change the pattern of one LED, a running flash finishes first, a running fade ends first
+* Arguments    : led, pattern
+* Return Value : none
+***********************************************************************************************************************/
+void leds_set_pattern(led_id_t led, led_pattern_t pattern)
+{
+    if ((led >= LED_COUNT) || (pattern >= LED_PATTERN_COUNT) || (pattern == LED_PATTERN_FLASH))
+        return;
+    leds[led].base = pattern;
+    if (leds[led].active != LED_PATTERN_FLASH)
     {
-        APP_LOGE("error configuring outputs\n");
+        leds[led].requested = pattern;
+        leds_kick(&leds[led]);
     }
 }
 
+/***********************************************************************************************************************
+* Function Name: leds_flash
+* Description  : short flash on top of the current pattern
+* Arguments    : led
+* Return Value : none
+***********************************************************************************************************************/
+void leds_flash(led_id_t led)
+{
+    if (led >= LED_COUNT)
+        return;
+    leds[led].requested = LED_PATTERN_FLASH;
+    leds_kick(&leds[led]);
+}
+
+/***********************************************************************************************************************
+* Function Name: leds_show_status
+* Description  : connectivity state -> patterns. Blue blink code 1 = no Wi-Fi, 2 = no MQTT, green breathing = online.
+*                Call wherever wifi_status / mqtt_status change.
+* Arguments    : none
+* Return Value : none
+***********************************************************************************************************************/
+void leds_show_status(void)
+{
+    if (deive_data.wifi_status == false)
+    {
+        leds_set_pattern(LED_GREEN, LED_PATTERN_OFF);
+        leds_set_pattern(LED_BLUE, LED_PATTERN_BLINK_1);
+    }
+    else if (deive_data.mqtt_status == false)
+    {
+        leds_set_pattern(LED_GREEN, LED_PATTERN_OFF);
+        leds_set_pattern(LED_BLUE, LED_PATTERN_BLINK_2);
+    }
+    else
+    {
+        leds_set_pattern(LED_BLUE, LED_PATTERN_OFF);
+        leds_set_pattern(LED_GREEN, LED_PATTERN_BREATHE);
+    }
+}
 
 void led_red(bool _status)
 {
-    gpio_set_level(GPIO_USER_LED_RED, _status);
+    leds_set_pattern(LED_RED, _status ? LED_PATTERN_ON : LED_PATTERN_OFF);
 }
 
 void led_green(bool _status)
 {
-    gpio_set_level(GPIO_USER_LED_GREEN, _status);
+    leds_set_pattern(LED_GREEN, _status ? LED_PATTERN_ON : LED_PATTERN_OFF);
 }
 
 void led_blue(bool _status)
 {
-    gpio_set_level(GPIO_USER_LED_BLUE, _status);
+    leds_set_pattern(LED_BLUE, _status ? LED_PATTERN_ON : LED_PATTERN_OFF);
 }
 /***********************************************************************************************************************
 * Static Functions
 ***********************************************************************************************************************/
-/***********************************************************************************************************************
-* Function Name:
-* Description  :
-* Arguments    : none
-* Return Value : none
-***********************************************************************************************************************/
+static void leds_kick(led_state_t *led)
+{
+    int32_t fading_ms = (int32_t)(led->fade_end_ms - (uint32_t)(esp_timer_get_time() / 1000));
+
+    // the callback owns the channel, it picks the request up at once or at the end of a running fade
+    esp_timer_stop(led->timer);
+    esp_timer_start_once(led->timer, (fading_ms > 0) ? (uint64_t)fading_ms * 1000 : 0);
+}
+
+static void leds_step(void *arg)
+{
+    led_state_t *led = (led_state_t *)arg;
+    const led_pattern_def_t *pattern;
+    const led_step_t *step;
+    uint32_t duty;
 
+    if (led->requested != led->active)
+    {
+        led->active = led->requested;
+        led->step = 0;
+        leds_power(led);
+    }
+    pattern = &led_patterns[led->active];
+    if (led->step >= pattern->count)
+    {
+        if (pattern->loop == true)
+        {
+            led->step = 0;
+        }
+        else
+        {
+            // one shot done, back to the base pattern, a static pattern just stays
+            if (led->active != led->base)
+            {
+                led->requested = led->base;
+                leds_step(arg);
+            }
+            return;
+        }
+    }
+
+    step = &pattern->steps[led->step++];
+    duty = (uint32_t)LEDS_DUTY_MAX * step->level / 100;
+    led->fade_end_ms = (uint32_t)(esp_timer_get_time() / 1000) + step->fade_ms;
+    if (step->fade_ms > 0)
+        ledc_set_fade_time_and_start(LEDS_MODE, led->channel, duty, step->fade_ms, LEDC_FADE_NO_WAIT);
+    else
+        ledc_set_duty_and_update(LEDS_MODE, led->channel, duty, 0);
+    esp_timer_start_once(led->timer, (uint64_t)(step->fade_ms + step->hold_ms) * 1000);
+}
+
+// the LED timer callbacks all run in the esp_timer task, leds_lit needs no lock
+static void leds_power(const led_state_t *led)
+{
+    uint8_t bit = 1 << (led - leds);
+    uint8_t lit = (led->active != LED_PATTERN_OFF) ? (leds_lit | bit) : (leds_lit & ~bit);
+
+    if ((leds_lit == 0) && (lit != 0))
+        power_lock(POWER_LOCK_LEDS);
+    else if ((leds_lit != 0) && (lit == 0))
+        power_unlock(POWER_LOCK_LEDS);
+    leds_lit = lit;
+}
 /***********************************************************************************************************************
 * End of file
 ***********************************************************************************************************************/
@@ -16,21 +16,53 @@ extern "C" {
 /****************************************************************************/
 /***        Type Definitions                                              ***/
 /****************************************************************************/
+typedef enum
+{
+	LED_RED,
+	LED_GREEN,
+	LED_BLUE,
+	LED_COUNT
+} led_id_t;
+
+typedef enum
+{
+	LED_PATTERN_OFF,
+	LED_PATTERN_ON,
+	LED_PATTERN_BREATHE,
+	LED_PATTERN_BLINK_1, /* blink codes: n short blinks, then a pause */
+	LED_PATTERN_BLINK_2,
+	LED_PATTERN_BLINK_3,
+	LED_PATTERN_FLASH,   /* one shot, the LED goes back to its pattern afterwards */
+	LED_PATTERN_COUNT
+} led_pattern_t;
+
+/**
+ * One pattern step: fade to level, then hold it.
+ */
+typedef struct
+{
+	uint8_t level; /* % */
+	uint16_t fade_ms;
+	uint16_t hold_ms;
+} led_step_t;
 
 /****************************************************************************/
 /***         Exported global functions                                     ***/
 /****************************************************************************/
 void leds_gpio_init(void);
 
+void leds_set_pattern(led_id_t led, led_pattern_t pattern);
 
-void led_red(bool _status);
+void leds_flash(led_id_t led);
 
+void leds_show_status(void);
 
-void led_green(bool _status);
+void led_red(bool _status);
 
+void led_green(bool _status);
 
 void led_blue(bool _status);
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
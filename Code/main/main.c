@@ -27,12 +27,21 @@
 
 #include "../components/json_parser/json_parser.h"
 #include "../components/esp32_wifi_manager/src/wifi_manager.h"
+#include "../components/esp32_wifi_manager/src/http_app.h"
 #include "../components/peripheral/user_timer.h"
 
 #include "../user_driver/user_buttons.h"
 #include "../user_driver/user_leds.h"
-#include "../user_driver/user_vibration_motor.h"
+#include "../user_driver/haptic.h"
 #include "../user_driver/LSM6DSL_ACC_GYRO_Driver.h"
+#include "../system/task_profiler.h"
+#include "../system/task_registry.h"
+#include "../system/mem_report.h"
+#include "../system/trace.h"
+#include "../system/power.h"
+#include "../system/standby.h"
+#include "../system/prov_store.h"
+#include "../system/metrics.h"
 /* Can use project configuration menu (idf.py menuconfig) to choose the GPIO to blink,
    or you can edit the following line and set a number here.
 */
@@ -85,37 +94,184 @@ void cb_connection_ok(void *pvParameter)
 
     APP_LOGI("I have a connection and my IP is %s!", str_ip);
     deive_data.wifi_status = true;
+    power_wifi_connected();
+    standby_save_wifi();
+    leds_show_status();
     mqtt_task_start();
 }
 
+void cb_connection_lost(void *pvParameter)
+{
+    APP_LOGI("wifi connection lost");
+    metrics_add(METRIC_WIFI_DISCONNECTS, 1);
+    deive_data.wifi_status = false;
+    leds_show_status();
+}
+
+/* GET /trace.json, one JSON object per line, the same chunks as the mqtt "trace" operation */
+static esp_err_t http_get_trace(httpd_req_t *req)
+{
+    uint32_t cursor = trace_oldest();
+    char *message_packet = (char *)mem_pool_take(&json_report_pool, 100 / portTICK_PERIOD_MS);
+
+    if (message_packet == NULL)
+    {
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+    httpd_resp_set_type(req, "application/x-ndjson");
+    while (json_packet_trace(message_packet, JSON_PROFILE_MESSAGE_LEN - 1, &cursor))
+    {
+        strcat(message_packet, "\n");
+        httpd_resp_send_chunk(req, message_packet, strlen(message_packet));
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    mem_pool_give(&json_report_pool, message_packet);
+    return ESP_OK;
+}
+
+/* GET /metrics.json, the periodic metrics report on demand, it does not move the reporting interval */
+static esp_err_t http_get_metrics(httpd_req_t *req)
+{
+    char *message_packet = (char *)mem_pool_take(&json_msg_pool, 100 / portTICK_PERIOD_MS);
+
+    if ((message_packet != NULL) && json_packet_metrics(message_packet, JSON_MESSAGE_LEN))
+    {
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_send(req, message_packet, strlen(message_packet));
+    }
+    else
+    {
+        httpd_resp_send_500(req);
+    }
+    mem_pool_give(&json_msg_pool, message_packet);
+    return ESP_OK;
+}
+
+/* wifi manager GET hook: /profile.json is the same report as the mqtt "profile" operation */
+esp_err_t http_get_handler(httpd_req_t *req)
+{
+    if (strcmp(req->uri, "/trace.json") == 0)
+    {
+        return http_get_trace(req);
+    }
+    if (strcmp(req->uri, "/metrics.json") == 0)
+    {
+        return http_get_metrics(req);
+    }
+    if (strcmp(req->uri, "/profile.json") != 0)
+    {
+        httpd_resp_send_404(req);
+        return ESP_OK;
+    }
+    char *message_packet = (char *)mem_pool_take(&json_report_pool, 100 / portTICK_PERIOD_MS);
+    if ((message_packet != NULL) && json_packet_profile(message_packet, JSON_PROFILE_MESSAGE_LEN))
+    {
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_send(req, message_packet, strlen(message_packet));
+    }
+    else
+    {
+        httpd_resp_send_500(req);
+    }
+    mem_pool_give(&json_report_pool, message_packet);
+    return ESP_OK;
+}
+
+/* wifi manager POST hook: POST /prov writes the device identity, see json_parse_provision(). Open on an empty store,
+ * afterwards only for PROV_UNLOCK_S after the service chord. */
+esp_err_t http_post_handler(httpd_req_t *req)
+{
+    if (strcmp(req->uri, "/prov") != 0)
+    {
+        httpd_resp_send_404(req);
+        return ESP_OK;
+    }
+    if (prov_store_writable() == false)
+    {
+        httpd_resp_send_err(req, HTTPD_403_FORBIDDEN, "provisioning locked");
+        return ESP_OK;
+    }
+    if ((req->content_len == 0) || (req->content_len > PROV_BODY_MAX))
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "bad length");
+        return ESP_OK;
+    }
+    char *body = malloc(req->content_len);
+    size_t received = 0;
+    while ((body != NULL) && (received < req->content_len))
+    {
+        int ret = httpd_req_recv(req, body + received, req->content_len - received);
+        if (ret <= 0)
+            break;
+        received += ret;
+    }
+    if ((body == NULL) || (received < req->content_len) || !json_parse_provision(body, received))
+    {
+        free(body);
+        httpd_resp_send_500(req);
+        return ESP_OK;
+    }
+    free(body);
+    httpd_resp_sendstr(req, "provisioned, restarting");
+    /* the mapped store was invalidated, restart onto the new identity */
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+    esp_restart();
+    return ESP_OK;
+}
+
 void app_main(void)
 {
+    app_log_init();
+    power_init();
     APP_LOGI("--- APP_MAIN: Smart Hammer Update 14/10/2021......");
     APP_LOGI("--- APP_MAIN: Free memory: %d bytes", esp_get_free_heap_size());
     //Initialize NVS
+    mem_report_heap_begin("nvs");
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND)
     {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
+    mem_report_heap_end();
+    mem_report_heap_begin("spiffs");
     flash_file_init();
+    mem_report_heap_end();
     ESP_ERROR_CHECK(ret);
+    prov_store_init();
     //Initialize values
     deive_data.sensor.vibration_level = 50; //setting values vibration_level is 50 percent
     deive_data.sensor.hammer_detect = 0;
-    deive_data.sensor.vibration_active = false;
+    standby_init(); // a wake from standby restores the strike that was not published
     // load save param
-    UserTimer_Init();
+    task_profiler_init();
+    json_parser_init();
+    mqtt_task_init();
+    task_registry_report();
 
     buttons_gpio_init();
+    mem_report_heap_begin("leds");
     leds_gpio_init();
-    vibration_init();
-    /* start the wifi manager */
+    mem_report_heap_end();
+    mem_report_heap_begin("haptic");
+    haptic_init();
+    mem_report_heap_end();
+    /* start the wifi manager, after standby it connects to the last access point without scanning */
+    uint8_t bssid[6];
+    uint8_t channel;
+    if (standby_wifi_hint(bssid, &channel))
+        wifi_manager_set_sta_hint(bssid, channel);
+    mem_report_heap_begin("wifi_manager");
     wifi_manager_start();
+    mem_report_heap_end();
     /* register a callback as an example to how you can integrate your code with the wifi manager */
     wifi_manager_set_callback(WM_EVENT_STA_GOT_IP, &cb_connection_ok);
+    wifi_manager_set_callback(WM_EVENT_STA_DISCONNECTED, &cb_connection_lost);
+    http_app_set_handler_hook(HTTP_GET, &http_get_handler);
+    http_app_set_handler_hook(HTTP_POST, &http_post_handler);
 
     plan_task();
     imu_read_task();
+    mem_report_log();
 }
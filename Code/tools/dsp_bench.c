@@ -0,0 +1,173 @@
+/*
+ * dsp_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ *
+ * Host benchmark of the dsp component, the stages imu_task runs per FIFO batch, no IDF needed:
+ *
+ *     cc -O2 -o dsp_bench dsp_bench.c ../components/dsp/dsp_filter.c ../components/dsp/dsp_orientation.c -lm
+ *     ./dsp_bench
+ *
+ * Cycles come from the time stamp counter on x86, elsewhere only ns are reported. The device logs its own
+ * cycles/sample at debug level, this is the number to compare a change against before flashing.
+ */
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC (1)
+#endif
+#include "../components/dsp/dsp_filter.h"
+#include "../components/dsp/dsp_orientation.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+/* the imu_read_task settings */
+#define BENCH_SAMPLE_RATE_HZ (416)
+#define BENCH_BATCH (64) /* IMU_BATCH_MAX_SAMPLES */
+#define BENCH_HP_CUTOFF_HZ (10.0f)
+#define BENCH_ENV_ATTACK_SHIFT (1)
+#define BENCH_ENV_RELEASE_SHIFT (6)
+#define BENCH_NOISE_FLOOR_SHIFT (10)
+#define BENCH_NOISE_FLOOR_RATIO_Q4 (8 << 4)
+#define BENCH_HIT_MIN_MG (3000)
+#define BENCH_MAHONY_KP (1.0f)
+#define BENCH_MAHONY_KI (0.05f)
+#define BENCH_MDPS_TO_RAD (3.14159265f / 180000.0f)
+
+#define BENCH_SAMPLES (BENCH_SAMPLE_RATE_HZ * 60) /* one minute of hammer use */
+#define BENCH_ROUNDS (50)
+/***********************************************************************************************************************
+* Typedef definitions
+***********************************************************************************************************************/
+typedef struct
+{
+    double ns;
+    uint64_t cycles;
+} bench_time_t;
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static int32_t acc_z[BENCH_SAMPLES]; /* [mg] */
+static int32_t acc_xy[BENCH_SAMPLES][2];
+static int32_t gyro[BENCH_SAMPLES][3]; /* [mdps] */
+static int32_t dsp_z[BENCH_BATCH];
+static int32_t dsp_env[BENCH_BATCH];
+static int32_t dsp_thr[BENCH_BATCH];
+static volatile int32_t sink;
+
+static void bench_signal(void);
+static void bench_start(bench_time_t *t);
+static void bench_stop(bench_time_t *t);
+static void bench_report(const char *name, const bench_time_t *t, uint32_t samples);
+
+int main(void)
+{
+    dsp_biquad_q14_t hp;
+    dsp_envelope_t env;
+    dsp_noise_floor_t noise;
+    dsp_mahony_t orientation;
+    bench_time_t t;
+    uint32_t n;
+    uint16_t len;
+
+    bench_signal();
+    dsp_biquad_q14_highpass_init(&hp, BENCH_HP_CUTOFF_HZ, BENCH_SAMPLE_RATE_HZ, 0.707f);
+    dsp_envelope_init(&env, BENCH_ENV_ATTACK_SHIFT, BENCH_ENV_RELEASE_SHIFT);
+    dsp_noise_floor_init(&noise, 0, BENCH_NOISE_FLOOR_SHIFT, BENCH_NOISE_FLOOR_RATIO_Q4, BENCH_HIT_MIN_MG);
+    dsp_biquad_q14_reset(&hp, acc_z[0]);
+
+    bench_start(&t);
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (n = 0; n < BENCH_SAMPLES; n += len)
+        {
+            len = (BENCH_SAMPLES - n < BENCH_BATCH) ? BENCH_SAMPLES - n : BENCH_BATCH;
+            dsp_biquad_q14_process(&hp, &acc_z[n], dsp_z, len);
+            dsp_envelope_process(&env, dsp_z, dsp_env, len);
+            dsp_noise_floor_process(&noise, dsp_env, dsp_thr, len);
+            sink += dsp_thr[len - 1];
+        }
+    }
+    bench_stop(&t);
+    bench_report("front-end (high-pass, envelope, noise floor)", &t, BENCH_SAMPLES * BENCH_ROUNDS);
+    printf("noise floor %d mg\n", (int)(noise.floor >> DSP_ENV_Q));
+
+    // the same conversions as imu_orientation_update(), the gate sees both the still and the swinging hammer
+    dsp_mahony_init(&orientation, BENCH_SAMPLE_RATE_HZ, BENCH_MAHONY_KP, BENCH_MAHONY_KI);
+    bench_start(&t);
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (n = 0; n < BENCH_SAMPLES; n++)
+        {
+            dsp_mahony_update(&orientation,
+                              gyro[n][0] * BENCH_MDPS_TO_RAD, gyro[n][1] * BENCH_MDPS_TO_RAD, gyro[n][2] * BENCH_MDPS_TO_RAD,
+                              acc_xy[n][0] / 1000.0f, acc_xy[n][1] / 1000.0f, acc_z[n] / 1000.0f);
+        }
+    }
+    bench_stop(&t);
+    bench_report("orientation (Mahony update)", &t, BENCH_SAMPLES * BENCH_ROUNDS);
+    printf("q = %.3f %.3f %.3f %.3f\n", orientation.q.w, orientation.q.x, orientation.q.y, orientation.q.z);
+    return 0;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/* gravity, sensor noise and a 300 ms swing ending in a strike every 2 s, fixed seed so runs compare */
+static void bench_signal(void)
+{
+    srand(1);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        uint32_t since_strike = i % (2 * BENCH_SAMPLE_RATE_HZ);
+        uint32_t to_strike = 2 * BENCH_SAMPLE_RATE_HZ - since_strike;
+
+        gyro[i][0] = (rand() % 2001) - 1000;
+        gyro[i][1] = (to_strike < BENCH_SAMPLE_RATE_HZ * 3 / 10) ? 600000 : (rand() % 2001) - 1000;
+        gyro[i][2] = (rand() % 2001) - 1000;
+        acc_xy[i][0] = (to_strike < BENCH_SAMPLE_RATE_HZ * 3 / 10) ? 2500 : (rand() % 41) - 20;
+        acc_xy[i][1] = (rand() % 41) - 20;
+        acc_z[i] = 1000 + (rand() % 41) - 20;
+        if (since_strike < 20)
+            acc_z[i] += ((since_strike & 1) ? -1 : 1) * (12000 >> (since_strike / 4));
+    }
+}
+
+static void bench_start(bench_time_t *t)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    t->ns = ts.tv_sec * 1e9 + ts.tv_nsec;
+#ifdef BENCH_HAS_TSC
+    t->cycles = __rdtsc();
+#endif
+}
+
+static void bench_stop(bench_time_t *t)
+{
+    struct timespec ts;
+
+#ifdef BENCH_HAS_TSC
+    t->cycles = __rdtsc() - t->cycles;
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    t->ns = ts.tv_sec * 1e9 + ts.tv_nsec - t->ns;
+}
+
+static void bench_report(const char *name, const bench_time_t *t, uint32_t samples)
+{
+#ifdef BENCH_HAS_TSC
+    printf("%-48s %6.1f ns/sample %6.1f cycles/sample\n", name, t->ns / samples, (double)t->cycles / samples);
+#else
+    printf("%-48s %6.1f ns/sample\n", name, t->ns / samples);
+#endif
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,140 @@
+/*
+ * gesture_replay.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ *
+ * Host replay of a recorded user button edge log through the device grammar (button_grammar.h), no IDF needed:
+ *
+ *     cc -O2 -o gesture_replay gesture_replay.c ../components/gesture/gesture.c
+ *     ./gesture_replay edges.log [hold=500] [long=500] [reverse=500]
+ *
+ * One debounced edge per line, "<ms> press" or "<ms> release" (1 / 0 work too), '#' starts a comment. Every gesture
+ * is printed with the time the device would emit it, timeouts at their deadline like gesture_poll() stamps them.
+ */
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../components/user_driver/button_grammar.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define REPLAY_LINE_MAX (128)
+#define REPLAY_TAIL_MS (60000) // polled this long past the last edge so the open windows expire
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static const char *const gesture_names[BUTTON_GESTURE_COUNT] = {"none", "click", "buttonDown", "buttonUp", "reverse"};
+
+static gesture_engine_t engine;
+static uint32_t emitted;
+
+static void replay_poll(uint32_t now_ms);
+static void replay_print(uint8_t gesture);
+static int replay_window(const char *arg);
+
+int main(int argc, char **argv)
+{
+    char line[REPLAY_LINE_MAX];
+    char edge[16];
+    unsigned long ms;
+    uint32_t last_ms = 0;
+    uint32_t line_no = 0;
+    FILE *file;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s edges.log [hold=ms] [long=ms] [reverse=ms]\n", argv[0]);
+        return 2;
+    }
+    gesture_init(&engine, &button_grammar);
+    for (int i = 2; i < argc; i++)
+    {
+        if (replay_window(argv[i]) != 0)
+            return 2;
+    }
+    file = (strcmp(argv[1], "-") == 0) ? stdin : fopen(argv[1], "r");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return 2;
+    }
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        bool pressed;
+
+        line_no++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        if (sscanf(line, "%lu %15s", &ms, edge) != 2)
+            continue;
+        if ((strcmp(edge, "press") == 0) || (strcmp(edge, "1") == 0))
+            pressed = true;
+        else if ((strcmp(edge, "release") == 0) || (strcmp(edge, "0") == 0))
+            pressed = false;
+        else
+        {
+            fprintf(stderr, "line %u: unknown edge \"%s\"\n", line_no, edge);
+            continue;
+        }
+        if (ms < last_ms)
+            fprintf(stderr, "line %u: %lu ms goes back in time\n", line_no, ms);
+        // the device polls between edges, every window that ran out before this edge expires first
+        replay_poll(ms);
+        replay_print(gesture_feed(&engine, pressed ? GESTURE_INPUT_PRESS : GESTURE_INPUT_RELEASE, ms));
+        last_ms = ms;
+    }
+    if (file != stdin)
+        fclose(file);
+    replay_poll(last_ms + REPLAY_TAIL_MS);
+    printf("%u gestures from %u lines, state %u at the end\n", emitted, line_no, engine.state);
+    return 0;
+}
+/***********************************************************************************************************************
+* Static Functions
+***********************************************************************************************************************/
+/* one timeout can lead into a state with its own, poll until nothing moves */
+static void replay_poll(uint32_t now_ms)
+{
+    uint8_t state;
+    uint32_t entered_ms;
+
+    do
+    {
+        state = engine.state;
+        entered_ms = engine.entered_ms;
+        replay_print(gesture_poll(&engine, now_ms));
+    } while ((engine.state != state) || (engine.entered_ms != entered_ms));
+}
+
+/* a gesture is emitted on entering a state, at the edge or at the timeout's deadline */
+static void replay_print(uint8_t gesture)
+{
+    if (gesture == GESTURE_NONE)
+        return;
+    printf("%8u ms  %s\n", engine.entered_ms, (gesture < BUTTON_GESTURE_COUNT) ? gesture_names[gesture] : "?");
+    emitted++;
+}
+
+/* name=ms, the same names as button_gestures_set_window() */
+static int replay_window(const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+
+    for (uint8_t i = 0; (eq != NULL) && (i < BUTTON_WINDOW_COUNT); i++)
+    {
+        if ((strlen(button_window_names[i]) == (size_t)(eq - arg)) &&
+            (strncmp(arg, button_window_names[i], eq - arg) == 0))
+        {
+            gesture_set_window(&engine, i, (uint16_t)atoi(eq + 1));
+            return 0;
+        }
+    }
+    fprintf(stderr, "unknown window \"%s\", hold=ms, long=ms or reverse=ms\n", arg);
+    return 1;
+}
+/***********************************************************************************************************************
+* End of file
+***********************************************************************************************************************/
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""Strike classifier export: trained decision tree -> firmware tables and model blob.
+
+Input is the trainer's export, one JSON file:
+
+    {"features": ["peak_mg", ...],          # strike_feature_t order, checked
+     "classes": ["solid", "glancing", ...],  # value columns of the tree
+     "tree": {"children_left": [...], "children_right": [...],
+              "feature": [...], "threshold": [...], "value": [[...], ...]},
+     "vectors": [{"features": [...], "label": "solid"}, ...]}
+
+"tree" holds the arrays of a scikit-learn DecisionTreeClassifier (clf.tree_),
+export_sklearn() below writes the file from a fitted classifier. "vectors" are
+held-out strikes with the label the trainer predicted for them, the device
+runs them at load and refuses a model that does not reproduce them.
+
+    python3 strike_model_export.py model.json --c ../components/user_driver/strike_model.c
+    python3 strike_model_export.py model.json --blob strike.mdl   # copy to /spiffs/strike.mdl
+
+strike_model_builtin.json is the hand-tuned tree built into the firmware,
+exporting a trained model replaces it. strike_model_host.c checks a blob with
+the device parser on the host.
+"""
+import argparse
+import json
+import math
+import struct
+import sys
+import zlib
+
+# strike_feature_t in components/dsp/strike_classifier.h, same order
+FEATURES = [
+    "peak_mg",
+    "ringdown_ms",
+    "freefall_ms",
+    "peak_hz",
+    "energy_db",
+    "band0_pct",
+    "band1_pct",
+    "band2_pct",
+    "band3_pct",
+    "swing_deg",
+    "rate_dps",
+]
+
+# strike_label_t, same order
+LABELS = ["unknown", "solid", "glancing", "miss", "drop"]
+
+# STRIKE_FEAT_* names for the C tables
+FEATURE_ENUM = ["STRIKE_FEAT_" + name.upper() for name in FEATURES]
+LABEL_ENUM = ["STRIKE_LABEL_" + name.upper() for name in LABELS]
+
+MODEL_MAGIC = 0x4B525453  # "STRK"
+MODEL_VERSION = 1
+MODEL_MAX_BYTES = 4096  # STRIKE_MODEL_MAX_BYTES, a blob must stay below it
+NODE_LEAF = -1
+INT16_MIN, INT16_MAX = -32768, 32767
+
+C_BEGIN = "/* strike_model_export.py begin"
+C_END = "/* strike_model_export.py end */"
+
+
+def export_sklearn(clf, X, path, feature_names=FEATURES):
+    """write the trainer export of a fitted DecisionTreeClassifier, X are the reference strikes"""
+    tree = clf.tree_
+    model = {
+        "features": list(feature_names),
+        "classes": [str(c) for c in clf.classes_],
+        "tree": {
+            "children_left": tree.children_left.tolist(),
+            "children_right": tree.children_right.tolist(),
+            "feature": tree.feature.tolist(),
+            "threshold": tree.threshold.tolist(),
+            "value": [v[0] for v in tree.value.tolist()],
+        },
+        "vectors": [{"features": [int(v) for v in x], "label": str(label)} for x, label in zip(X, clf.predict(X))],
+    }
+    with open(path, "w") as f:
+        json.dump(model, f, indent=1)
+
+
+def convert(model):
+    """trainer export -> device nodes [(feature, threshold, left, right)] and vectors [(features, label)]"""
+    if model["features"] != FEATURES:
+        raise ValueError("feature order differs from strike_feature_t: %s" % model["features"])
+    classes = [LABELS.index(c) for c in model["classes"]]
+    tree = model["tree"]
+    count = len(tree["feature"])
+    if count > 255:
+        raise ValueError("%d nodes, child indices are 8 bit" % count)
+    nodes = []
+    for i in range(count):
+        left, right = tree["children_left"][i], tree["children_right"][i]
+        if left < 0:
+            value = tree["value"][i]
+            nodes.append((NODE_LEAF, 0, classes[value.index(max(value))], 0))
+            continue
+        if not (i < left < count and i < right < count):
+            raise ValueError("node %d: children must point forward" % i)
+        # features are integers, x <= 12.5 is x <= 12
+        threshold = max(INT16_MIN, min(INT16_MAX, math.floor(tree["threshold"][i])))
+        nodes.append((tree["feature"][i], threshold, left, right))
+    vectors = []
+    for vector in model["vectors"]:
+        features = vector["features"]
+        if len(features) != len(FEATURES) or any(not INT16_MIN <= v <= INT16_MAX for v in features):
+            raise ValueError("reference vector out of range: %s" % features)
+        vectors.append((features, LABELS.index(vector["label"])))
+    return nodes, vectors
+
+
+def classify(nodes, features):
+    """strike_classify() on the host"""
+    node = nodes[0]
+    for _ in range(len(nodes)):
+        feature, threshold, left, right = node
+        if feature == NODE_LEAF:
+            return left
+        node = nodes[left] if features[feature] <= threshold else nodes[right]
+    return 0
+
+
+def blob(nodes, vectors):
+    """strike_model_header_t | strike_node_t[] | strike_vector_t[], little endian"""
+    body = b"".join(struct.pack("<hbBBB", threshold, feature, left, right, 0)
+                    for feature, threshold, left, right in nodes)
+    body += b"".join(struct.pack("<%dhBB" % len(FEATURES), *features, label, 0) for features, label in vectors)
+    header = struct.pack("<IBBHHHI", MODEL_MAGIC, MODEL_VERSION, len(FEATURES), len(nodes), len(vectors), 0,
+                         zlib.crc32(body) & 0xFFFFFFFF)
+    data = header + body
+    if len(data) >= MODEL_MAX_BYTES:
+        raise ValueError("blob %d bytes, the device reads less than %d" % (len(data), MODEL_MAX_BYTES))
+    return data
+
+
+def c_tables(nodes, vectors, source):
+    lines = [C_BEGIN + ", from %s */" % source, "static const strike_node_t default_nodes[] = {"]
+    for i, (feature, threshold, left, right) in enumerate(nodes):
+        if feature == NODE_LEAF:
+            lines.append("    /* %d */ STRIKE_LEAF(%s)," % (i, LABEL_ENUM[left]))
+        else:
+            lines.append("    /* %d */ STRIKE_NODE(%s, %d, %d, %d)," % (i, FEATURE_ENUM[feature], threshold, left, right))
+    lines.append("};")
+    lines.append("")
+    lines.append("/* reference vectors: peak, ringdown, freefall, peak Hz, dB, band % x4, swing, rate -> label */")
+    lines.append("static const strike_vector_t default_vectors[] = {")
+    for features, label in vectors:
+        lines.append("    {{%s}, %s}," % (", ".join(str(v) for v in features), LABEL_ENUM[label]))
+    lines.append("};")
+    lines.append(C_END)
+    return "\n".join(lines)
+
+
+def write_c(path, tables):
+    with open(path) as f:
+        source = f.read()
+    begin = source.find(C_BEGIN)
+    end = source.find(C_END)
+    if begin < 0 or end < begin:
+        raise ValueError("%s has no export markers" % path)
+    with open(path, "w") as f:
+        f.write(source[:begin] + tables + source[end + len(C_END):])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("model", help="trainer export, JSON")
+    parser.add_argument("--c", help="strike_model.c to update between the export markers")
+    parser.add_argument("--blob", help="model blob to write, /spiffs/strike.mdl on the device")
+    args = parser.parse_args()
+
+    with open(args.model) as f:
+        nodes, vectors = convert(json.load(f))
+    mismatch = [i for i, (features, label) in enumerate(vectors) if classify(nodes, features) != label]
+    if mismatch:
+        sys.exit("reference vectors %s do not reproduce the trainer's labels" % mismatch)
+    print("%d nodes, %d reference vectors match" % (len(nodes), len(vectors)))
+    if args.c:
+        write_c(args.c, c_tables(nodes, vectors, "tools/" + args.model.split("/")[-1]))
+        print("wrote", args.c)
+    if args.blob:
+        data = blob(nodes, vectors)
+        with open(args.blob, "wb") as f:
+            f.write(data)
+        print("wrote %s, %d bytes" % (args.blob, len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+/*
+ * strike_model_host.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: ductu
+ *
+ * Host check of a model blob from strike_model_export.py with the device parser and tree walk, no IDF needed:
+ *
+ *     cc -O2 -o strike_model_host strike_model_host.c ../components/dsp/strike_classifier.c
+ *     ./strike_model_host strike.mdl
+ */
+/***********************************************************************************************************************
+* Includes <System Includes>
+***********************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../components/dsp/strike_classifier.h"
+/***********************************************************************************************************************
+* Macro definitions
+***********************************************************************************************************************/
+#define HOST_MODEL_MAX_BYTES (4096) /* STRIKE_MODEL_MAX_BYTES */
+#define HOST_ROUNDS (100000)
+/***********************************************************************************************************************
+* Private global variables and functions
+***********************************************************************************************************************/
+static uint32_t blob[HOST_MODEL_MAX_BYTES / sizeof(uint32_t)]; /* word aligned like the device buffer */
+
+static double host_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    strike_model_t model;
+    FILE *file;
+    size_t len;
+    uint16_t i;
+    uint16_t mismatch;
+    volatile uint32_t sink = 0;
+    double start;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s strike.mdl\n", argv[0]);
+        return 2;
+    }
+    file = fopen(argv[1], "rb");
+    if (file == NULL)
+    {
+        perror(argv[1]);
+        return 2;
+    }
+    len = fread(blob, 1, sizeof(blob), file);
+    fclose(file);
+    // the same refusal as strike_model_read_file()
+    if ((len == sizeof(blob)) || (strike_model_parse((const uint8_t *)blob, len, &model) == false))
+    {
+        fprintf(stderr, "%s: rejected by strike_model_parse\n", argv[1]);
+        return 1;
+    }
+    mismatch = strike_model_verify(&model);
+    for (i = 0; i < model.vector_count; i++)
+    {
+        strike_label_t label = strike_classify(&model, model.vectors[i].feature);
+
+        printf("vector %2u: %-8s expected %-8s%s\n", i, strike_label_name(label),
+               strike_label_name((strike_label_t)model.vectors[i].label),
+               (label == model.vectors[i].label) ? "" : "  MISMATCH");
+    }
+    printf("%u nodes, %u/%u reference labels match\n", model.node_count, model.vector_count - mismatch,
+           model.vector_count);
+    if (model.vector_count > 0)
+    {
+        start = host_now_ns();
+        for (uint32_t round = 0; round < HOST_ROUNDS; round++)
+        {
+            for (i = 0; i < model.vector_count; i++)
+                sink += strike_classify(&model, model.vectors[i].feature);
+        }
+        printf("%.1f ns/strike on the host\n", (host_now_ns() - start) / ((double)HOST_ROUNDS * model.vector_count));
+    }
+    return (mismatch == 0) ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Per-stage latency histograms from latency trace dumps.
+
+Input is one JSON object per line, as served by GET /trace.json or as the
+payloads published after the mqtt "trace" operation:
+
+    {"<mac>": {"trace": [[id, stage, core, t_us], ...]}}
+
+    curl http://<device>/trace.json > dump.ndjson
+    python3 trace_latency.py dump.ndjson [more dumps...]
+"""
+import json
+import sys
+from collections import defaultdict
+
+# trace_stage_t in components/system/trace.h, same order
+STAGES = [
+    "strike_impact",
+    "strike_trigger",
+    "strike_report",
+    "button_gesture",
+    "mqtt_pickup",
+    "mqtt_serialized",
+    "mqtt_published",
+    "mqtt_acked",
+]
+
+# log2 bins in microseconds: <64us ... >=4s
+BIN_EDGES_US = [64 << i for i in range(17)]
+
+
+def load(paths):
+    records = set()  # overlapping dumps repeat records
+    for path in paths:
+        with open(path) as f:
+            for line in f:
+                line = line.strip()
+                if not line:
+                    continue
+                for device in json.loads(line).values():
+                    for rec in device.get("trace", []):
+                        records.add(tuple(rec))
+    return records
+
+
+def events(records):
+    """id -> {stage: t_us}; ids wrap at 65535 so a reused id keeps the latest hop per stage"""
+    by_id = defaultdict(dict)
+    for event_id, stage, _core, t_us in sorted(records, key=lambda r: r[3]):
+        by_id[event_id][stage] = t_us
+    return by_id
+
+
+def hops(by_id):
+    latency = defaultdict(list)
+    for stages in by_id.values():
+        ordered = sorted(stages)
+        for a, b in zip(ordered, ordered[1:]):
+            latency[(a, b)].append((stages[b] - stages[a]) & 0xFFFFFFFF)
+        if len(ordered) > 2:  # end to end
+            latency[(ordered[0], ordered[-1])].append((stages[ordered[-1]] - stages[ordered[0]]) & 0xFFFFFFFF)
+    return latency
+
+
+def histogram(values):
+    counts = [0] * (len(BIN_EDGES_US) + 1)
+    for v in values:
+        i = 0
+        while i < len(BIN_EDGES_US) and v >= BIN_EDGES_US[i]:
+            i += 1
+        counts[i] += 1
+    return counts
+
+
+def fmt_us(us):
+    return "%.1f ms" % (us / 1000.0) if us >= 1000 else "%d us" % us
+
+
+def main(paths):
+    latency = hops(events(load(paths)))
+    if not latency:
+        print("no complete events in the dump")
+        return 1
+    # worst median first, the dominant delay is on top
+    for (a, b), values in sorted(latency.items(), key=lambda kv: -sorted(kv[1])[len(kv[1]) // 2]):
+        values.sort()
+        n = len(values)
+        print("%s -> %s  n=%d  p50 %s  p95 %s  max %s" % (
+            STAGES[a] if a < len(STAGES) else a, STAGES[b] if b < len(STAGES) else b, n,
+            fmt_us(values[n // 2]), fmt_us(values[min(n - 1, n * 95 // 100)]), fmt_us(values[-1])))
+        counts = histogram(values)
+        peak = max(counts)
+        lower = 0
+        for edge, count in zip(BIN_EDGES_US + [None], counts):
+            if count:
+                label = "%9s - %-9s" % (fmt_us(lower), fmt_us(edge) if edge else "")
+                print("    %s %6d %s" % (label, count, "#" * max(1, count * 40 // peak)))
+            lower = edge or lower
+        print()
+    return 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(2)
+    sys.exit(main(sys.argv[1:]))